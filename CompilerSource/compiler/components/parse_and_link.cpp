@@ -40,83 +40,174 @@ using namespace std;
 #include "compiler/compile_common.h"
 #include "compiler/event_reader/event_parser.h"
 
-#include <math.h> //log2 to calculate passes.
+#include <algorithm>
+#include "settings.h"
 
 #include <languages/lang_CPP.h>
 
 #include "compiler/compile_includes.h"
+#include "general/parallel.h"
 
 extern string tostring(int);
+extern int global_script_argument_count;
 
-int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
+namespace
 {
-  //First we just parse the scripts to add semicolons and collect variable names
-  for (int i = 0; i < es->scriptCount; i++)
+  /// One piece of code to check and parse, along with where it came from for error reports.
+  struct parse_job
   {
-    int a = syncheck::syntacheck(es->scripts[i].code);
-    if (a != -1) {
-      user << "Syntax error in script `" << es->scripts[i].name << "'\n" << syncheck::syerr << flushl;
-      return E_ERROR_SYNTAX;
-    }
-    // Keep a parsed record of this script
-    scr_lookup[es->scripts[i].name] = scripts[i] = new parsed_script;
-    parser_main(es->scripts[i].code,&scripts[i]->pev);
-    edbg << "Parsed `" << es->scripts[i].name << "': " << scripts[i]->obj.locals.size() << " locals, " << scripts[i]->obj.globals.size() << " globals" << flushl;
+    enum kind { SCRIPT, EVENT, ROOM, INSTANCE } what;
+    int a, b, c;            // Script; object, main event and sub event; room; room and instance
+    string code;            // The code as written
+    string parse_code;      // The code as handed to the parser, which sometimes wraps it
+    parsed_event *pev;
+    parsed_script *script;  // For scripts, which may need a second, global parse
+    int error_at;           // Result of the syntax check
+    string error;
+    parse_job(kind k, int x, int y, int z, string cd, string pcd, parsed_event *pe, parsed_script *scr = NULL):
+      what(k), a(x), b(y), c(z), code(cd), parse_code(pcd), pev(pe), script(scr), error_at(-1), error() {}
+  };
+  
+  /// All the parsing to be done, grouped by the parsed_object each job collects variables into.
+  /// Each group is handled by one thread, in the order the jobs were added, so every object sees
+  /// its code in the same order no matter how many threads there are.
+  struct parse_stage
+  {
+    vector<parse_job> jobs;
+    vector< vector<size_t> > groups;
+    map<parsed_object*, size_t> group_of;
     
-    // If the script accesses variables from outside its scope implicitly
-    if (scripts[i]->obj.locals.size() or scripts[i]->obj.globallocals.size()) {
-      parsed_object temporary_object = *scripts[i]->pev.myObj;
-      scripts[i]->pev_global = new parsed_event(&temporary_object);
-      parser_main(string("with (self) {\n") + es->scripts[i].code + "\n/* */}",scripts[i]->pev_global);
-      scripts[i]->pev_global->myObj = NULL;
+    void add(const parse_job &job)
+    {
+      parsed_object *const target = job.pev->myObj;
+      map<parsed_object*, size_t>::iterator g = group_of.find(target);
+      if (g == group_of.end()) {
+        g = group_of.insert(pair<parsed_object*, size_t>(target, groups.size())).first;
+        groups.push_back(vector<size_t>());
+      }
+      groups[g->second].push_back(jobs.size());
+      jobs.push_back(job);
     }
-    fflush(stdout);
-  }
+  };
   
-  edbg << "\"Linking\" scripts" << flushl;
-  
-  //Next we traverse the scripts for dependencies.
-  unsigned nec_iters = 0;
-  if (es->scriptCount > 0)
-    nec_iters = lrint(ceilf(log2(es->scriptCount)));
-  edbg << "`Linking' " << es->scriptCount << " scripts in " << nec_iters << " passes...\n";
-  for (unsigned _necit = 0; _necit < nec_iters; _necit++) //We will iterate the list of scripts just enough times to copy everything
+  void parse_group(size_t group, void *stage)
   {
-    for (int _im = 0; _im < es->scriptCount; _im++) //For each script
+    parse_stage *const ps = (parse_stage*)stage;
+    const vector<size_t> &group_jobs = ps->groups[group];
+    for (size_t i = 0; i < group_jobs.size(); i++)
     {
-      parsed_script* curscript = scripts[_im]; //At this point, what we have is this:     for each script as curscript
-      for (parsed_object::funcit it = curscript->obj.funcs.begin(); it != curscript->obj.funcs.end(); it++) //For each function called by each script
-      {
-        map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
-        if (subscr != scr_lookup.end()) //At this point, what we have is this:     for each script called by curscript
-          curscript->obj.copy_calls_from(subscr->second->obj);
+      parse_job &job = ps->jobs[group_jobs[i]];
+      job.error_at = syncheck::syntacheck(job.code, job.error);
+      if (job.error_at != -1)
+        return; // Nothing after this is used; the compile stops when the error is reported
+      parser_main(job.parse_code, job.pev);
+      
+      // If the script accesses variables from outside its scope implicitly
+      parsed_script *const scr = job.script;
+      if (scr and (scr->obj.locals.size() or scr->obj.globallocals.size())) {
+        parsed_object temporary_object = *scr->pev.myObj;
+        scr->pev_global = new parsed_event(&temporary_object);
+        parser_main(string("with (self) {\n") + job.code + "\n/* */}",scr->pev_global);
+        scr->pev_global->myObj = NULL;
       }
     }
   }
+
+  /// Which scripts call which, as indices into the script array, along with the strongly
+  /// connected components of those calls.
+  struct script_graph
+  {
+    vector< vector<int> > calls;      // Scripts called by each script, in name order
+    vector< vector<int> > components; // Callees first: a component only calls into itself and components before it
+    vector<int> component_of;
+    
+    script_graph(int count): calls(count), components(), component_of(count, -1) {}
+    
+    /// Tarjan's algorithm, run with an explicit stack so that long call chains can't overflow ours.
+    void find_components()
+    {
+      const int n = calls.size();
+      vector<int> order(n, -1), low(n, 0), open;
+      vector<bool> is_open(n, false);
+      vector< pair<int,size_t> > path; // Each script being visited, with the next of its calls to look at
+      int visited = 0;
+      
+      for (int root = 0; root < n; root++)
+      {
+        if (order[root] != -1) continue;
+        order[root] = low[root] = visited++, open.push_back(root), is_open[root] = true;
+        path.push_back(pair<int,size_t>(root, 0));
+        while (!path.empty())
+        {
+          const int v = path.back().first;
+          if (path.back().second < calls[v].size())
+          {
+            const int w = calls[v][path.back().second++];
+            if (order[w] == -1) {
+              order[w] = low[w] = visited++, open.push_back(w), is_open[w] = true;
+              path.push_back(pair<int,size_t>(w, 0));
+            }
+            else if (is_open[w] and order[w] < low[v])
+              low[v] = order[w];
+            continue;
+          }
+          
+          path.pop_back();
+          if (!path.empty() and low[v] < low[path.back().first])
+            low[path.back().first] = low[v];
+          if (low[v] != order[v])
+            continue;
+          
+          components.push_back(vector<int>());
+          for (int w = -1; w != v; ) {
+            w = open.back(), open.pop_back(), is_open[w] = false;
+            component_of[w] = components.size() - 1;
+            components.back().push_back(w);
+          }
+          sort(components.back().begin(), components.back().end());
+        }
+      }
+    }
+  };
   
-  edbg << "Completing script \"Link\"" << flushl;
-  
-  for (int _im = 0; _im < es->scriptCount; _im++) //For each script
+  void report_script_graph(const script_graph &graph, EnigmaStruct *es)
   {
-    string curscrname = es->scripts[_im].name;
-    parsed_script* curscript = scripts[_im]; //At this point, what we have is this:     for each script as curscript
-    edbg << "Linking `" << curscrname << "':\n";
-    for (parsed_object::funcit it = curscript->obj.funcs.begin(); it != curscript->obj.funcs.end(); it++) //For each function called by each script
+    size_t callcount = 0, recursive = 0;
+    for (size_t i = 0; i < graph.calls.size(); i++)
+      callcount += graph.calls[i].size();
+    user << "Script call graph: " << graph.calls.size() << " scripts, " << callcount << " calls, linked in this order:" << flushl;
+    for (size_t c = 0; c < graph.components.size(); c++)
     {
-      cout << string(it->first) << "::";
-      map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
-      if (subscr != scr_lookup.end()) //At this point, what we have is this:     for each script called by curscript
+      const vector<int> &members = graph.components[c];
+      if (members.size() > 1)
+        user << "  " << members.size() << " scripts calling one another:" << flushl, recursive++;
+      for (size_t m = 0; m < members.size(); m++)
       {
-        cout << "is_script::";
-        curscript->obj.copy_from(subscr->second->obj,  "script `"+it->first+"'",  "script `"+curscrname + "'");
+        string line = string(members.size() > 1 ? "    " : "  ") + es->scripts[members[m]].name;
+        const vector<int> &calls = graph.calls[members[m]];
+        for (size_t i = 0; i < calls.size(); i++)
+          line += (i ? ", " : " -> ") + string(es->scripts[calls[i]].name);
+        user << line << flushl;
       }
     }
-    cout << endl;
+    user << graph.components.size() << " components, " << recursive << " of them mutually recursive" << flushl;
   }
-  edbg << "Done." << flushl;
-
+}
 
-  edbg << es->gmObjectCount << " Objects:\n";
+int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
+{
+  // Scripts, object events and room code are parsed on as many threads as there are processors.
+  // Everything the parser shares is read-only by now, so first we only lay out the work.
+  parse_stage stage;
+  
+  for (int i = 0; i < es->scriptCount; i++)
+  {
+    // Keep a parsed record of this script
+    scr_lookup[es->scripts[i].name] = scripts[i] = new parsed_script;
+    scripts[i]->obj.name = es->scripts[i].name;
+    stage.add(parse_job(parse_job::SCRIPT, i, 0, 0, es->scripts[i].code, es->scripts[i].code, &scripts[i]->pev, scripts[i]));
+  }
+  
   for (int i = 0; i < es->gmObjectCount; i++)
   {
     //For every object in Ism's struct, make our own
@@ -128,84 +219,132 @@ int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
         es->gmObjects[i].visible, es->gmObjects[i].solid,
         es->gmObjects[i].depth, es->gmObjects[i].persistent
       );
-
-    edbg << " " << es->gmObjects[i].name << ": " << es->gmObjects[i].mainEventCount << " events: " << flushl;
-
+    
     for (int ii = 0; ii < es->gmObjects[i].mainEventCount; ii++)
-    if (es->gmObjects[i].mainEvents[ii].eventCount) //For every MainEvent that contains event code
+    for (int iii = 0; iii < es->gmObjects[i].mainEvents[ii].eventCount; iii++)
     {
-      //For each main event in that object, make a copy
-      const int mev_id = es->gmObjects[i].mainEvents[ii].id;
-      edbg << "  Event[" << es->gmObjects[i].mainEvents[ii].id << "]: ";
-
-      edbg << "  Parsing " << es->gmObjects[i].mainEvents[ii].eventCount << " sub-events:" << flushl;
-      for (int iii = 0; iii < es->gmObjects[i].mainEvents[ii].eventCount; iii++)
-      {
-        //For each individual event (like begin_step) in the main event (Step), parse the code
-        const int sev_id = es->gmObjects[i].mainEvents[ii].events[iii].id;
-        parsed_event &pev = pob->events[ev_count++]; //Make sure each sub event knows its main event's event ID.
-        pev.mainId = mev_id, pev.id = sev_id;
-        
-        //Copy the code into a string, and its attributes elsewhere
-        string code = es->gmObjects[i].mainEvents[ii].events[iii].code;
-        
-        //Syntax check the code
-        
-        // Print debug info
-          edbg << "Check `" << es->gmObjects[i].name << "::" << event_get_function_name(es->gmObjects[i].mainEvents[ii].id,es->gmObjects[i].mainEvents[ii].events[iii].id) << "...";
-        
-        // Check the code
-        int sc = syncheck::syntacheck(code);
-        if (sc != -1)
-        {
-          // Error. Report it.
-          user << "Syntax error in object `" << es->gmObjects[i].name << "', " << event_get_human_name(es->gmObjects[i].mainEvents[ii].id,es->gmObjects[i].mainEvents[ii].events[iii].id) << " event:"
-               << es->gmObjects[i].mainEvents[ii].events[iii].id << ":\n" << format_error(code,syncheck::syerr,sc) << flushl;
-          return E_ERROR_SYNTAX;
-        }
-        
-        edbg << " Done. Parse...";
-        
-        //Add this to our objects map
-        pev.myObj = pob; //Link to its calling object.
-        parser_main(code,&pev); //Format it to C++
-        
-        edbg << " Done." << flushl;
-      }
+      //For each individual event (like begin_step) in the main event (Step), parse the code
+      parsed_event &pev = pob->events[ev_count++]; //Make sure each sub event knows its main event's event ID.
+      pev.mainId = es->gmObjects[i].mainEvents[ii].id, pev.id = es->gmObjects[i].mainEvents[ii].events[iii].id;
+      pev.myObj = pob; //Link to its calling object.
+      const char *const code = es->gmObjects[i].mainEvents[ii].events[iii].code;
+      stage.add(parse_job(parse_job::EVENT, i, ii, iii, code, code, &pev));
     }
   }
   
   //Now we parse the rooms
-  edbg << "Creating room creation code scope and parsing" << flushl;
   for (int i = 0; i < es->roomCount; i++)
   {
     parsed_room *pr = parsed_rooms[es->rooms[i].id] = new parsed_room;
     parsed_event &pev = pr->events[0]; //Make sure each sub event knows its main event's event ID.
     pev.mainId = 0, pev.id = 0, pev.myObj = pr;
-    
-    int sc = syncheck::syntacheck(es->rooms[i].creationCode);
-    if (sc != -1) {
-      cout << "Syntax error in room creation code for room " << es->rooms[i].id << " (`" << es->rooms[i].name << "'):" << endl << syncheck::syerr << flushl;
-      return E_ERROR_SYNTAX;
-    }
-    parser_main(es->rooms[i].creationCode,&pev);
+    stage.add(parse_job(parse_job::ROOM, i, 0, 0, es->rooms[i].creationCode, es->rooms[i].creationCode, &pev));
     
     for (int ii = 0; ii < es->rooms[i].instanceCount; ii++)
     {
       if (es->rooms[i].instances[ii].creationCode and *(es->rooms[i].instances[ii].creationCode))
       {
-        int a = syncheck::syntacheck(es->rooms[i].instances[ii].creationCode);
-        if (a != -1) {
-          cout << "Syntax error in room creation code for room " << es->rooms[i].id << " (`" << es->rooms[i].name << "'):" << endl << syncheck::syerr << flushl;
-          return E_ERROR_SYNTAX;
-        }
-        
+        // Instance creation code collects into its object, so it joins that object's group
         pr->instance_create_codes[es->rooms[i].instances[ii].id].object_index = es->rooms[i].instances[ii].objectId;
         parsed_event* icce = pr->instance_create_codes[es->rooms[i].instances[ii].id].pe = new parsed_event(-1,-1,parsed_objects[es->rooms[i].instances[ii].objectId]);
-        parser_main(string("with (") + tostring(es->rooms[i].instances[ii].id) + ") {" + es->rooms[i].instances[ii].creationCode + "}", icce);
+        const char *const code = es->rooms[i].instances[ii].creationCode;
+        stage.add(parse_job(parse_job::INSTANCE, i, ii, 0, code, string("with (") + tostring(es->rooms[i].instances[ii].id) + ") {" + code + "}", icce));
+      }
+    }
+  }
+  
+  edbg << "Parsing " << stage.jobs.size() << " pieces of code for " << stage.groups.size() << " scopes on up to " << parallel_thread_count() << " threads" << flushl;
+  parallel_for(stage.groups.size(), parse_group, &stage);
+  
+  // Report the first syntax error as if everything had been checked in order
+  for (size_t j = 0; j < stage.jobs.size(); j++)
+  {
+    const parse_job &job = stage.jobs[j];
+    switch (job.what)
+    {
+      case parse_job::SCRIPT:
+          if (job.error_at != -1) {
+            user << "Syntax error in script `" << es->scripts[job.a].name << "'\n" << job.error << flushl;
+            return E_ERROR_SYNTAX;
+          }
+          edbg << "Parsed `" << es->scripts[job.a].name << "': " << scripts[job.a]->obj.locals.size() << " locals, " << scripts[job.a]->obj.globals.size() << " globals" << flushl;
+        break;
+      case parse_job::EVENT: {
+          const GmObject &obj = es->gmObjects[job.a];
+          const int mev_id = obj.mainEvents[job.b].id, sev_id = obj.mainEvents[job.b].events[job.c].id;
+          if (job.error_at != -1) {
+            user << "Syntax error in object `" << obj.name << "', " << event_get_human_name(mev_id,sev_id) << " event:"
+                 << sev_id << ":\n" << format_error(job.code,job.error,job.error_at) << flushl;
+            return E_ERROR_SYNTAX;
+          }
+          edbg << "Parsed `" << obj.name << "::" << event_get_function_name(mev_id,sev_id) << "'" << flushl;
+        } break;
+      case parse_job::ROOM: case parse_job::INSTANCE:
+          if (job.error_at != -1) {
+            cout << "Syntax error in room creation code for room " << es->rooms[job.a].id << " (`" << es->rooms[job.a].name << "'):" << endl << job.error << flushl;
+            return E_ERROR_SYNTAX;
+          }
+        break;
+    }
+  }
+  
+  // The parser no longer counts script arguments as it goes; take the largest use now
+  for (int i = 0; i < es->scriptCount; i++)
+    if (global_script_argument_count < scripts[i]->obj.argument_count)
+      global_script_argument_count = scripts[i]->obj.argument_count;
+  for (po_i i = parsed_objects.begin(); i != parsed_objects.end(); i++)
+    if (i->second and global_script_argument_count < i->second->argument_count)
+      global_script_argument_count = i->second->argument_count;
+  for (pr_i i = parsed_rooms.begin(); i != parsed_rooms.end(); i++)
+    if (global_script_argument_count < i->second->argument_count)
+      global_script_argument_count = i->second->argument_count;
+  
+  edbg << "\"Linking\" scripts" << flushl;
+  
+  // Each script inherits the locals, globals and calls of every script it can reach. Scripts that
+  // reach each other share all of that, so we work on the graph's strongly connected components,
+  // callees first; by the time a component is linked, everything it calls outside itself is done.
+  map<string,int> script_ids;
+  for (int i = 0; i < es->scriptCount; i++)
+    script_ids[es->scripts[i].name] = i;
+  script_graph graph(es->scriptCount);
+  for (int i = 0; i < es->scriptCount; i++)
+    for (parsed_object::funcit it = scripts[i]->obj.funcs.begin(); it != scripts[i]->obj.funcs.end(); it++) //For each function called by each script
+    {
+      map<string,int>::iterator subscr = script_ids.find(it->first); //Check if it's a script
+      if (subscr != script_ids.end())
+        graph.calls[i].push_back(subscr->second);
+    }
+  graph.find_components();
+  edbg << "`Linking' " << es->scriptCount << " scripts in " << graph.components.size() << " components..." << flushl;
+  if (setting::report_script_graph)
+    report_script_graph(graph, es);
+  
+  for (size_t c = 0; c < graph.components.size(); c++)
+  {
+    const vector<int> &members = graph.components[c];
+    parsed_object reach; // Everything the component can get to, gathered once for all its members
+    string reachname = members.size() == 1 ? "scripts called by `" + scripts[members[0]]->obj.name + "'" : "scripts recursive with `" + scripts[members[0]]->obj.name + "'";
+    for (size_t m = 0; m < members.size(); m++)
+      if (members.size() > 1)
+        reach.copy_from(scripts[members[m]]->obj, "script `" + scripts[members[m]]->obj.name + "'", reachname);
+    for (size_t m = 0; m < members.size(); m++)
+      for (size_t i = 0; i < graph.calls[members[m]].size(); i++)
+      {
+        parsed_script *const callee = scripts[graph.calls[members[m]][i]];
+        reach.copy_calls_from(callee->obj);
+        if (graph.component_of[graph.calls[members[m]][i]] != (int)c) // Members of this component were copied above
+          reach.copy_from(callee->obj, "script `" + callee->obj.name + "'", reachname);
       }
+    
+    for (size_t m = 0; m < members.size(); m++)
+    {
+      parsed_object &curscript = scripts[members[m]]->obj;
+      curscript.copy_calls_from(reach);
+      curscript.copy_from(reach, reachname, "script `" + curscript.name + "'");
     }
   }
+  edbg << "Done." << flushl;
   
   //Next we link the scripts into the objects.
   edbg << "\"Linking\" scripts into the objects..." << flushl;
@@ -237,6 +376,20 @@ int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
       subscr->second->globargs = it->second,
       edbg << "  Object `" << i->second->name << "' calls " << it->first << " with " << it->second << " parameters." << flushl;
   }
+  for (pr_i i = parsed_rooms.begin(); i != parsed_rooms.end(); i++)
+    for (parsed_object::funcit it = i->second->funcs.begin(); it != i->second->funcs.end(); it++) //Room creation code calls them as well
+  {
+    map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first);
+    if (subscr != scr_lookup.end() and subscr->second->globargs < it->second)
+      subscr->second->globargs = it->second;
+  }
+  for (map<string,parsed_script*>::iterator i = scr_lookup.begin(); i != scr_lookup.end(); i++)
+    for (parsed_object::funcit it = i->second->obj.funcs.begin(); it != i->second->obj.funcs.end(); it++) //As do scripts no object reaches
+  {
+    map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first);
+    if (subscr != scr_lookup.end() and subscr->second->globargs < it->second)
+      subscr->second->globargs = it->second;
+  }
   edbg << "Finished" << flushl;
   
   return 0;
@@ -33,18 +33,49 @@ using namespace std;
 
 #include "syntax/syncheck.h"
 #include "parser/parser.h"
+#include "parser/infer_local_types.h"
 
 #include "backend/EnigmaStruct.h" //LateralGM interface structures
 #include "parser/object_storage.h"
 #include "compiler/compile_common.h"
 #include "compiler/event_reader/event_parser.h"
 
+// Gives the locals of one piece of code native types where possible, and reports each one that changed.
+static int specialize_locals(parsed_event* pev, string where)
+{
+  map<string,string> retyped = infer_local_types(pev->code, pev->synt);
+  for (map<string,string>::iterator it = retyped.begin(); it != retyped.end(); it++)
+    edbg << "  Local `" << it->first << "' in " << where << " declared " << it->second << " instead of var" << flushl;
+  return retyped.size();
+}
+
 #include "languages/lang_CPP.h"
 int lang_CPP::compile_parseSecondary(map<int,parsed_object*> &parsed_objects, parsed_script* scripts[], int scrcount, map<int,parsed_room*> &parsed_rooms, parsed_object* EGMglobal)
 {
   // Dump our list of dot-accessed locals
   dot_accessed_locals.clear();
   
+  // Type what locals we can before anything else reads the declarations
+  edbg << "Inferring types of locals" << flushl;
+  int specialized = 0;
+  for (po_i it = parsed_objects.begin(); it != parsed_objects.end(); it++)
+    for (unsigned iit = 0; iit < it->second->events.size; iit++)
+      specialized += specialize_locals(&it->second->events[iit], "object `" + it->second->name + "', "
+                                       + event_get_human_name(it->second->events[iit].mainId, it->second->events[iit].id) + " event");
+  for (int i = 0; i < scrcount; i++) {
+    specialized += specialize_locals(&scripts[i]->pev, "script `" + scripts[i]->obj.name + "'");
+    if (scripts[i]->pev_global)
+      infer_local_types(scripts[i]->pev_global->code, scripts[i]->pev_global->synt); // Same code, already reported
+  }
+  for (pr_i it = parsed_rooms.begin(); it != parsed_rooms.end(); it++)
+  {
+    if (it->second->events.size)
+      specialized += specialize_locals(&it->second->events[0], "room creation code");
+    for (map<int,parsed_room::parsed_icreatecode>::iterator ici = it->second->instance_create_codes.begin(); ici != it->second->instance_create_codes.end(); ici++)
+      specialized += specialize_locals(ici->second.pe, "instance creation code");
+  }
+  edbg << "Declared " << specialized << " locals with native types" << flushl;
+
   // Give all objects and events a second pass
   for (po_i it = parsed_objects.begin(); it != parsed_objects.end(); it++)
   {
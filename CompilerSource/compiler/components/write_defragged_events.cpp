@@ -135,6 +135,18 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
     int ind = 0;
     for (evfit it = used_events.begin(); it != used_events.end(); it++)
       wto  << "    event_" << it->first << " = events + " << ind++ << ";  event_" << it->first << "->name = \"" << event_get_human_name(it->second.mid,it->second.id) << "\";" << endl;
+
+    // Objects with draw code of their own or inherited from a parent are left out of draw culling unless they opt in.
+    for (po_i it = parsed_objects.begin(); it != parsed_objects.end(); it++)
+    {
+      bool custom_draw = false;
+      for (po_i her = it; her != parsed_objects.end() and !custom_draw; her = parsed_objects.find(her->second->parent)) // For this object and each parent thereof
+        for (unsigned j = 0; j < her->second->events.size; j++)
+          if (her->second->events[j].code != "" and event_get_function_name(her->second->events[j].mainId,her->second->events[j].id) == "draw")
+            { custom_draw = true; break; }
+      if (custom_draw)
+        wto << "    draw_culling_mark_custom(" << it->first << ");" << endl;
+    }
     wto << "    return 0;" << endl;
   wto << "  }" << endl;
 
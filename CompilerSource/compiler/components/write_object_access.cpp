@@ -74,8 +74,14 @@ int lang_CPP::compile_writeObjAccess(map<int,parsed_object*> &parsed_objects, pa
     
     wto <<
     "  object_locals ldummy;" << endl <<
+    "  object_locals *glaccess(object_basic *inst)" << endl <<
+    "  {" << endl << "    return inst ? (object_locals*)inst : &ldummy;" << endl << "  }" << endl <<
     "  object_locals *glaccess(int x)" << endl <<
-    "  {" << endl << "    object_locals* ri = (object_locals*)fetch_instance_by_int(x);" << endl << "    return ri ? ri : &ldummy;" << endl << "  }" << endl << endl;
+    "  {" << endl << "    return glaccess(fetch_instance_by_int(x));" << endl << "  }" << endl << endl;
+
+    // Accessors keep the offset of their member in each object, indexed by object_index. The first
+    // access from each object finds it through the switch; every later one goes straight to it.
+    const int object_count = parsed_objects.empty() ? 1 : parsed_objects.rbegin()->first + 1;
     
     map<string,usedtype> usedtypes;
     for (map<string,dectrip>::iterator dait = dot_accessed_locals.begin(); dait != dot_accessed_locals.end(); dait++) {
@@ -94,11 +100,20 @@ int lang_CPP::compile_writeObjAccess(map<int,parsed_object*> &parsed_objects, pa
     for (map<string,dectrip>::iterator dait = dot_accessed_locals.begin(); dait != dot_accessed_locals.end(); dait++)
     {
       const string& pmember = dait->first;
-      wto << "  " << dait->second.type << " " << dait->second.prefix << REFERENCE_POSTFIX(dait->second.suffix) << " &varaccess_" << pmember << "(int x)" << endl;
+      const string rettype = dait->second.type + " " + dait->second.prefix + REFERENCE_POSTFIX(dait->second.suffix);
+      const int dummy = usedtypes[dait->second.type + " " + dait->second.prefix + dait->second.suffix].uc;
+      const bool tabled = dait->second.suffix.find('[') == string::npos; // Arrays are handed back as pointers, so they can't be found by offset
+      wto << "  " << rettype << " &varaccess_" << pmember << "(object_basic *inst)" << endl;
       wto << "  {" << endl;
-      
-      wto << "    object_basic *inst = fetch_instance_by_int(x);" << endl;
-      wto << "    if (inst) switch (inst->object_index)" << endl << "    {" << endl;
+      wto << "    if (!inst) return dummy_" << dummy << ";" << endl;
+      if (tabled)
+      {
+        wto << "    static ptrdiff_t offsets[" << object_count << "]; // Zero until looked up; -1 in objects without " << pmember << endl;
+        wto << "    const unsigned oi = inst->object_index;" << endl;
+        wto << "    if (oi < " << object_count << " and offsets[oi])" << endl;
+        wto << "      return offsets[oi] > 0 ? *(" << dait->second.type << " " << dait->second.prefix << "*)((char*)inst + offsets[oi]) : dummy_" << dummy << ";" << endl;
+      }
+      wto << "    switch (inst->object_index)" << endl << "    {" << endl;
       
       for (po_i it = parsed_objects.begin(); it != parsed_objects.end(); it++)
       {
@@ -107,14 +122,22 @@ int lang_CPP::compile_writeObjAccess(map<int,parsed_object*> &parsed_objects, pa
         {
           string tot = x->second.type != "" ? x->second.type : "var";
           if (tot == dait->second.type and x->second.prefix == dait->second.prefix and x->second.suffix == dait->second.suffix)
-            wto << "      case " << it->second->name << ": return ((OBJ_" << it->second->name << "*)inst)->" << pmember << ";" << endl;
+          {
+            wto << "      case " << it->second->name << ": ";
+            if (tabled)
+              wto << "offsets[" << it->second->name << "] = (char*)&((OBJ_" << it->second->name << "*)inst)->" << pmember << " - (char*)inst; ";
+            wto << "return ((OBJ_" << it->second->name << "*)inst)->" << pmember << ";" << endl;
+          }
         }
       }
       
       wto << "      case global: return ((ENIGMA_global_structure*)ENIGMA_global_instance)->" << pmember << ";" << endl;
       wto << "    }" << endl;
-      wto << "    return dummy_" << usedtypes[dait->second.type + " " + dait->second.prefix + dait->second.suffix].uc << ";" << endl;
+      if (tabled)
+        wto << "    if (oi < " << object_count << ") offsets[oi] = -1;" << endl;
+      wto << "    return dummy_" << dummy << ";" << endl;
       wto << "  }" << endl;
+      wto << "  " << rettype << " &varaccess_" << pmember << "(int x) { return varaccess_" << pmember << "(fetch_instance_by_int(x)); }" << endl;
     }
     wto << "} // namespace enigma" << endl;
   wto.close();
@@ -53,7 +53,24 @@ inline bool iscomment(const string &n) {
   return true;
 }
 
-struct cspair { string c, s; };
+// Scripts take as many parameters as they read or are ever called with, and nothing is built
+// for a parameter a call leaves out: it binds to enigma::script_noarg. Arguments the script
+// only reads are passed by const reference; those it might modify are passed by value.
+static int script_parameter_count(parsed_script* scr) {
+  return scr->globargs > scr->obj.argument_count ? scr->globargs : scr->obj.argument_count;
+}
+static void write_script_parameters(ofstream &wto, parsed_script* scr, bool defaults)
+{
+  const int argc = script_parameter_count(scr);
+  for (int argn = 0; argn < argc; argn++)
+  {
+    wto << (argn ? ", " : "") << (scr->obj.arguments_modified.count(argn) ? "variant" : "const variant&") << " argument" << argn;
+    if (defaults)
+      wto << " = enigma::script_noarg";
+  }
+}
+
+struct cspair { string c, s; int id; }; // Code, root name, and any one sub-event id of a stacked event
 int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
 {
   //NEXT FILE ----------------------------------------
@@ -74,14 +91,8 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
 
     for (int i = 0; i < es->scriptCount; i++)
     {
-      parsed_script* scr = scr_lookup[es->scripts[i].name];
-      const char* comma = "";
       wto << "variant _SCR_" << es->scripts[i].name << "(";
-      scr->globargs=16;//Fixes too many arguments error (scripts can be called dynamically with any number of arguments)
-      for (int argn = 0; argn < scr->globargs; argn++) {
-        wto << comma << "variant argument" << argn << "=0";
-        comma = ", ";
-      }
+      write_script_parameters(wto, scr_lookup[es->scripts[i].name], true);
       wto << ");\n";
     }
     wto << "\n";
@@ -177,13 +188,8 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
           if (subscr != scr_lookup.end() // If we've got ourselves a script
           and subscr->second->pev_global) // And it has distinct code for use at the global scope (meaning it's more efficient locally)
           {
-            const char* comma = "";
             wto << "\n    variant _SCR_" << it->first << "(";
-            for (int argn = 0; argn < it->second; argn++) //it->second gives max argument count used
-            {
-              wto << comma << "variant argument" << argn << " = 0";
-              comma = ", ";
-            }
+            write_script_parameters(wto, subscr->second, true);
             wto << ");";
           }
         } wto << "\n    ";
@@ -200,7 +206,8 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
             if (event_is_instance(i->second->events[ii].mainId,i->second->events[ii].id))
               nemap[i->second->events[ii].mainId].c += (event_has_super_check(i->second->events[ii].mainId,i->second->events[ii].id) ?
                 "        if (" + event_get_super_check_condition(i->second->events[ii].mainId,i->second->events[ii].id) + ") myevent_" : "        myevent_") + evname + "();\n",
-              nemap[i->second->events[ii].mainId].s = event_stacked_get_root_name(i->second->events[ii].mainId);
+              nemap[i->second->events[ii].mainId].s = event_stacked_get_root_name(i->second->events[ii].mainId),
+              nemap[i->second->events[ii].mainId].id = i->second->events[ii].id;
             wto << "    variant myevent_" << evname << "();\n    ";
           }
         if (nemap.size())
@@ -233,7 +240,11 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
                 wto << "      enigma::inst_iter *ENOBJ_ITER_myevent_" << event_get_function_name(i->second->events[ii].mainId,i->second->events[ii].id) << ";\n";
             }
           for (map<int,cspair>::iterator it = nemap.begin(); it != nemap.end(); it++) // The stacked ones should have their root exported
-            wto << "      enigma::inst_iter *ENOBJ_ITER_myevent_" << it->second.s << ";\n";
+            if (event_has_iterator_declare_code(it->first,it->second.id)) {
+              if (!iscomment(event_get_iterator_declare_code(it->first,it->second.id)))
+                wto << "      " << event_get_iterator_declare_code(it->first,it->second.id) << ";\n";
+            } else
+              wto << "      enigma::inst_iter *ENOBJ_ITER_myevent_" << it->second.s << ";\n";
 
         //This is the actual call to remove the current instance from all linked records before destroying it.
         wto << "\n    void unlink()\n    {\n";
@@ -252,7 +263,11 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
                 wto << "      enigma::event_" << evname << "->unlink(ENOBJ_ITER_myevent_" << evname << ");\n";
           }
           for (map<int,cspair>::iterator it = nemap.begin(); it != nemap.end(); it++) // The stacked ones should have their root exported
-            wto << "      enigma::event_" << it->second.s << "->unlink(ENOBJ_ITER_myevent_" << it->second.s << ");\n";
+            if (event_has_iterator_unlink_code(it->first,it->second.id)) {
+              if (!iscomment(event_get_iterator_unlink_code(it->first,it->second.id)))
+                wto << "      " << event_get_iterator_unlink_code(it->first,it->second.id) << ";\n";
+            } else
+              wto << "      enigma::event_" << it->second.s << "->unlink(ENOBJ_ITER_myevent_" << it->second.s << ");\n";
           wto << "    }\n    ";
 
 
@@ -303,7 +318,11 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
                     wto << "      ENOBJ_ITER_myevent_" << evname << " = enigma::event_" << evname << "->add_inst(this);\n";
               }
               for (map<int,cspair>::iterator it = nemap.begin(); it != nemap.end(); it++)
-                wto << "      ENOBJ_ITER_myevent_" << it->second.s << " = enigma::event_" << it->second.s << "->add_inst(this);\n";
+                if (event_has_iterator_initialize_code(it->first,it->second.id)) {
+                  if (!iscomment(event_get_iterator_initialize_code(it->first,it->second.id)))
+                    wto << "      " << event_get_iterator_initialize_code(it->first,it->second.id) << ";\n";
+                } else
+                  wto << "      ENOBJ_ITER_myevent_" << it->second.s << " = enigma::event_" << it->second.s << "->add_inst(this);\n";
           wto << "    }\n";
 
 
@@ -321,7 +340,11 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
                   wto << "      delete ENOBJ_ITER_myevent_" << event_get_function_name(i->second->events[ii].mainId,i->second->events[ii].id) << ";\n";
               }
             for (map<int,cspair>::iterator it = nemap.begin(); it != nemap.end(); it++) // The stacked ones should have their root exported
-              wto << "      delete ENOBJ_ITER_myevent_" << it->second.s << ";\n";
+              if (event_has_iterator_delete_code(it->first,it->second.id)) {
+                if (!iscomment(event_get_iterator_delete_code(it->first,it->second.id)))
+                  wto << "      " << event_get_iterator_delete_code(it->first,it->second.id) << ";\n";
+              } else
+                wto << "      delete ENOBJ_ITER_myevent_" << it->second.s << ";\n";
           wto << "    }\n";
 
         wto << "  };\n";
@@ -344,13 +367,8 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
     for (int i = 0; i < es->scriptCount; i++)
     {
       parsed_script* scr = scr_lookup[es->scripts[i].name];
-      const char* comma = "";
       wto << "variant _SCR_" << es->scripts[i].name << "(";
-      for (int argn = 0; argn < scr->globargs; argn++) //it->second gives max argument count used
-      {
-        wto << comma << "variant argument" << argn;
-        comma = ", ";
-      }
+      write_script_parameters(wto, scr, false);
       wto << ")\n{\n  ";
       parsed_event& upev = scr->pev_global?*scr->pev_global:scr->pev;
       print_to_file(upev.code,upev.synt,upev.strc,upev.strs,2,wto);
@@ -395,13 +413,8 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
         if (subscr != scr_lookup.end() // If we've got ourselves a script
         and subscr->second->pev_global) // And it has distinct code for use at the global scope (meaning it's more efficient locally)
         {
-          const char* comma = "";
           wto << "variant enigma::OBJ_" << i->second->name << "::_SCR_" << it->first << "(";
-          for (int argn = 0; argn < it->second; argn++) //it->second gives max argument count used
-          {
-            wto << comma << "variant argument" << argn;
-            comma = ", ";
-          }
+          write_script_parameters(wto, subscr->second, false);
           wto << ")\n{\n  ";
           print_to_file(subscr->second->pev.code,subscr->second->pev.synt,subscr->second->pev.strc,subscr->second->pev.strs,2,wto);
           wto << "\n  return 0;\n}\n\n";
@@ -411,18 +424,30 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global)
     }
     cout << "DBGMSG 7" << endl;
 
-    wto << "namespace enigma\n{\n"
-    "  callable_script callable_scripts[] = {\n";
+    wto << "namespace enigma\n{\n";
+    // script_execute hands every script the same array of sixteen arguments; each dispatcher passes on what its script takes.
+    for (int i = 0; i < es->scriptCount; i++)
+    {
+      const int argc = script_parameter_count(scr_lookup[es->scripts[i].name]);
+      wto << "  variant script_dispatch_" << es->scripts[i].name << "(const variant *const *argv) { return _SCR_" << es->scripts[i].name << "(";
+      for (int argn = 0; argn < argc; argn++)
+        if (argn < 16)
+          wto << (argn ? ", " : "") << "*argv[" << argn << "]";
+        else
+          wto << ", script_noarg";
+      wto << "); }\n";
+    }
+    wto << "  \n  callable_script callable_scripts[] = {\n";
     int scr_count = 0;
     for (int i = 0; i < es->scriptCount; i++)
     {
       while (es->scripts[i].id > scr_count)
       {
-          wto << "    { NULL, -1 },\n";
+          wto << "    { NULL, -1, NULL },\n";
           scr_count++;
       }
       scr_count++;
-      wto << "    { (variant(*)())_SCR_" << es->scripts[i].name << ", " << scr_lookup[es->scripts[i].name]->globargs << " },\n";
+      wto << "    { (variant(*)())_SCR_" << es->scripts[i].name << ", " << script_parameter_count(scr_lookup[es->scripts[i].name]) << ", script_dispatch_" << es->scripts[i].name << " },\n";
     }
     wto << "  };\n  \n";
 
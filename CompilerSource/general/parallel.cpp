@@ -0,0 +1,107 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include "parallel.h"
+#include "OS_Switchboard.h"
+
+#if CURRENT_PLATFORM_ID == OS_WINDOWS
+  #include <windows.h>
+#else
+  #include <pthread.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+  struct parallel_job {
+    size_t count;
+    void (*work)(size_t, void*);
+    void *data;
+    volatile long next; // Next index to hand out; advanced atomically
+  };
+
+  inline size_t take_index(parallel_job *job) {
+    #if CURRENT_PLATFORM_ID == OS_WINDOWS
+      return InterlockedIncrement(&job->next) - 1;
+    #else
+      return __sync_fetch_and_add(&job->next, 1);
+    #endif
+  }
+
+  void run_worker(parallel_job *job) {
+    for (size_t i = take_index(job); i < job->count; i = take_index(job))
+      job->work(i, job->data);
+  }
+
+  #if CURRENT_PLATFORM_ID == OS_WINDOWS
+    DWORD WINAPI worker_main(LPVOID job) { run_worker((parallel_job*)job); return 0; }
+  #else
+    void *worker_main(void *job) { run_worker((parallel_job*)job); return NULL; }
+  #endif
+}
+
+unsigned parallel_thread_count()
+{
+  #if CURRENT_PLATFORM_ID == OS_WINDOWS
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    const long n = si.dwNumberOfProcessors;
+  #else
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  #endif
+  return n > 1 ? n : 1;
+}
+
+void parallel_for(size_t count, void (*work)(size_t index, void *data), void *data)
+{
+  parallel_job job = { count, work, data, 0 };
+  size_t threads = parallel_thread_count();
+  if (threads > count)
+    threads = count;
+  
+  // The calling thread does its share of the work, so only threads - 1 are started.
+  // Should one fail to start, the remaining ones simply take more of the indices.
+  #if CURRENT_PLATFORM_ID == OS_WINDOWS
+    HANDLE *workers = new HANDLE[threads];
+    size_t started = 0;
+    for (size_t i = 1; i < threads; i++)
+      if ((workers[started] = CreateThread(NULL, 0, worker_main, &job, 0, NULL)))
+        started++;
+    run_worker(&job);
+    for (size_t i = 0; i < started; i++)
+      WaitForSingleObject(workers[i], INFINITE), CloseHandle(workers[i]);
+  #else
+    pthread_t *workers = new pthread_t[threads];
+    size_t started = 0;
+    for (size_t i = 1; i < threads; i++)
+      if (!pthread_create(&workers[started], NULL, worker_main, &job))
+        started++;
+    run_worker(&job);
+    for (size_t i = 0; i < started; i++)
+      pthread_join(workers[i], NULL);
+  #endif
+  delete[] workers;
+}
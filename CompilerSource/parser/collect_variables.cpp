@@ -37,7 +37,6 @@ using namespace std;
 #include "config.h"
 #include "compiler/event_reader/event_parser.h"
 
-extern int global_script_argument_count;
 
 struct scope_ignore {
   map<string,int> ignore;
@@ -52,6 +51,28 @@ struct scope_ignore {
 #include "collect_variables.h"
 #include "languages/language_adapter.h"
 
+// Scripts take the arguments they only read by const reference; anything that might write
+// to one, whether by assignment, increment, or subscript, makes the script take a copy.
+static bool argument_modified(const string &code, pt spos, pt epos)
+{
+  while (spos > 0 and code[spos-1] == ' ') spos--;
+  while (epos < code.length() and code[epos] == ' ') epos++;
+  if (spos >= 2 and (code[spos-1] == '+' or code[spos-1] == '-') and code[spos-2] == code[spos-1])
+    return true;
+  if (epos >= code.length())
+    return false;
+  const char c = code[epos], n = epos + 1 < code.length() ? code[epos+1] : 0;
+  if (c == '[' or c == '.')
+    return true;
+  if (c == '=')
+    return n != '=';
+  if ((c == '+' or c == '-') and n == c)
+    return true;
+  if (n == '=' and (c == '+' or c == '-' or c == '*' or c == '/' or c == '%' or c == '|' or c == '&' or c == '^' or c == ':'))
+    return true;
+  return (c == '<' or c == '>') and n == c and epos + 2 < code.length() and code[epos+2] == '=';
+}
+
 void collect_variables(language_adapter *lang, string &code, string &synt, parsed_event* pev)
 {
   int igpos = 0;
@@ -288,8 +309,10 @@ void collect_variables(language_adapter *lang, string &code, string &synt, parse
         iscr = sscanf(nname.c_str(),"argument%d",&argnum);
         if (iscr == 1)
         { //  not in a script or are but have exceeded arg number
-          if (global_script_argument_count < argnum + 1)
-            global_script_argument_count = argnum + 1;
+          if (pev->myObj->argument_count < argnum + 1)
+            pev->myObj->argument_count = argnum + 1;
+          if (argument_modified(code, spos, pos + 1))
+            pev->myObj->arguments_modified.insert(argnum);
           continue;
         }
         
@@ -0,0 +1,612 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <string.h>
+using namespace std;
+
+#include "parser_components.h"
+#include "infer_local_types.h"
+#include "languages/language_adapter.h"
+#include "compiler/compile_common.h"
+#include <Storage/definition.h>
+#include <System/builtins.h>
+
+extern jdi::definition *enigma_type__var, *enigma_type__variant, *enigma_type__varargs;
+
+namespace {
+  enum ltype { lt_none, lt_real, lt_string, lt_unknown };
+
+  struct local_candidate {
+    ltype type;         // What this local is believed to hold; lt_unknown once it has to stay var
+    int decl;           // The declaration statement naming it
+    pt name_pos;        // Where that statement names it
+    bool initialized;   // Whether that statement gives it a value
+    pt scope_end;       // End of the block it was declared in
+    vector<pt> uses;    // Every other place it is named
+    local_candidate(): type(lt_none), decl(-1), name_pos(0), initialized(false), scope_end(0) {}
+  };
+
+  struct declaration {
+    pt pos, len;          // Extent of the `var` keyword
+    vector<string> names;
+  };
+
+  // Finds the end of the token beginning at pos.
+  inline pt run_end(const string &synt, pt pos) {
+    const char c = synt[pos];
+    while (pos < synt.length() and synt[pos] == c) pos++;
+    return pos;
+  }
+
+  inline bool is_arithmetic_type(const string &t) {
+    return t == "double" or t == "float" or t == "int" or t == "long" or t == "short" or t == "char"
+        or t == "bool" or t == "unsigned" or t == "signed";
+  }
+
+  // The type a value of the given C++ type would give a local.
+  ltype value_type(jdi::definition *t)
+  {
+    while (t and (t->flags & (jdi::DEF_TYPENAME | jdi::DEF_TYPED)) == (jdi::DEF_TYPENAME | jdi::DEF_TYPED)
+           and ((jdi::definition_typed*)t)->referencers.empty())
+      t = ((jdi::definition_typed*)t)->type; // Look through typedefs
+    if (!t or t == jdi::builtin_type__void or t == jdi::builtin_type__va_list)
+      return lt_unknown;
+    if (t->flags & (jdi::DEF_ATOMIC | jdi::DEF_ENUM) or t == jdi::builtin_type__double or t == jdi::builtin_type__float
+        or t == jdi::builtin_type__int or t == jdi::builtin_type__char or t == jdi::builtin_type__bool
+        or t == jdi::builtin_type__long or t == jdi::builtin_type__short or t == jdi::builtin_type__unsigned
+        or t == jdi::builtin_type__signed)
+      return lt_real;
+    if (t->name == "string" or t->name == "basic_string")
+      return lt_string;
+    return lt_unknown;
+  }
+
+  // Whether a parameter of the given type can be passed a local of type t as it is.
+  bool takes(const jdi::ref_stack::parameter &p, ltype t)
+  {
+    if (p.variadic or p.def == enigma_type__var or p.def == enigma_type__variant or p.def == enigma_type__varargs)
+      return true;
+    if (!p.def or p.refs.size() > 1 or (p.refs.size() == 1 and p.refs.top().type != jdi::ref_stack::RT_REFERENCE))
+      return false;
+    return value_type(p.def) == t;
+  }
+
+  // Whether the given overload can be passed a local of type t as argument arg.
+  bool overload_takes(jdi::definition_function *f, size_t arg, ltype t)
+  {
+    if (f->referencers.empty() or f->referencers.top().type != jdi::ref_stack::RT_FUNCTION)
+      return false;
+    const jdi::ref_stack::parameter_ct &params = ((jdi::ref_stack::node_func*)&f->referencers.top())->params;
+    for (size_t i = 0; i < params.size(); i++)
+      if (i == arg or params[i].variadic or params[i].def == enigma_type__varargs)
+        return takes(params[i], t);
+    return false;
+  }
+
+  // Whether some overload of the named function can be passed a local of type t as argument arg.
+  bool function_takes(const string &name, size_t arg, ltype t)
+  {
+    jdi::definition *d = main_context->get_global()->look_up(name);
+    if (!d or !(d->flags & jdi::DEF_FUNCTION))
+      return true; // A script, or something else that takes var
+    jdi::definition_function *f = (jdi::definition_function*)d;
+    if (!f->template_overloads.empty() or overload_takes(f, arg, t))
+      return true;
+    for (jdi::definition_function::overload_iter it = f->overloads.begin(); it != f->overloads.end(); ++it)
+      if (overload_takes(it->second, arg, t))
+        return true;
+    return false;
+  }
+
+  ltype return_type(jdi::definition_function *f)
+  {
+    if (f->referencers.size() != 1 or f->referencers.top().type != jdi::ref_stack::RT_FUNCTION)
+      return lt_unknown;
+    return value_type(f->type);
+  }
+
+  // What a call to the named function returns, if every overload agrees.
+  ltype function_type(const string &name)
+  {
+    jdi::definition *d = main_context->get_global()->look_up(name);
+    if (!d or !(d->flags & jdi::DEF_FUNCTION))
+      return lt_unknown;
+    jdi::definition_function *f = (jdi::definition_function*)d;
+    if (!f->template_overloads.empty())
+      return lt_unknown;
+    const ltype t = return_type(f);
+    for (jdi::definition_function::overload_iter it = f->overloads.begin(); it != f->overloads.end(); ++it)
+      if (return_type(it->second) != t)
+        return lt_unknown;
+    return t;
+  }
+
+  // What the named global, constant, or shared local holds.
+  ltype name_type(const string &name)
+  {
+    if (name == "true" or name == "false")
+      return lt_real;
+    jdi::definition *d = main_context->get_global()->look_up(name);
+    if (!d)
+    {
+      jdi::definition *ns = main_context->get_global()->look_up("enigma");
+      if (ns and ns->flags & jdi::DEF_SCOPE)
+      {
+        jdi::definition *tier = ((jdi::definition_scope*)ns)->look_up(system_get_uppermost_tier());
+        for (jdi::definition_class *cs = tier and tier->flags & jdi::DEF_CLASS ? (jdi::definition_class*)tier : NULL; cs and !d;
+             cs = cs->ancestors.size() ? cs->ancestors[0].def : NULL) {
+          jdi::definition_scope::defiter mem = cs->members.find(name);
+          if (mem != cs->members.end())
+            d = mem->second;
+        }
+      }
+    }
+    if (!d or d->flags & (jdi::DEF_FUNCTION | jdi::DEF_TYPENAME) or !(d->flags & jdi::DEF_TYPED))
+      return lt_unknown;
+    if (!((jdi::definition_typed*)d)->referencers.empty())
+      return lt_unknown;
+    return value_type(((jdi::definition_typed*)d)->type);
+  }
+
+  struct local_type_inference
+  {
+    string &code, &synt;
+    map<string,local_candidate> locals;
+    vector<declaration> decls;
+
+    local_type_inference(string &c, string &s): code(c), synt(s) {}
+
+    pt skip_space(pt pos) const {
+      while (pos < synt.length() and synt[pos] == ' ') pos++;
+      return pos;
+    }
+    // Position of the last non-space character before pos, or npos.
+    pt last_before(pt pos) const {
+      while (pos > 0) if (synt[--pos] != ' ') return pos;
+      return string::npos;
+    }
+    pt matching_close(pt pos) const {
+      for (int depth = 0; pos < synt.length(); pos++)
+        if (synt[pos] == '(' or synt[pos] == '[') depth++;
+        else if ((synt[pos] == ')' or synt[pos] == ']') and !--depth)
+          return pos;
+      return pos;
+    }
+    // Whether the '=' at pos assigns, rather than compares.
+    bool assigns_at(pt pos) const {
+      if (synt[pos] != '=' or (pos + 1 < synt.length() and synt[pos+1] == '='))
+        return false;
+      if (!pos) return true;
+      const char p = synt[pos-1];
+      if (p == '=' or p == '!') return false;
+      if (p == '<' or p == '>') return pos >= 2 and synt[pos-2] == p;
+      return true;
+    }
+    bool ends_operand(pt pos) const {
+      const char c = synt[pos];
+      return c == 'n' or c == '0' or c == '"' or c == ')' or c == ']' or c == 'V';
+    }
+
+    // End of the expression beginning at pos: the first comma, semicolon, or brace outside brackets.
+    pt expression_end(pt pos) const
+    {
+      for (int depth = 0; pos < synt.length(); pos++)
+      {
+        const char c = synt[pos];
+        if (c == '(' or c == '[') depth++;
+        else if (c == ')' or c == ']') { if (!depth) return pos; depth--; }
+        else if (!depth and (c == ',' or c == ';' or c == '{' or c == '}' or assigns_at(pos))) return pos;
+      }
+      return pos;
+    }
+    // Start of the expression which ends at pos, found the same way.
+    pt expression_start(pt pos) const
+    {
+      for (int depth = 0; pos > 0; pos--)
+      {
+        const char c = synt[pos-1];
+        if (c == ')' or c == ']') depth++;
+        else if (c == '(' or c == '[') { if (!depth) return pos; depth--; }
+        else if (!depth and (c == ',' or c == ';' or c == '{' or c == '}' or assigns_at(pos-1) or strchr("psberf", c))) return pos;
+      }
+      return pos;
+    }
+
+    // Whether the expression around the mention at pos puts it through an operator only defined for
+    // integers: a bitwise or shift operator, or %. Brackets which only group are looked through.
+    bool meets_integer_operator(pt pos, pt len) const
+    {
+      pt b = expression_start(pos), e = expression_end(pos + len);
+      for (pt lb; b > 0 and synt[b-1] == '(' and e < synt.length() and synt[e] == ')'; )
+      {
+        if ((lb = last_before(b - 1)) != string::npos and (isalnum(synt[lb]) or strchr(")]\"", synt[lb])))
+          break; // A call, cast, or statement
+        b = expression_start(b - 1), e = expression_end(e + 1);
+      }
+      if (b >= 2 and assigns_at(b - 1) and strchr("%&|^<>", synt[b-2]))
+        return true; // The value of a compound assignment like |=
+      for (pt p = b; p < e; p++)
+      {
+        const char c = synt[p];
+        if (c == '(' or c == '[') {
+          const pt close = matching_close(p);
+          if (pos < p or pos > close) p = close;
+        }
+        else if (c == '%' or c == '~' or c == '^')
+          return true;
+        else if ((c == '|' or c == '&') and (p + 1 >= e or synt[p+1] != c) and (!p or synt[p-1] != c))
+          return true;
+        else if ((c == '<' or c == '>') and p + 1 < e and synt[p+1] == c)
+          return true;
+      }
+      return false;
+    }
+
+    // Whether the mention at pos is an argument to a function which can't be passed a local of type t.
+    bool passed_where_unfit(pt pos, ltype t) const
+    {
+      size_t arg = 0;
+      for (int depth = 0; pos > 0; pos--)
+      {
+        const char c = synt[pos-1];
+        if (c == ')' or c == ']') depth++;
+        else if (c == '[') { if (!depth) return false; depth--; }
+        else if (c == ',' and !depth) arg++;
+        else if (c == ';' or c == '{' or c == '}') return false;
+        else if (c == '(' and depth) depth--;
+        else if (c == '(')
+        {
+          const pt lb = last_before(pos - 1);
+          if (lb != string::npos and synt[lb] == 'n')
+          {
+            pt nb = lb;
+            while (nb > 0 and synt[nb-1] == 'n') nb--;
+            const pt bb = last_before(nb); // Members aren't looked up
+            return (bb == string::npos or synt[bb] != '.') and !function_takes(code.substr(nb, lb + 1 - nb), arg, t);
+          }
+          if (lb != string::npos and (isalnum(synt[lb]) or strchr(")]\"", synt[lb])))
+            return false; // A cast, a statement, or a call through an expression
+          arg = 0; // Only grouping; keep looking outward
+        }
+      }
+      return false;
+    }
+
+    ltype local_type(const string &name) const {
+      map<string,local_candidate>::const_iterator l = locals.find(name);
+      if (l == locals.end())
+        return name_type(name);
+      return l->second.type == lt_none ? lt_unknown : l->second.type;
+    }
+
+    // Type of a single operand, with no binary operators outside of brackets.
+    ltype operand_type(pt b, pt e) const
+    {
+      b = skip_space(b);
+      while (e > b and synt[e-1] == ' ') e--;
+      if (b >= e)
+        return lt_unknown;
+      const char c = synt[b];
+      if (c == '-' or c == '+' or c == '!' or c == '~' or c == 'c') // Unary operators and casts to double all give reals
+        return lt_real;
+      for (pt pos = b; pos < e; pos++)
+        if (synt[pos] == '(' or synt[pos] == '[')
+          pos = matching_close(pos);
+        else if (synt[pos] == '*' or synt[pos] == '/' or synt[pos] == '%' or synt[pos] == '@')
+          return lt_real;
+
+      if (c == '(')
+        return matching_close(b) == e - 1 ? expression_type(b + 1, e - 1) : lt_unknown;
+      const pt re = run_end(synt, b);
+      if (c == '0')
+        return re == e ? lt_real : lt_unknown;
+      if (c == '"')
+        return e == b + 1 ? lt_string : lt_unknown;
+      const pt after = skip_space(re);
+      const bool called = after < e and synt[after] == '(' and matching_close(after) == e - 1;
+      if (c == 't')
+      {
+        const string t = code.substr(b, re - b);
+        if (!called) return lt_unknown;
+        return t == "string" ? lt_string : is_arithmetic_type(t) ? lt_real : lt_unknown;
+      }
+      if (c == 'n')
+      {
+        const string name = code.substr(b, re - b);
+        if (re == e)
+          return local_type(name);
+        if (called and locals.find(name) == locals.end())
+          return function_type(name);
+      }
+      return lt_unknown;
+    }
+
+    // Type of the expression between b and e.
+    ltype expression_type(pt b, pt e) const
+    {
+      bool compares = false;
+      for (pt pos = b; pos < e; pos++)
+      {
+        const char c = synt[pos];
+        if (c == '(' or c == '[') { pos = matching_close(pos); continue; }
+        if (c == '?' or assigns_at(pos))
+          return lt_unknown;
+        if (pos + 1 < e and synt[pos+1] == '=' and strchr("+-*/%&|^", c))
+          return lt_unknown;
+        if (c == '=' or c == '<' or c == '>' or c == '&' or c == '|' or c == '^' or (c == '!' and pos + 1 < e and synt[pos+1] == '='))
+          compares = true; // Comparisons, logic, and bitwise operators all give reals, and bind looser than + and -
+      }
+      if (compares)
+        return lt_real;
+
+      ltype type = lt_none;
+      char op = 0;
+      pt term = b;
+      for (pt pos = b; pos <= e; pos++)
+      {
+        if (pos < e and (synt[pos] == '(' or synt[pos] == '[')) { pos = matching_close(pos); continue; }
+        if (pos < e and synt[pos] != '+' and synt[pos] != '-') continue;
+        if (pos < e)
+        {
+          const pt lb = last_before(pos);
+          if (lb == string::npos or lb < term or !ends_operand(lb)) continue; // Unary
+          if (pos + 1 < e and synt[pos+1] == synt[pos])
+            return lt_unknown; // Increment or decrement
+        }
+        const ltype t = operand_type(term, pos);
+        if (!op) type = t;
+        else if (op == '+') type = type == t and t != lt_unknown ? t : lt_unknown;
+        else type = type == lt_string or t == lt_string ? lt_unknown : lt_real; // var minus anything is a double
+        if (pos < e) op = synt[pos], term = pos + 1;
+      }
+      return type == lt_none ? lt_unknown : type;
+    }
+
+    // Finds every `var` declaration at the start of a statement, and the locals it names.
+    void find_declarations()
+    {
+      set<string> redeclared;
+      int depth = 0, paren = 0;
+      for (pt pos = 0; pos < synt.length(); pos++)
+      {
+        const char c = synt[pos];
+        if (c == '{') { depth++; continue; }
+        if (c == '}') { depth--; continue; }
+        if (c == '(') { paren++; continue; }
+        if (c == ')') { paren--; continue; }
+        if (c != 't' and c != 'n') continue;
+        const pt re = run_end(synt, pos);
+        if (c == 'n' or paren or code.substr(pos, re - pos) != "var") { pos = re - 1; continue; }
+        const pt lb = last_before(pos);
+        if (lb != string::npos and synt[lb] != ';' and synt[lb] != '{' and synt[lb] != '}') { pos = re - 1; continue; }
+
+        declaration d;
+        d.pos = pos, d.len = re - pos;
+        const int decl = decls.size();
+        pt np = skip_space(re);
+        while (np < synt.length() and synt[np] == 'n')
+        {
+          const pt ne = run_end(synt, np);
+          const string name = code.substr(np, ne - np);
+          d.names.push_back(name);
+          if (locals.find(name) != locals.end())
+            redeclared.insert(name);
+          local_candidate &l = locals[name];
+          l.decl = decl, l.name_pos = np;
+
+          pt next = skip_space(ne);
+          if (next < synt.length() and synt[next] == '=') {
+            l.initialized = true;
+            next = expression_end(next + 1);
+          }
+          else if (next >= synt.length() or (synt[next] != ',' and synt[next] != ';'))
+            l.type = lt_unknown, next = expression_end(next); // An array or something stranger
+          if (next < synt.length() and synt[next] == ',')
+            np = skip_space(next + 1);
+          else break;
+        }
+
+        // The local is visible until the block it was declared in is closed
+        pt se = re;
+        for (int d2 = depth; se < synt.length(); se++)
+          if (synt[se] == '{') d2++;
+          else if (synt[se] == '}' and --d2 < depth) break;
+        for (size_t i = 0; i < d.names.size(); i++)
+          locals[d.names[i]].scope_end = se;
+        decls.push_back(d);
+        pos = re - 1;
+      }
+      for (set<string>::iterator it = redeclared.begin(); it != redeclared.end(); it++)
+        locals[*it].type = lt_unknown;
+    }
+
+    // Collects every other mention of each local; a mention outside its scope means the name is shared with something else.
+    void find_uses()
+    {
+      for (pt pos = 0; pos < synt.length(); pos++)
+      {
+        if (synt[pos] != 'n') continue;
+        const pt re = run_end(synt, pos);
+        map<string,local_candidate>::iterator l = locals.find(code.substr(pos, re - pos));
+        const pt lb = last_before(pos);
+        if (l != locals.end() and pos != l->second.name_pos and (lb == string::npos or synt[lb] != '.'))
+        {
+          if (pos < l->second.name_pos or pos >= l->second.scope_end)
+            l->second.type = lt_unknown;
+          else
+            l->second.uses.push_back(pos);
+        }
+        pos = re - 1;
+      }
+    }
+
+    // Checks one mention of a local against the type it is believed to hold. When seeding, gives
+    // an untyped local the type of the first value it is given instead.
+    bool check_use(local_candidate &l, pt pos, pt len, bool seeding)
+    {
+      const pt next = skip_space(pos + len);
+      const char c = next < synt.length() ? synt[next] : 0, d = next + 1 < synt.length() ? synt[next+1] : 0;
+      const pt lb = last_before(pos);
+
+      if (c == '(' or c == '[' or c == '.')
+        return false;
+      ltype given = lt_none;
+      if ((c == '=' and d != '=') or (c == ':' and d == '='))
+        given = expression_type(next + 1 + (c == ':'), expression_end(next + 1 + (c == ':')));
+      else if (d == '=' and c == '+')
+        given = expression_type(next + 2, expression_end(next + 2));
+      else if ((d == '=' and strchr("%&|^", c)) or ((c == '<' or c == '>') and d == c))
+        return false; // These are only defined for integers, which a double local can't stand in for
+      else if ((d == '=' and strchr("-*/", c)) or ((c == '+' or c == '-') and d == c)
+           or (lb != string::npos and lb > 0 and (synt[lb] == '+' or synt[lb] == '-') and synt[lb-1] == synt[lb]))
+        given = lt_real;
+
+      if (given != lt_none)
+      {
+        if (seeding and l.type == lt_none and given != lt_unknown)
+          l.type = given;
+        return given == l.type or (seeding and given == lt_unknown);
+      }
+      if (seeding or l.type == lt_none)
+        return true;
+      if (meets_integer_operator(pos, len) or passed_where_unfit(pos, l.type))
+        return false;
+
+      // Anything else reads it. A real must not meet a string in the same expression;
+      // a string may only stand alone or be combined with other strings.
+      const pt b = expression_start(pos), e = expression_end(pos + len);
+      if (l.type == lt_real)
+      {
+        for (pt p = b; p < e; p++)
+          if (synt[p] == '(' or synt[p] == '[') p = matching_close(p);
+          else if (synt[p] == '"') return false;
+          else if (synt[p] == 'n' or synt[p] == 't') {
+            const pt pe = run_end(synt, p);
+            if (pe != pos + len and operand_type(p, pe == e or synt[skip_space(pe)] != '(' ? pe : matching_close(skip_space(pe)) + 1) == lt_string)
+              return false;
+            p = pe - 1;
+          }
+        return true;
+      }
+      if (skip_space(b) == pos and skip_space(pos + len) >= e)
+        return true;
+      if (expression_type(b, e) == lt_string)
+        return true;
+      for (pt p = b; p < e; p++) // A comparison of strings
+        if (synt[p] == '(' or synt[p] == '[') p = matching_close(p);
+        else if ((synt[p] == '=' or synt[p] == '!') and synt[p+1] == '=')
+          return expression_type(b, p) == lt_string and expression_type(p + 2, e) == lt_string;
+      return false;
+    }
+
+    bool check(const string &name, local_candidate &l, bool seeding)
+    {
+      for (size_t i = 0; i < l.uses.size(); i++)
+        if (!check_use(l, l.uses[i], name.length(), seeding))
+          return false;
+      if (l.initialized and !check_use(l, l.name_pos, name.length(), seeding))
+        return false;
+      return true;
+    }
+
+    map<string,string> run()
+    {
+      map<string,string> retyped;
+      find_declarations();
+      find_uses();
+
+      // Give each local the type of the first value it is given, until no more can be worked out
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+        for (map<string,local_candidate>::iterator it = locals.begin(); it != locals.end(); it++)
+          if (it->second.type == lt_none)
+          {
+            if (!check(it->first, it->second, true))
+              it->second.type = lt_unknown;
+            changed |= it->second.type != lt_none;
+          }
+      }
+      for (map<string,local_candidate>::iterator it = locals.begin(); it != locals.end(); it++)
+        if (it->second.type == lt_none) { // Never given anything that could type it; if it is only ever read, it only holds 0
+          it->second.type = lt_real;
+          if (!check(it->first, it->second, false))
+            it->second.type = lt_unknown;
+        }
+
+      // Then demote any local used in a way that doesn't fit, and any declared beside one, until none are left
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+        for (map<string,local_candidate>::iterator it = locals.begin(); it != locals.end(); it++)
+          if ((it->second.type == lt_real or it->second.type == lt_string) and !check(it->first, it->second, false))
+            it->second.type = lt_unknown, changed = true;
+        for (size_t i = 0; i < decls.size(); i++)
+        {
+          const ltype t = locals[decls[i].names.empty() ? string() : decls[i].names[0]].type;
+          for (size_t n = 0; n < decls[i].names.size(); n++)
+            if (locals[decls[i].names[n]].type != t)
+              for (size_t m = 0; m < decls[i].names.size(); m++)
+                if (locals[decls[i].names[m]].type != lt_unknown)
+                  locals[decls[i].names[m]].type = lt_unknown, changed = true;
+        }
+      }
+
+      // Rewrite the declarations from the back, so that earlier positions stay put
+      for (size_t i = decls.size(); i--; )
+      {
+        const declaration &d = decls[i];
+        if (d.names.empty()) continue;
+        const ltype t = locals[d.names[0]].type;
+        if (t != lt_real and t != lt_string) continue;
+        if (t == lt_real)
+          for (size_t n = d.names.size(); n--; )
+          {
+            const local_candidate &l = locals[d.names[n]];
+            if (l.initialized) continue;
+            const pt at = l.name_pos + d.names[n].length();
+            code.insert(at, "=0"), synt.insert(at, "=0");
+          }
+        const string tn = t == lt_real ? "double" : "string";
+        code.replace(d.pos, d.len, tn), synt.replace(d.pos, d.len, string(tn.length(), 't'));
+        for (size_t n = 0; n < d.names.size(); n++)
+          retyped[d.names[n]] = tn;
+      }
+      return retyped;
+    }
+  };
+}
+
+map<string,string> infer_local_types(string &code, string &synt)
+{
+  local_type_inference inference(code, synt);
+  return inference.run();
+}
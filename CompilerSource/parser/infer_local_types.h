@@ -0,0 +1,42 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef INFER_LOCAL_TYPES__H
+#define INFER_LOCAL_TYPES__H
+
+#include <map>
+#include <string>
+using namespace std;
+
+// Gives locals declared `var` in a piece of code a native type wherever that can be proven
+// from the code alone: `double` for a local that is only ever given reals, `string` for one
+// that is only ever given strings. A local that is indexed, reached with a dot, or assigned
+// anything whose type is unclear stays var. Runs between collect_variables and parser_secondary.
+// Returns each local it retyped, with the type it was given.
+map<string,string> infer_local_types(string &code, string &synt);
+
+#endif
@@ -29,6 +29,7 @@
 #define _OBJECT_STORAGE__H
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include "general/darray.h"
@@ -96,6 +97,9 @@ struct parsed_object
   map<string,int> funcs;        // Any function KEY called with at most VALUE parameters.
   map<string,int> dots;         // Any attribute KEY accessed via a dot, as in a.KEY
 
+  int argument_count;           // One more than the highest argumentN this code names; only meaningful for scripts.
+  set<int> arguments_modified;  // Any argumentN this code may assign to or otherwise change.
+
   vector<initpair> initializers; // Variables that need initialized in the constructor for this object
 
   typedef map<string,dectrip>::iterator locit;
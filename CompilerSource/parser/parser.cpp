@@ -167,9 +167,6 @@ string parser_main(string code, parsed_event* pev)
   //Reset things
     //Nothing to reset :trollface:
 
-  //Initialize us a spot in the global scope
-  initscope("script scope");
-
   if (pev) {
     pev->strc = 0; //Number of strings in this code
     parser_ready_input(code,synt,pev->strc,pev->strs);
@@ -348,12 +345,22 @@ int parser_secondary(string& code, string& synt,parsed_object* glob,parsed_objec
       
       if (true) // No member by this name can be accessed
       {
+        // The accessors take an instance directly when we already hold one, sparing the id lookup
+        string target, targetsynt;
+        if (exp == "other")
+          target = "enigma::instance_other", targetsynt = string(target.length(), 'n');
+        else if (exp == "self")
+          target = "(enigma::instance_event_iterator?enigma::instance_event_iterator->inst:NULL)",
+          targetsynt = "(" + string(31, 'n') + "?" + string(31, 'n') + "->nnnn:nnnn)";
+        else
+          target = "int(" + exp + ")", targetsynt = "ccc(" + expsynt + ")";
+
         string repstr;
         string repsyn;
         if (shared_object_locals.find(member) != shared_object_locals.end())
         {
-          repstr = "enigma::glaccess(int("   + exp +   "))->" + member;
-          repsyn = "nnnnnnnnnnnnnnnn(ccc(" + expsynt + "))->" + string(member.length(),'n');
+          repstr = "enigma::glaccess("   + target +   ")->" + member;
+          repsyn = "nnnnnnnnnnnnnnnn(" + targetsynt + ")->" + string(member.length(),'n');
         }
         else
         {
@@ -363,14 +370,14 @@ int parser_secondary(string& code, string& synt,parsed_object* glob,parsed_objec
           repstr += member;
           repsyn += string(member.length(),'n');
 
-          repstr += "(int(";
-          repsyn += "(ccc(";
+          repstr += "(";
+          repsyn += "(";
 
-          repstr += exp;
-          repsyn += expsynt;
+          repstr += target;
+          repsyn += targetsynt;
 
-          repstr += "))";
-          repsyn += "))";
+          repstr += ")";
+          repsyn += ")";
 
           add_dot_accessed_local(member);
         }
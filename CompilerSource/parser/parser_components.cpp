@@ -46,36 +46,30 @@ typedef size_t pt; //Use size_t as our pos type; helps on 64bit systems.
 map<string,char> edl_tokens; // Logarithmic lookup, with token.
 typedef map<string,char>::iterator tokiter;
 
-int scope_braceid = 0;
-extern string tostring(int);
-
-#include <Storage/definition.h>
-static jdi::definition_scope *current_scope;
+extern string tostring(int);
+
+#include <Storage/definition.h>
 
-int dropscope()
+// Scopes opened by the code being parsed hang off a script scope owned by that parse,
+// never off the global scope, so that any number of parses can run at once.
+int dropscope(jdi::definition_scope *&scope)
 {
-  if (current_scope != main_context->get_global())
-  current_scope = current_scope->parent;
-  return 0;
-}
-int quickscope()
-{
-  jdi::definition_scope* ns = new jdi::definition_scope("{}",current_scope,jdi::DEF_NAMESPACE);
-  current_scope->members["{}"+tostring(scope_braceid++)] = ns;
-  current_scope = ns;
+  if (scope->parent != main_context->get_global())
+  scope = scope->parent;
   return 0;
 }
-int initscope(string name)
+int quickscope(jdi::definition_scope *&scope, int &braceid)
 {
-  scope_braceid = 0;
-  main_context->get_global()->members[name] = current_scope = new jdi::definition_scope(name,main_context->get_global(),jdi::DEF_NAMESPACE);
+  jdi::definition_scope* ns = new jdi::definition_scope("{}",scope,jdi::DEF_NAMESPACE);
+  scope->members["{}"+tostring(braceid++)] = ns;
+  scope = ns;
   return 0;
 }
-int quicktype(unsigned flags, string name)
+int quicktype(jdi::definition_scope *scope, unsigned flags, string name)
 {
-  current_scope->members[name] = new jdi::definition(name,current_scope,flags | jdi::DEF_TYPENAME);
+  scope->members[name] = new jdi::definition(name,scope,flags | jdi::DEF_TYPENAME);
   return 0;
-}
+}
 
 #include <API/context.h>
 #include <System/macros.h>
@@ -94,6 +88,9 @@ int parser_ready_input(string &code,string &synt,unsigned int &strc, varray<stri
   unsigned mymacroind = 0;
   macro_stack_t mymacrostack;
   
+  jdi::definition_scope script_scope("script scope", main_context->get_global(), jdi::DEF_NAMESPACE), *current_scope = &script_scope;
+  int scope_braceid = 0;
+  
   for (;;)
   { if (pos >= code.length()) {
       if (mymacroind)
@@ -187,7 +184,7 @@ int parser_ready_input(string &code,string &synt,unsigned int &strc, varray<stri
       //Accurately reflect newly defined types and structures
       //These will be added as types now, but their innards will be ignored until ENIGMA "link"
       if (c == 'n' and last_token == 'C') { //"class <name>"
-        quicktype(jdi::DEF_CLASS, name); //Add the string we used to determine if this token is 'n' as a struct
+        quicktype(current_scope, jdi::DEF_CLASS, name); //Add the string we used to determine if this token is 'n' as a struct
       }
       
       last_token = c;
@@ -289,9 +286,9 @@ int parser_ready_input(string &code,string &synt,unsigned int &strc, varray<stri
     }
     
     if (code[pos] == '{')
-      quickscope();
+      quickscope(current_scope, scope_braceid);
     else if (code[pos] == '}')
-      dropscope();
+      dropscope(current_scope);
     
     //Wasn't anything usable
     if (!is_useless(code[pos]))
@@ -36,9 +36,9 @@ void parser_add_semicolons(string &code,string &synt);
 void print_the_fucker(string code,string synt);
 int parser_reinterpret(string&,string&);
 
-int dropscope();
-int quickscope();
-int initscope(string name);
-int quicktype(unsigned flags, string name);
+namespace jdi { struct definition_scope; }
+int dropscope(jdi::definition_scope *&scope);
+int quickscope(jdi::definition_scope *&scope, int &braceid);
+int quicktype(jdi::definition_scope *scope, unsigned flags, string name);
 
 
@@ -151,6 +151,8 @@ void parse_ide_settings(const char* eyaml)
   setting::use_incrementals = settree.get("inherit-increment-from").toInt();
   setting::use_gml_equals   =!settree.get("inherit-equivalence-from").toInt();
   setting::literal_autocast = settree.get("treat-literals-as").toInt();
+  const string report_graph = settree.get("report-script-graph");
+  setting::report_script_graph = report_graph == "on" or report_graph == "true" or atoi(report_graph.c_str());
   
   cout << "Setting up IDE editables... " << endl;
   requested_extensions.clear();
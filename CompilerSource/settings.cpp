@@ -42,6 +42,9 @@ namespace setting
   bool use_gml_equals = 0;   // Defines what language operator= is inherited from.   0 = C++,               1 = GML
   bool use_incrementals = 0; // Defines how operators ++ and -- are treated.         0 = GML,               1 = C++
   bool literal_autocast = 0; // Determines how literals are treated.                 0 = enigma::variant,   1 = C++ scalars
+  
+  //Diagnostics
+  bool report_script_graph = 0; // Print which scripts call which, as linked, to the compile log.
 };
 
 
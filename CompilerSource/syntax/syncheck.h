@@ -32,6 +32,7 @@ namespace syncheck
 {
   extern string syerr;
   int syntacheck(string code);
+  int syntacheck(string code, string &error); // Safe to call from several threads at once; the message goes to error instead of syerr
   void addscr(string name);
 }
 
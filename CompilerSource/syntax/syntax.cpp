@@ -167,7 +167,6 @@ namespace syncheck
   };
   
   string syerr;
-  vector<token> lex;
   
   struct open_parenth_info {
     unsigned ind;
@@ -176,13 +175,13 @@ namespace syncheck
     open_parenth_info() {}
     open_parenth_info(unsigned i, int ml, char type): ind(i), macrolevel(ml), type(type) {}
   };
-  pt pop_open_parenthesis(vector<open_parenth_info> &ops, vector<token>& lex, pt pos, int ind, char opener, string whathavewe) {
+  pt pop_open_parenthesis(vector<open_parenth_info> &ops, vector<token>& lex, pt pos, int ind, char opener, string whathavewe, string &error) {
     if (ops.empty()) {
-      syerr = "Unexpected " + whathavewe + ": None open."; return pos;
+      error = "Unexpected " + whathavewe + ": None open."; return pos;
     }
     const char p = ops[ops.size()-1].type;
     if (p != opener) {
-      syerr = "Expected closing " + string(p == '(' ? "parenthesis" : p == '[' ? "bracket" : p == '{' ? "brace" : "triangle bracket") + " before " + whathavewe;
+      error = "Expected closing " + string(p == '(' ? "parenthesis" : p == '[' ? "bracket" : p == '{' ? "brace" : "triangle bracket") + " before " + whathavewe;
       return pos;
     }
     const int oi = ops[ops.size()-1].ind;
@@ -202,16 +201,16 @@ namespace syncheck
   #define superPos (mymacroind ? mymacrostack[0].pos : pos)
   #define ptrace() for (unsigned i = 0; i < lex.size(); i++) cout << (string)lex[i] << "\t\t" << endl
   #define lexlast (lex.size()-1)
-  int syntacheck(string code)
+  int syntacheck(string code, string &error)
   {
     pt pos = 0;
     unsigned mymacroind = 0;
     macro_stack_t mymacrostack;
-    lex.clear(); 
+    vector<token> lex;
     lex.push_back(token(TT_IMPLICIT_SEMICOLON, ";", superPos, 0, true, false, false, mymacroind));
           
     
-    syerr = "No error";
+    error = "No error";
     vector<open_parenth_info> open_parenths; // Any open brace, bracket, or parenthesis
     
     // First, collapse everything into a massive lex vector, 
@@ -262,11 +261,11 @@ namespace syncheck
         if (is_wordop(name)) { //this is actually a word-based operator, such as `and', `or', and `not' 
           bool unary = name[0] == 'n'; //not is the only unary word operator.
           if (unary and (!lex[lexlast].separator and !lex[lexlast].operatorlike)) {
-            syerr = "Unexpected unary keyword `not'";
+            error = "Unexpected unary keyword `not'";
             return pos;
           }
           if (!unary and (!lex.size() or lex[lexlast].separator or lex[lexlast].operatorlike)) {
-            syerr = "Expected primary expression before `" + name + "' operator";
+            error = "Expected primary expression before `" + name + "' operator";
             return pos;
           }
           lex.push_back(token(unary ? TT_UNARYPRE : TT_OPERATOR, name, superPos, name.length(), false, false, true, mymacroind));
@@ -316,7 +315,7 @@ namespace syncheck
               else if (lex[lexlast].type != TT_S_ELSE and lex[lexlast].type != TT_S_TRY)
               {
                 ptrace();
-                syerr = "Unexpected `" + name + "' statement at this point";
+                error = "Unexpected `" + name + "' statement at this point";
                 return superPos;
               }
             }
@@ -351,7 +350,7 @@ namespace syncheck
             if (code[pos+1] == '=')
               lex.push_back(token(TT_ASSOP, ":", superPos, 2, true, false, false, mymacroind)), pos += 2;
             else if (code[pos+1] == ':') {
-              return (syerr = "Cannot handle :: with current parser configuration. Oops.", superPos);
+              return (error = "Cannot handle :: with current parser configuration. Oops.", superPos);
               
               lex.push_back(token(TT_SCOPEACCESS, "::", superPos, 2, false, false, true, mymacroind)), pos += 2;
             }
@@ -364,7 +363,7 @@ namespace syncheck
         case '$': {
             const pt spos = pos;
             if (!is_hexdigit(code[++pos])) {
-              syerr = "Hexadecimal literal expected after '$' symbol";
+              error = "Hexadecimal literal expected after '$' symbol";
               return superPos;
             }
             while (is_hexdigit(code[++pos]));
@@ -374,30 +373,30 @@ namespace syncheck
         pt open_error;
         case '{':
             if (lex[lexlast].type == TT_OPERATOR)
-              return (syerr = "Expected secondary expression before brace", superPos);
+              return (error = "Expected secondary expression before brace", superPos);
             lex.push_back(token(TT_BEGINBRACE, "{", superPos, 1, true, false, false, mymacroind));
             open_parenths.push_back(open_parenth_info(lexlast, mymacroind, '{'));
           pos++; continue;
         case '}':
             if (lex[lexlast].operatorlike)
-              return (syerr = "Expected identifier before closing brace", superPos);
+              return (error = "Expected identifier before closing brace", superPos);
             if (open_parenths.size())
               lex.push_back(token(TT_ENDBRACE, open_parenths[open_parenths.size()-1].ind, "}", superPos, 1, true, false, false, mymacroind));
-            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '{', "closing brace");
+            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '{', "closing brace", error);
             if (open_error != pt(-1)) return open_error;
           pos++; continue;
         case '[':
             if (lex[lexlast].operatorlike)
-              return (syerr = "Expected identifier before bracket; ENIGMA arrays not yet implemented", superPos);
+              return (error = "Expected identifier before bracket; ENIGMA arrays not yet implemented", superPos);
             lex.push_back(token(TT_BEGINBRACKET, "[", superPos, 1, true, false, true, mymacroind));
             open_parenths.push_back(open_parenth_info(lexlast, mymacroind, '['));
           pos++; continue;
         case ']':
             if (lex[lexlast].operatorlike and lex[lexlast].type != TT_BEGINBRACKET)
-              return (syerr = "Expected secondary expression before closing bracket", superPos);
+              return (error = "Expected secondary expression before closing bracket", superPos);
             if (open_parenths.size())
               lex.push_back(token(TT_ENDBRACKET, open_parenths[open_parenths.size()-1].ind, "]",superPos, 1, false, true, false, mymacroind));
-            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '[', "closing bracket");
+            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '[', "closing bracket", error);
             if (open_error != pt(-1)) return open_error;
           pos++; continue;
         case '(':
@@ -406,10 +405,10 @@ namespace syncheck
           pos++; continue;
         case ')':
             if (lex[lexlast].operatorlike and lex[lexlast].type != TT_BEGINPARENTH)
-              return (syerr = "Expected secondary expression before closing parenthesis", superPos);
+              return (error = "Expected secondary expression before closing parenthesis", superPos);
             if (open_parenths.size())
               lex.push_back(token(TT_ENDPARENTH, open_parenths[open_parenths.size()-1].ind, ")", superPos, 1, false, lex[lexlast].type != TT_TYPE_NAME, false, mymacroind));
-            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '(', "closing parenthesis");
+            open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '(', "closing parenthesis", error);
             if (open_error != pt(-1)) return open_error;
           pos++; continue;
         
@@ -423,7 +422,7 @@ namespace syncheck
             if (setting::use_cpp_escapes)
               while (code[++pos]!='"') {
                 if (pos >= code.length()) {
-                  syerr = "Unclosed double quote at this point";
+                  error = "Unclosed double quote at this point";
                   return superPos;
                 }
                 if (code[pos] == '\\')
@@ -438,7 +437,7 @@ namespace syncheck
             if (setting::use_cpp_escapes)
               while (code[++pos] != '\'') {
                 if (pos >= code.length()) {
-                  syerr = "Unclosed quote at this point";
+                  error = "Unclosed quote at this point";
                   return superPos;
                 }
                 if (code[pos] == '\\')
@@ -451,7 +450,7 @@ namespace syncheck
         
         case '?':
             if (!lex.size() or lex[lexlast].separator or lex[lexlast].operatorlike) {
-              syerr = "Primary expression expected before ternary operator";
+              error = "Primary expression expected before ternary operator";
               return superPos;
             }
             lex.push_back(token(TT_TERNARY, "?", superPos, 1, false, true, true, mymacroind));
@@ -488,14 +487,14 @@ namespace syncheck
               } else;
             else if (open_parenths.size() && open_parenths[open_parenths.size()-1].type == '<') {
               lex.push_back(token(TT_ENDTRIANGLE, ">", superPos, 1, false, false, false, mymacroind)), pos++;
-              open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '<', "closing triangle bracket");
+              open_error = pop_open_parenthesis(open_parenths, lex, superPos, lexlast, '<', "closing triangle bracket", error);
               if (open_error != pt(-1)) return open_error;
               pos++; continue;
             }
         case '&': case '|': case '^':
             if (!lex.size() or lex[lexlast].separator or lex[lexlast].operatorlike) {
               if (code[pos] != '&') {
-                syerr = "Expected primary expression before operator";
+                error = "Expected primary expression before operator";
                 return superPos;
               }
               lex.push_back(token(TT_UNARYPRE, code.substr(pos,1), superPos, 1, false, false, true, mymacroind)), ++pos;
@@ -522,7 +521,7 @@ namespace syncheck
             }
         case '%': 
             if (!lex.size() or lex[lexlast].separator or lex[lexlast].operatorlike) {
-              syerr = "Primary expression expected before operator";
+              error = "Primary expression expected before operator";
               return superPos;
             }
             if (code[pos+1] == '=')
@@ -541,32 +540,32 @@ namespace syncheck
               lex.push_back(token(TT_UNARYPRE, code.substr(pos,1), superPos, 1, false, false, true, mymacroind)), ++pos; // ~ !
             else {
               ptrace();
-              syerr = "Unexpected unary operator at this point";
+              error = "Unexpected unary operator at this point";
               return superPos;
             }
           break;
         
         case '=':
             if (!lex.size() or lex[lexlast].separator or lex[lexlast].operatorlike) {
-              syerr = "Primary expression expected before operator";
+              error = "Primary expression expected before operator";
               return superPos;
             }
             if (lex[lexlast].type == TT_OPERATOR) {
-              syerr = "Unexpected = at this point.";
+              error = "Unexpected = at this point.";
               return superPos;
             }
             sz = (code[pos+1] == '=') + 1;
             lex.push_back(token(sz==2 ? TT_OPERATOR : TT_ASSOP, string(sz,'='), superPos, sz, false, false, true, mymacroind)), pos += sz; 
           break;
         default:
-            syerr = "Unexpected symbol `" + code.substr(pos,1) + "': unknown to compiler";
+            error = "Unexpected symbol `" + code.substr(pos,1) + "': unknown to compiler";
           return superPos;
       }
     }
     
     if (open_parenths.size()) {
       const char p = open_parenths.rbegin()->type;
-      syerr = "Unterminated " + string (p == '(' ? "parenthesis" : p == '[' ? "bracket" : p == '{' ? "brace" : "triangle bracket")
+      error = "Unterminated " + string (p == '(' ? "parenthesis" : p == '[' ? "bracket" : p == '{' ? "brace" : "triangle bracket")
               + " at this point";
       return lex[open_parenths.rbegin()->ind].pos;
     }
@@ -579,9 +578,9 @@ namespace syncheck
           if (lex[i+1].type == TT_BEGINPARENTH)
           {
             #ifndef WRITE_UNIMPLEMENTED_TXT
-            syerr = "Unknown function or script `" + lex[i].content + "'";
+            error = "Unknown function or script `" + lex[i].content + "'";
             if (lex[lex[i+1].match+1].type == TT_DECIMAL)
-              syerr += ": use semicolon to separate object ID and variable name.";
+              error += ": use semicolon to separate object ID and variable name.";
             return lex[i].pos;
             #else
              unimplemented_function_list[lex[i].content] = 'U';
@@ -592,9 +591,9 @@ namespace syncheck
           if (lex[i+1].type != TT_BEGINPARENTH)
           {
             if (lex[i+1].type == TT_ASSOP)
-              return (syerr = "Invalid assignment to function `" + lex[i].content + "'", lex[i+1].pos);
+              return (error = "Invalid assignment to function `" + lex[i].content + "'", lex[i+1].pos);
             if (lex[i+1].type == TT_ASSOP)
-              return (syerr = "Invalid operation on function `" + lex[i].content + "'", lex[i+1].pos);
+              return (error = "Invalid operation on function `" + lex[i].content + "'", lex[i+1].pos);
             continue;
           }
           else
@@ -619,12 +618,12 @@ namespace syncheck
             #ifndef WRITE_UNIMPLEMENTED_TXT
             if (!referencers_varargs(((jdi::definition_function*)lex[i].ext)->referencers)) {
               if (exceeded_at)
-                return (syerr = "Too many arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", allowed " + tostring(maxarg) + ".", lex[exceeded_at].pos);
+                return (error = "Too many arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", allowed " + tostring(maxarg) + ".", lex[exceeded_at].pos);
               if (params > maxarg)
-                return (syerr = "Too many arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", allowed " + tostring(maxarg) + ".", lex[lm].pos);
+                return (error = "Too many arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", allowed " + tostring(maxarg) + ".", lex[lm].pos);
             }
             if (params < minarg)
-              return (syerr = "Too few arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", required " + tostring(minarg) + ".", lex[lm].pos);
+              return (error = "Too few arguments to function `" + lex[i].content + "': provided " + tostring(params) + ", required " + tostring(minarg) + ".", lex[lm].pos);
             
             #else
                  if (!lex[i].ext->refstack.is_varargs() && (exceeded_at || params > maxarg))
@@ -640,5 +639,9 @@ namespace syncheck
     
     return -1;
   }
+  
+  int syntacheck(string code) {
+    return syntacheck(code, syerr);
+  }
 }
 
@@ -25,6 +25,8 @@
 using std::string;
 #include "as_basic.h"
 #include "Audio_Systems/audio_mandatory.h"
+#include "Audio_Systems/voice_pool.h"
+#include "Universal_System/resource_registry.h"
 
 #ifdef __APPLE__
 #include "../../../additional/alure/include/AL/alure.h"
@@ -51,23 +53,28 @@ namespace enigma
   };
   struct sound
   {
-    ALuint src, buf[3]; // The source-id and buffer-id of the sound data
+    ALuint buf[3]; // The buffer-id of the sound data
     alureStream *stream; // optional stream
     void (*cleanup)(void *userdata); // optional cleanup callback for streams
     void *userdata; // optional userdata for streams
     void (*seek)(void *userdata, float position); // optional seeking shits
 
-    load_state loaded;   // Degree to which this sound has been loaded successfully
-    bool idle;    // True if this sound is not being used, false if playing or paused.
-    bool playing; // True if this sound is playing; not paused or idle.
+    load_state loaded; // Degree to which this sound has been loaded successfully
+    float volume, pan; // Applied to each voice as it starts, and to voices already playing when changed
 
-    sound(): src(0), stream(0), cleanup(0), userdata(0), seek(0), loaded(LOADSTATE_NONE), idle(1), playing(0) {
+    sound(): stream(0), cleanup(0), userdata(0), seek(0), loaded(LOADSTATE_NONE), volume(1), pan(.5) {
       buf[0] = 0; buf[1] = 0; buf[2] = 0;
     }
   };
 
-  sound **sounds;
   extern size_t sound_idmax;
+  resource_registry<sound> sounds(sound_idmax);
+
+  // Sounds do not own a source; every playing instance borrows one of these.
+  voice_pool voices;
+  ALuint *voice_sources;
+  bool *voice_paused;
+  const int voice_max = 32;
 
   #ifdef DEBUG_MODE
     #define get_sound(snd,id,failure)\
@@ -80,20 +87,38 @@ namespace enigma
       enigma::sound *const snd = enigma::sounds[id];
   #endif
 
-  static void eos_callback(void *soundID, ALuint src)
+  #define get_voice(slot,handle,failure)\
+    const int slot = enigma::voices.slot_of(handle);\
+    if (slot == -1) return failure;
+
+  #define for_each_voice_of(slot,id)\
+    for (int slot = 0; slot < enigma::voices.size(); slot++)\
+      if (enigma::voices[slot].sound == (id))
+
+  static void eos_callback(void *voice, ALuint src)
   {
-    get_sound(snd, (ptrdiff_t)soundID, );
-    snd->playing = false;
-    snd->idle = true;
+    const int slot = voices.slot_of((ptrdiff_t)voice);
+    if (slot != -1)
+      voices.release(slot);
+  }
+
+  static void voice_apply(int slot, const sound *snd)
+  {
+    const float pan = snd->pan*2-1;
+    alSourcef(voice_sources[slot], AL_GAIN, snd->volume);
+    alSource3f(voice_sources[slot], AL_POSITION, pan, sqrt(1-pan*pan), 0);
+  }
+
+  static void voice_stop(int slot)
+  {
+    alureStopSource(voice_sources[slot], AL_FALSE);
+    voices.release(slot);
   }
 
   int audiosystem_initialize()
   {
     printf("Initializing audio system...\n");
-    if (sound_idmax == 0)
-      sounds = NULL;
-    else
-      sounds = new sound*[sound_idmax];
+    sounds.init();
 
     #ifdef _WIN32
     if (!load_al_dll())
@@ -111,20 +136,28 @@ namespace enigma
     for (size_t i = 0; i < sound_idmax; i++)
       sounds[i] = NULL;
 
+    // Devices may cap the number of sources; keep however many we were given.
+    voice_sources = new ALuint[voice_max];
+    voice_paused = new bool[voice_max];
+    int count = 0;
+    alGetError();
+    for (; count < voice_max; count++) {
+      alGenSources(1, voice_sources + count);
+      if (alGetError() != AL_NO_ERROR)
+        break;
+      alSourcei(voice_sources[count], AL_SOURCE_RELATIVE, AL_TRUE);
+      alSourcei(voice_sources[count], AL_REFERENCE_DISTANCE, 1);
+      voice_paused[count] = false;
+    }
+    if (!count)
+      fprintf(stderr, "Failed to create any OpenAL sources; sounds will not play.\n");
+    voices.resize(count);
+
     return 0;
   }
 
-  static sound* sound_new_with_source() {
+  static sound* sound_new() {
     sound *res = new sound();
-    alGetError();
-    alGenSources(1, &res->src);
-    int a = alGetError();
-    if(a != AL_NO_ERROR) {
-      fprintf(stderr, "Failed to create OpenAL source! Error %d: %s\n",a,alGetString(a));
-      printf("%d %d %d %d %d\n",AL_INVALID_NAME,AL_INVALID_ENUM,AL_INVALID_VALUE,AL_INVALID_OPERATION,AL_OUT_OF_MEMORY);
-      delete res;
-      return NULL;
-    }
     res->loaded = LOADSTATE_SOURCED;
     return res;
   }
@@ -133,7 +166,7 @@ namespace enigma
   {
     sound *snd = sounds[id];
     if (!snd)
-      snd = sounds[id] = sound_new_with_source();
+      snd = sounds[id] = sound_new();
     if (snd->loaded != LOADSTATE_SOURCED) {
       fprintf(stderr, "Could not load sound %d: %s\n", id, alureGetErrorString());
       return 1;
@@ -146,9 +179,6 @@ namespace enigma
       fprintf(stderr, "Could not load sound %d: %s\n", id, alureGetErrorString());
       return 2;
     }
-    alSourcei(snd->src, AL_BUFFER, buf);
-    alSourcei(snd->src, AL_SOURCE_RELATIVE, AL_TRUE);
-    alSourcei(snd->src, AL_REFERENCE_DISTANCE, 1);
     snd->loaded = LOADSTATE_COMPLETE;
     return 0;
   }
@@ -158,7 +188,7 @@ namespace enigma
   {
     sound *snd = sounds[id];
     if (!snd)
-      snd = sounds[id] = sound_new_with_source();
+      snd = sounds[id] = sound_new();
     if (snd->loaded != LOADSTATE_SOURCED)
       return 1;
 
@@ -177,37 +207,67 @@ namespace enigma
 
   int sound_allocate()
   {
-    // Make room for sound
-    sound **nsounds = new sound*[sound_idmax+1];
-    for (size_t i = 0; i < sound_idmax; i++)
-      nsounds[i] = sounds[i];
-    nsounds[sound_idmax] = sound_new_with_source();
-    delete[] sounds;
-    sounds = nsounds;
-    return sound_idmax++;
+    const int id = sounds.claim();
+    sounds[id] = sound_new();
+    return id;
   }
 
   void audiosystem_update(void) { alureUpdate(); }
 
+  // Starts a new instance of the sound, stealing a voice if none are free.
+  static int sound_start(int id, bool loop, int priority)
+  {
+    get_sound(snd,id,-1);
+    if (snd->loaded != LOADSTATE_COMPLETE)
+      return -1;
+
+    // A stream has a single read position, so it can only ever occupy one voice.
+    if (snd->stream)
+      for_each_voice_of(v, id)
+        voice_stop(v);
+
+    bool stolen;
+    const int slot = voices.allocate(id, priority, stolen);
+    if (slot == -1)
+      return -1;
+    if (stolen)
+      alureStopSource(voice_sources[slot], AL_FALSE);
+
+    const ALuint src = voice_sources[slot];
+    const int handle = voices.handle(slot);
+    voice_paused[slot] = false;
+    voice_apply(slot, snd);
+
+    ALboolean started;
+    if (snd->stream) {
+      alSourcei(src, AL_LOOPING, AL_FALSE);
+      started = alurePlaySourceStream(src, snd->stream, 3, loop ? -1 : 0, eos_callback, (void*)(ptrdiff_t)handle);
+    }
+    else {
+      alSourcei(src, AL_BUFFER, snd->buf[0]);
+      alSourcei(src, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
+      started = alurePlaySource(src, eos_callback, (void*)(ptrdiff_t)handle);
+    }
+    if (started == AL_FALSE) {
+      voices.release(slot);
+      return -1;
+    }
+    return handle;
+  }
+
   void audiosystem_cleanup()
   {
+    for (int v = 0; v < voices.size(); v++)
+      alureStopSource(voice_sources[v], AL_FALSE);
+    alDeleteSources(voices.size(), voice_sources);
+
     for (size_t i = 0; i < sound_idmax; i++)
-    if (sounds[i])
+    if (sounds[i] and sounds[i]->loaded == LOADSTATE_COMPLETE)
     {
-      switch (sounds[i]->loaded)
-      {
-        case LOADSTATE_COMPLETE:
-          alDeleteBuffers(sounds[i]->stream ? 3 : 1, sounds[i]->buf);
-          if (sounds[i]->stream) {
-            alureStopSource(sounds[i]->src, true);
-            alureDestroyStream(sounds[i]->stream, 0, 0);
-            if (sounds[i]->cleanup) sounds[i]->cleanup(sounds[i]->userdata);
-          }
-          // fallthrough
-        case LOADSTATE_SOURCED:
-          alDeleteSources(1, &sounds[i]->src);
-          break;
-        default: ;
+      alDeleteBuffers(sounds[i]->stream ? 3 : 1, sounds[i]->buf);
+      if (sounds[i]->stream) {
+        alureDestroyStream(sounds[i]->stream, 0, 0);
+        if (sounds[i]->cleanup) sounds[i]->cleanup(sounds[i]->userdata);
       }
     }
 
@@ -220,58 +280,63 @@ bool sound_exists(int sound)
     return unsigned(sound) < enigma::sound_idmax && bool(enigma::sounds[sound]);
 }
 
-bool sound_play(int sound) // Returns whether sound is playing
+int sound_play(int sound) // Returns a handle to the new voice, or -1
 {
-  get_sound(snd,sound,0); //snd.looping = false;
-  alSourcei(snd->src, AL_LOOPING, AL_FALSE); //Just playing
-  return !(snd->idle = !(snd->playing = !snd->stream ?
-    alurePlaySource(snd->src, enigma::eos_callback, (void*)(ptrdiff_t)sound) != AL_FALSE :
-    alurePlaySourceStream(snd->src, snd->stream, 3, -1, enigma::eos_callback, (void*)(ptrdiff_t)sound) != AL_FALSE));
+  return enigma::sound_start(sound, false, 0);
 }
-bool sound_loop(int sound) // Returns whether sound is playing
+int sound_loop(int sound) // Returns a handle to the new voice, or -1
 {
-  get_sound(snd,sound,0);
-  alSourcei(snd->src, AL_LOOPING, AL_TRUE); // Toggle on looping
-  return snd->idle = !(snd->playing = (alurePlaySource(snd->src, enigma::eos_callback, (void*)(ptrdiff_t)sound) != AL_FALSE));
+  return enigma::sound_start(sound, true, 0);
+}
+int sound_play_priority(int sound, int priority, bool loop)
+{
+  return enigma::sound_start(sound, loop, priority);
 }
 bool sound_pause(int sound) // Returns whether the sound is still playing
 {
   get_sound(snd,sound,0);
-  return snd->playing = !alurePauseSource(snd->src);
+  for_each_voice_of(v, sound)
+    if (!enigma::voice_paused[v])
+      enigma::voice_paused[v] = alurePauseSource(enigma::voice_sources[v]);
+  return sound_isplaying(sound);
 }
 void sound_pause_all()
 {
-  for(size_t i = 0;i < enigma::sound_idmax;i++) {
-    if(enigma::sounds[i] && enigma::sounds[i]->src && enigma::sounds[i]->playing)
-      enigma::sounds[i]->playing = !alurePauseSource(enigma::sounds[i]->src);
-  }
+  for (int v = 0; v < enigma::voices.size(); v++)
+    if (enigma::voices[v].sound != -1 and !enigma::voice_paused[v])
+      enigma::voice_paused[v] = alurePauseSource(enigma::voice_sources[v]);
 }
 void sound_stop(int sound) {
   get_sound(snd,sound,);
-  alureStopSource(snd->src,AL_FALSE);
-  snd->playing = false;
+  for_each_voice_of(v, sound)
+    enigma::voice_stop(v);
   if (snd->seek)
     snd->seek(snd->userdata, 0);
 }
 void sound_stop_all()
 {
-  for(size_t i = 0;i < enigma::sound_idmax;i++) {
-    alureStopSource(enigma::sounds[i]->src,AL_FALSE);
-    enigma::sounds[i]->playing = false;
-    if (enigma::sounds[i]->seek)
+  for (int v = 0; v < enigma::voices.size(); v++)
+    if (enigma::voices[v].sound != -1)
+      enigma::voice_stop(v);
+  for(size_t i = 0;i < enigma::sound_idmax;i++)
+    if (enigma::sounds[i] && enigma::sounds[i]->seek)
         enigma::sounds[i]->seek(enigma::sounds[i]->userdata,0);
-  }
 }
 void sound_delete(int sound) {
   get_sound(snd,sound,);
+  for_each_voice_of(v, sound)
+    enigma::voice_stop(v);
+  if (snd->loaded == enigma::LOADSTATE_COMPLETE)
+    alDeleteBuffers(snd->stream ? 3 : 1, snd->buf);
   alureDestroyStream(snd->stream, 0, 0);
-  alDeleteSources(1,&snd->src);
   delete enigma::sounds[sound];
-  enigma::sounds[sound] = NULL;
+  enigma::sounds.release(sound);
 }
 void sound_volume(int sound, float volume) {
     get_sound(snd,sound,);
-    alSourcef(snd->src, AL_GAIN, volume);
+    snd->volume = volume;
+    for_each_voice_of(v, sound)
+      alSourcef(enigma::voice_sources[v], AL_GAIN, volume);
 }
 void sound_global_volume(float mastervolume) {
     alListenerf(AL_GAIN, mastervolume);
@@ -279,28 +344,41 @@ void sound_global_volume(float mastervolume) {
 bool sound_resume(int sound) // Returns whether the sound is playing
 {
   get_sound(snd,sound,false);
-  return snd->playing = alureResumeSource(snd->src);
+  for_each_voice_of(v, sound)
+    if (enigma::voice_paused[v])
+      enigma::voice_paused[v] = !alureResumeSource(enigma::voice_sources[v]);
+  return sound_isplaying(sound);
 }
 void sound_resume_all()
 {
-  for(size_t i = 0;i < enigma::sound_idmax;i++) {
-    if(enigma::sounds[i] && enigma::sounds[i]->src && !enigma::sounds[i]->playing)
-      enigma::sounds[i]->playing = alureResumeSource(enigma::sounds[i]->src);
-  }
+  for (int v = 0; v < enigma::voices.size(); v++)
+    if (enigma::voices[v].sound != -1 and enigma::voice_paused[v])
+      enigma::voice_paused[v] = !alureResumeSource(enigma::voice_sources[v]);
 }
 bool sound_isplaying(int sound) {
   get_sound(snd,sound,false);
-  return snd->playing;
+  for_each_voice_of(v, sound)
+    if (!enigma::voice_paused[v])
+      return true;
+  return false;
 }
 bool sound_ispaused(int sound) {
-  return !enigma::sounds[sound]->idle and !enigma::sounds[sound]->playing;
+  get_sound(snd,sound,false);
+  bool paused = false;
+  for_each_voice_of(v, sound) {
+    if (!enigma::voice_paused[v])
+      return false;
+    paused = true;
+  }
+  return paused;
 }
 
 void sound_pan(int sound, float value)
 {
   get_sound(snd,sound,);
-  const float pan = value*2-1;
-  alSource3f(snd->src,AL_POSITION,pan,sqrt(1-pan*pan),0);
+  snd->pan = value;
+  for_each_voice_of(v, sound)
+    enigma::voice_apply(v, snd);
 }
 float sound_get_length(int sound) { // Not for Streams
   get_sound(snd,sound,0);
@@ -313,25 +391,78 @@ float sound_get_length(int sound) { // Not for Streams
 
   return size / channels / (bits/8) / (float)freq;
 }
-float sound_get_position(int sound) { // Not for Streams
+float sound_get_position(int sound) { // Not for Streams; reports the most recently started voice
   get_sound(snd,sound,-1);
-  float offset;
+  int latest = -1;
+  for_each_voice_of(v, sound)
+    if (latest == -1 or enigma::voices[v].started > enigma::voices[latest].started)
+      latest = v;
+  if (latest == -1)
+    return 0;
 
-  alGetSourcef(snd->src, AL_SEC_OFFSET, &offset);
+  float offset;
+  alGetSourcef(enigma::voice_sources[latest], AL_SEC_OFFSET, &offset);
   return offset;
 }
 void sound_seek(int sound, float position) {
   get_sound(snd,sound,);
-  alSourcef(snd->src, AL_SEC_OFFSET, position); // Non Streams
+  for_each_voice_of(v, sound)
+    alSourcef(enigma::voice_sources[v], AL_SEC_OFFSET, position); // Non Streams
   if (snd->seek) snd->seek(snd->userdata, position); // Streams
 }
 void sound_seek_all(float position) {
-  for(size_t i = 0;i < enigma::sound_idmax;i++) {
-    if(enigma::sounds[i] && enigma::sounds[i]->src) {
-      alSourcef(enigma::sounds[i]->src, AL_SEC_OFFSET, position); // Non Streams
-      if (enigma::sounds[i]->seek) enigma::sounds[i]->seek(enigma::sounds[i]->userdata, position); // Streams
-    }
-  }
+  for (int v = 0; v < enigma::voices.size(); v++)
+    if (enigma::voices[v].sound != -1)
+      alSourcef(enigma::voice_sources[v], AL_SEC_OFFSET, position); // Non Streams
+  for(size_t i = 0;i < enigma::sound_idmax;i++)
+    if (enigma::sounds[i] && enigma::sounds[i]->seek)
+      enigma::sounds[i]->seek(enigma::sounds[i]->userdata, position); // Streams
+}
+
+bool sound_voice_exists(int voice) {
+  return enigma::voices.slot_of(voice) != -1;
+}
+int sound_voice_get_sound(int voice) {
+  get_voice(slot,voice,-1);
+  return enigma::voices[slot].sound;
+}
+void sound_voice_stop(int voice) {
+  get_voice(slot,voice,);
+  enigma::voice_stop(slot);
+}
+bool sound_voice_pause(int voice) {
+  get_voice(slot,voice,false);
+  if (!enigma::voice_paused[slot])
+    enigma::voice_paused[slot] = alurePauseSource(enigma::voice_sources[slot]);
+  return !enigma::voice_paused[slot];
+}
+bool sound_voice_resume(int voice) {
+  get_voice(slot,voice,false);
+  if (enigma::voice_paused[slot])
+    enigma::voice_paused[slot] = !alureResumeSource(enigma::voice_sources[slot]);
+  return !enigma::voice_paused[slot];
+}
+bool sound_voice_isplaying(int voice) {
+  get_voice(slot,voice,false);
+  return !enigma::voice_paused[slot];
+}
+void sound_voice_volume(int voice, float volume) {
+  get_voice(slot,voice,);
+  alSourcef(enigma::voice_sources[slot], AL_GAIN, volume);
+}
+void sound_voice_pan(int voice, float value) {
+  get_voice(slot,voice,);
+  const float pan = value*2-1;
+  alSource3f(enigma::voice_sources[slot], AL_POSITION, pan, sqrt(1-pan*pan), 0);
+}
+int sound_voice_count() {
+  int count = 0;
+  for (int v = 0; v < enigma::voices.size(); v++)
+    count += enigma::voices[v].sound != -1;
+  return count;
+}
+int sound_voice_max() {
+  return enigma::voices.size();
 }
 
 void action_sound(int snd, bool loop)
@@ -363,8 +494,11 @@ int sound_add(string fname, int kind, bool preload) //At the moment, the latter
 
   // Decode sound
   int rid = enigma::sound_allocate();
-  if (enigma::sound_add_from_buffer(rid,fdata,flen))
-    return (--enigma::sound_idmax, -1);
+  if (enigma::sound_add_from_buffer(rid,fdata,flen)) {
+    delete enigma::sounds[rid];
+    enigma::sounds.release(rid);
+    return -1;
+  }
 
   return rid;
 }
@@ -372,8 +506,7 @@ int sound_add(string fname, int kind, bool preload) //At the moment, the latter
 bool sound_replace(int sound, string fname, int kind, bool preload)
 {
   get_sound(snd,sound,false);
-  alureDestroyStream(snd->stream, 0, 0);
-  alDeleteSources(1,&snd->src);
-  enigma::sounds[sound] = enigma::sound_new_with_source();
+  sound_delete(sound);
+  enigma::sounds[sound] = enigma::sound_new();
   return true;
 }
@@ -26,8 +26,9 @@
 \********************************************************************************/
 
 bool sound_exists(int sound);
-bool sound_play(int sound);
-bool sound_loop(int sound);
+int sound_play(int sound);
+int sound_loop(int sound);
+int sound_play_priority(int sound, int priority, bool loop = false);
 void sound_stop(int sound);
 void sound_stop_all();
 void sound_volume(int sound, float volume);
@@ -50,6 +51,18 @@ void action_sound(int snd, bool loop);
 
 void sound_pan(int sound, float value);
 
+// Each call to sound_play starts a new voice; these act on one voice rather than on every voice of a sound.
+bool sound_voice_exists(int voice);
+int sound_voice_get_sound(int voice);
+void sound_voice_stop(int voice);
+bool sound_voice_pause(int voice);
+bool sound_voice_resume(int voice);
+bool sound_voice_isplaying(int voice);
+void sound_voice_volume(int voice, float volume);
+void sound_voice_pan(int voice, float value);
+int sound_voice_count();
+int sound_voice_max();
+
 int sound_add(string fname, int kind, bool preload);
 bool sound_replace(int sound, string fname, int kind, bool preload);
 inline bool action_replace_sound(int sound, string fname)
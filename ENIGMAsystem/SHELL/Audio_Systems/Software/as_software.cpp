@@ -0,0 +1,606 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/time.h>
+using namespace std;
+
+#include "as_software.h"
+#include "Audio_Systems/audio_mandatory.h"
+#include "Audio_Systems/voice_pool.h"
+#include "Universal_System/resource_registry.h"
+
+#ifdef DEBUG_MODE
+#include "libEGMstd.h"
+#include "Widget_Systems/widgets_mandatory.h"
+#endif
+
+namespace enigma
+{
+  enum load_state {
+    LOADSTATE_NONE,
+    LOADSTATE_SOURCED,
+    LOADSTATE_COMPLETE
+  };
+  struct sound
+  {
+    vector<float> samples; // Interleaved stereo, at the sound's own rate
+    unsigned rate;
+    size_t (*stream)(void *userdata, void *buffer, size_t size); // optional stream; always 16-bit stereo at the mixer rate
+    void (*cleanup)(void *userdata); // optional cleanup callback for streams
+    void *userdata; // optional userdata for streams
+    void (*seek)(void *userdata, float position); // optional seeking
+
+    load_state loaded;
+    float volume, pan;
+
+    sound(): rate(0), stream(0), cleanup(0), userdata(0), seek(0), loaded(LOADSTATE_NONE), volume(1), pan(.5) {}
+    size_t frames() const { return samples.size() / 2; }
+  };
+
+  struct voice_state
+  {
+    double position; // In frames of the sound's data
+    float volume, pan;
+    bool loop, paused;
+  };
+
+  extern size_t sound_idmax;
+  resource_registry<sound> sounds(sound_idmax);
+
+  voice_pool voices;
+  vector<voice_state> voice_states;
+  const int voice_max = 64;
+  const int mixer_rate = 44100;
+
+  float master_volume = 1;
+  bool mixer_realtime = true;
+  timeval mixer_last;
+  string audio_error;
+
+  // Output sinks
+  FILE *wav_sink = NULL;
+  size_t wav_frames = 0;
+  bool capture_enabled = false;
+  vector<float> capture_sink;
+
+  #ifdef DEBUG_MODE
+    #define get_sound(snd,id,failure)\
+      if (id < 0 or size_t(id) >= enigma::sound_idmax or !enigma::sounds[id]) {\
+        show_error("Sound " + toString(id) + " does not exist", false);\
+        return failure;\
+      } enigma::sound *const snd = enigma::sounds[id];
+  #else
+    #define get_sound(snd,id,failure)\
+      enigma::sound *const snd = enigma::sounds[id];
+  #endif
+
+  #define get_voice(slot,handle,failure)\
+    const int slot = enigma::voices.slot_of(handle);\
+    if (slot == -1) return failure;
+
+  #define for_each_voice_of(slot,id)\
+    for (int slot = 0; slot < enigma::voices.size(); slot++)\
+      if (enigma::voices[slot].sound == (id))
+
+  static inline unsigned read_le(const unsigned char *p, int bytes) {
+    unsigned r = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+      r = (r << 8) | p[i];
+    return r;
+  }
+  static inline void write_le(FILE *f, unsigned v, int bytes) {
+    for (int i = 0; i < bytes; i++, v >>= 8)
+      fputc(v & 0xFF, f);
+  }
+
+  // Decodes an uncompressed RIFF WAVE file into interleaved stereo floats.
+  static bool decode_wav(sound *snd, const unsigned char *data, size_t size)
+  {
+    if (size < 12 or memcmp(data, "RIFF", 4) or memcmp(data + 8, "WAVE", 4))
+      return audio_error = "Not a RIFF WAVE file", false;
+
+    unsigned format = 0, channels = 0, rate = 0, bits = 0;
+    const unsigned char *pcm = NULL; size_t pcmsize = 0;
+    for (size_t pos = 12; pos + 8 <= size; )
+    {
+      const unsigned chunksize = read_le(data + pos + 4, 4);
+      const unsigned char *chunk = data + pos + 8;
+      const size_t avail = size - pos - 8 < chunksize ? size - pos - 8 : chunksize;
+      if (!memcmp(data + pos, "fmt ", 4) and avail >= 16)
+        format = read_le(chunk, 2), channels = read_le(chunk + 2, 2),
+        rate = read_le(chunk + 4, 4), bits = read_le(chunk + 14, 2);
+      else if (!memcmp(data + pos, "data", 4))
+        pcm = chunk, pcmsize = avail;
+      pos += 8 + chunksize + (chunksize & 1);
+    }
+
+    if (!pcm or !rate or channels < 1 or channels > 2)
+      return audio_error = "Unsupported WAVE layout", false;
+    if (!((format == 1 and (bits == 8 or bits == 16)) or (format == 3 and bits == 32)))
+      return audio_error = "Only 8- and 16-bit PCM and 32-bit float WAVE data can be mixed in software", false;
+
+    const unsigned bytes = bits / 8;
+    const size_t frames = pcmsize / (bytes * channels);
+    snd->samples.resize(frames * 2);
+    snd->rate = rate;
+    for (size_t i = 0; i < frames; i++)
+      for (unsigned c = 0; c < 2; c++)
+      {
+        const unsigned char *s = pcm + (i * channels + (c < channels ? c : 0)) * bytes;
+        float v;
+        if (format == 3) { const unsigned u = read_le(s, 4); memcpy(&v, &u, 4); }
+        else if (bits == 8) v = (s[0] - 128) / 128.f;
+        else v = short(read_le(s, 2)) / 32768.f;
+        snd->samples[i * 2 + c] = v;
+      }
+    return true;
+  }
+
+  static void wav_write_header(FILE *f, size_t frames)
+  {
+    const unsigned datasize = frames * 4;
+    fwrite("RIFF", 1, 4, f); write_le(f, 36 + datasize, 4);
+    fwrite("WAVEfmt ", 1, 8, f); write_le(f, 16, 4);
+    write_le(f, 1, 2); write_le(f, 2, 2); write_le(f, mixer_rate, 4);
+    write_le(f, mixer_rate * 4, 4); write_le(f, 4, 2); write_le(f, 16, 2);
+    fwrite("data", 1, 4, f); write_le(f, datasize, 4);
+  }
+
+  static inline void pan_gains(float volume, float pan, float &left, float &right) {
+    left  = volume * (pan < .5 ? 1 : 2 - pan * 2);
+    right = volume * (pan > .5 ? 1 : pan * 2);
+  }
+
+  // Adds one voice into the mix buffer. Returns false once the voice has finished.
+  static bool mix_voice(int slot, float *mix, int frames)
+  {
+    voice_state &vs = voice_states[slot];
+    sound *snd = sounds[voices[slot].sound];
+    float gl, gr;
+    pan_gains(vs.volume * master_volume, vs.pan, gl, gr);
+
+    if (snd->stream)
+    {
+      vector<short> pcm(frames * 2);
+      size_t got = 0;
+      bool rewound = false;
+      while (got < pcm.size())
+      {
+        const size_t n = snd->stream(snd->userdata, &pcm[got], (pcm.size() - got) * sizeof(short)) / sizeof(short);
+        if (n) { got += n, rewound = false; continue; }
+        if (!vs.loop or !snd->seek or rewound) break;
+        snd->seek(snd->userdata, 0), rewound = true;
+      }
+      for (size_t i = 0; i + 1 < got; i += 2)
+        mix[i] += pcm[i] / 32768.f * gl, mix[i+1] += pcm[i+1] / 32768.f * gr;
+      vs.position += got / 2;
+      return got == pcm.size();
+    }
+
+    const size_t length = snd->frames();
+    if (!length) return false;
+    const float *data = &snd->samples[0];
+    const double step = snd->rate / double(mixer_rate);
+    double pos = vs.position;
+    for (int i = 0; i < frames; i++)
+    {
+      if (pos >= length) {
+        if (!vs.loop) { vs.position = pos; return false; }
+        pos -= length * size_t(pos / length);
+      }
+      const size_t a = size_t(pos), b = a + 1 < length ? a + 1 : (vs.loop ? 0 : a);
+      const float t = pos - a;
+      mix[i*2]   += (data[a*2]   + (data[b*2]   - data[a*2])   * t) * gl;
+      mix[i*2+1] += (data[a*2+1] + (data[b*2+1] - data[a*2+1]) * t) * gr;
+      pos += step;
+    }
+    vs.position = pos;
+    return vs.loop or pos < length;
+  }
+
+  int mixer_render(int frames)
+  {
+    if (frames <= 0) return 0;
+    vector<float> mix(frames * 2, 0.f);
+    for (int v = 0; v < voices.size(); v++)
+      if (voices[v].sound != -1 and !voice_states[v].paused)
+        if (!mix_voice(v, &mix[0], frames))
+          voices.release(v);
+
+    if (capture_enabled)
+      capture_sink.insert(capture_sink.end(), mix.begin(), mix.end());
+    if (wav_sink)
+    {
+      vector<short> pcm(mix.size());
+      for (size_t i = 0; i < mix.size(); i++)
+        pcm[i] = mix[i] >= 1 ? 32767 : mix[i] <= -1 ? -32768 : short(mix[i] * 32767);
+      for (size_t i = 0; i < pcm.size(); i++)
+        write_le(wav_sink, (unsigned short)pcm[i], 2);
+      wav_frames += frames;
+    }
+    return frames;
+  }
+
+  int audiosystem_initialize()
+  {
+    sounds.init();
+
+    voices.resize(voice_max);
+    voice_states.resize(voice_max);
+    gettimeofday(&mixer_last, NULL);
+    return 0;
+  }
+
+  static sound* sound_new() {
+    sound *res = new sound();
+    res->loaded = LOADSTATE_SOURCED;
+    return res;
+  }
+
+  int sound_add_from_buffer(int id, void* buffer, size_t bufsize)
+  {
+    sound *snd = sounds[id];
+    if (!snd)
+      snd = sounds[id] = sound_new();
+    if (snd->loaded != LOADSTATE_SOURCED)
+      return 1;
+    if (!decode_wav(snd, (const unsigned char*)buffer, bufsize)) {
+      fprintf(stderr, "Could not load sound %d: %s\n", id, audio_error.c_str());
+      return 2;
+    }
+    snd->loaded = LOADSTATE_COMPLETE;
+    return 0;
+  }
+
+  int sound_add_from_stream(int id, size_t (*callback)(void *userdata, void *buffer, size_t size), void (*seek)(void *userdata, float position), void (*cleanup)(void *userdata), void *userdata)
+  {
+    sound *snd = sounds[id];
+    if (!snd)
+      snd = sounds[id] = sound_new();
+    if (snd->loaded != LOADSTATE_SOURCED)
+      return 1;
+    snd->stream = callback;
+    snd->rate = mixer_rate;
+    snd->cleanup = cleanup;
+    snd->userdata = userdata;
+    snd->seek = seek;
+    snd->loaded = LOADSTATE_COMPLETE;
+    return 0;
+  }
+
+  int sound_allocate()
+  {
+    const int id = sounds.claim();
+    sounds[id] = sound_new();
+    return id;
+  }
+
+  // Mixes however much audio a real device would have consumed since the last update.
+  void audiosystem_update()
+  {
+    if (!mixer_realtime) return;
+    timeval now;
+    gettimeofday(&now, NULL);
+    double elapsed = (now.tv_sec - mixer_last.tv_sec) + (now.tv_usec - mixer_last.tv_usec) / 1000000.0;
+    const int frames = int(elapsed * mixer_rate);
+    if (frames <= 0) return;
+    mixer_last = now;
+    mixer_render(frames < mixer_rate / 4 ? frames : mixer_rate / 4); // Don't try to catch up after a long stall
+  }
+
+  static int sound_start(int id, bool loop, int priority)
+  {
+    get_sound(snd,id,-1);
+    if (snd->loaded != LOADSTATE_COMPLETE)
+      return -1;
+
+    // A stream has a single read position, so it can only ever occupy one voice.
+    if (snd->stream)
+      for_each_voice_of(v, id)
+        voices.release(v);
+
+    bool stolen;
+    const int slot = voices.allocate(id, priority, stolen);
+    if (slot == -1)
+      return -1;
+    voice_state &vs = voice_states[slot];
+    vs.position = 0;
+    vs.volume = snd->volume, vs.pan = snd->pan;
+    vs.loop = loop, vs.paused = false;
+    return voices.handle(slot);
+  }
+
+  void audiosystem_cleanup()
+  {
+    sound_mixer_wav_close();
+    for (size_t i = 0; i < sound_idmax; i++)
+      if (sounds[i]) {
+        if (sounds[i]->cleanup) sounds[i]->cleanup(sounds[i]->userdata);
+        delete sounds[i];
+      }
+  }
+}
+
+bool sound_exists(int sound)
+{
+    return unsigned(sound) < enigma::sound_idmax && bool(enigma::sounds[sound]);
+}
+
+int sound_play(int sound) {
+  return enigma::sound_start(sound, false, 0);
+}
+int sound_loop(int sound) {
+  return enigma::sound_start(sound, true, 0);
+}
+int sound_play_priority(int sound, int priority, bool loop) {
+  return enigma::sound_start(sound, loop, priority);
+}
+bool sound_pause(int sound)
+{
+  for_each_voice_of(v, sound)
+    enigma::voice_states[v].paused = true;
+  return false;
+}
+void sound_pause_all()
+{
+  for (int v = 0; v < enigma::voices.size(); v++)
+    enigma::voice_states[v].paused = true;
+}
+void sound_stop(int sound) {
+  get_sound(snd,sound,);
+  for_each_voice_of(v, sound)
+    enigma::voices.release(v);
+  if (snd->seek)
+    snd->seek(snd->userdata, 0);
+}
+void sound_stop_all()
+{
+  for (int v = 0; v < enigma::voices.size(); v++)
+    enigma::voices.release(v);
+  for (size_t i = 0; i < enigma::sound_idmax; i++)
+    if (enigma::sounds[i] && enigma::sounds[i]->seek)
+      enigma::sounds[i]->seek(enigma::sounds[i]->userdata, 0);
+}
+void sound_delete(int sound) {
+  get_sound(snd,sound,);
+  for_each_voice_of(v, sound)
+    enigma::voices.release(v);
+  if (snd->cleanup) snd->cleanup(snd->userdata);
+  delete snd;
+  enigma::sounds.release(sound);
+}
+void sound_volume(int sound, float volume) {
+  get_sound(snd,sound,);
+  snd->volume = volume;
+  for_each_voice_of(v, sound)
+    enigma::voice_states[v].volume = volume;
+}
+void sound_global_volume(float mastervolume) {
+  enigma::master_volume = mastervolume;
+}
+bool sound_resume(int sound)
+{
+  bool playing = false;
+  for_each_voice_of(v, sound)
+    enigma::voice_states[v].paused = false, playing = true;
+  return playing;
+}
+void sound_resume_all()
+{
+  for (int v = 0; v < enigma::voices.size(); v++)
+    enigma::voice_states[v].paused = false;
+}
+bool sound_isplaying(int sound) {
+  for_each_voice_of(v, sound)
+    if (!enigma::voice_states[v].paused)
+      return true;
+  return false;
+}
+bool sound_ispaused(int sound) {
+  bool paused = false;
+  for_each_voice_of(v, sound) {
+    if (!enigma::voice_states[v].paused)
+      return false;
+    paused = true;
+  }
+  return paused;
+}
+
+void sound_pan(int sound, float value)
+{
+  get_sound(snd,sound,);
+  snd->pan = value;
+  for_each_voice_of(v, sound)
+    enigma::voice_states[v].pan = value;
+}
+float sound_get_length(int sound) { // Not for Streams
+  get_sound(snd,sound,0);
+  return snd->rate ? snd->frames() / float(snd->rate) : 0;
+}
+float sound_get_position(int sound) { // Reports the most recently started voice
+  get_sound(snd,sound,-1);
+  int latest = -1;
+  for_each_voice_of(v, sound)
+    if (latest == -1 or enigma::voices[v].started > enigma::voices[latest].started)
+      latest = v;
+  if (latest == -1 or !snd->rate)
+    return 0;
+  return enigma::voice_states[latest].position / snd->rate;
+}
+void sound_seek(int sound, float position) {
+  get_sound(snd,sound,);
+  for_each_voice_of(v, sound)
+    enigma::voice_states[v].position = position * snd->rate;
+  if (snd->seek) snd->seek(snd->userdata, position);
+}
+void sound_seek_all(float position) {
+  for (size_t i = 0; i < enigma::sound_idmax; i++)
+    if (enigma::sounds[i])
+      sound_seek(i, position);
+}
+
+bool sound_voice_exists(int voice) {
+  return enigma::voices.slot_of(voice) != -1;
+}
+int sound_voice_get_sound(int voice) {
+  get_voice(slot,voice,-1);
+  return enigma::voices[slot].sound;
+}
+void sound_voice_stop(int voice) {
+  get_voice(slot,voice,);
+  enigma::voices.release(slot);
+}
+bool sound_voice_pause(int voice) {
+  get_voice(slot,voice,false);
+  enigma::voice_states[slot].paused = true;
+  return false;
+}
+bool sound_voice_resume(int voice) {
+  get_voice(slot,voice,false);
+  enigma::voice_states[slot].paused = false;
+  return true;
+}
+bool sound_voice_isplaying(int voice) {
+  get_voice(slot,voice,false);
+  return !enigma::voice_states[slot].paused;
+}
+void sound_voice_volume(int voice, float volume) {
+  get_voice(slot,voice,);
+  enigma::voice_states[slot].volume = volume;
+}
+void sound_voice_pan(int voice, float value) {
+  get_voice(slot,voice,);
+  enigma::voice_states[slot].pan = value;
+}
+int sound_voice_count() {
+  int count = 0;
+  for (int v = 0; v < enigma::voices.size(); v++)
+    count += enigma::voices[v].sound != -1;
+  return count;
+}
+int sound_voice_max() {
+  return enigma::voices.size();
+}
+
+void action_sound(int snd, bool loop)
+{
+    (loop ? sound_loop:sound_play)(snd);
+}
+
+const char* sound_get_audio_error() {
+  return enigma::audio_error.c_str();
+}
+
+int sound_add(string fname, int kind, bool preload)
+{
+  FILE *afile = fopen(fname.c_str(),"rb");
+  if (!afile)
+    return -1;
+
+  fseek(afile,0,SEEK_END);
+  const size_t flen = ftell(afile);
+  vector<char> fdata(flen + 1);
+  fseek(afile,0,SEEK_SET);
+  if (fread(&fdata[0],1,flen,afile) != flen)
+    puts("WARNING: Resource stream cut short while loading sound data");
+  fclose(afile);
+
+  int rid = enigma::sound_allocate();
+  if (enigma::sound_add_from_buffer(rid,&fdata[0],flen)) {
+    delete enigma::sounds[rid];
+    enigma::sounds.release(rid);
+    return -1;
+  }
+  return rid;
+}
+
+bool sound_replace(int sound, string fname, int kind, bool preload)
+{
+  get_sound(snd,sound,false);
+  for_each_voice_of(v, sound)
+    enigma::voices.release(v);
+
+  FILE *afile = fopen(fname.c_str(),"rb");
+  if (!afile)
+    return false;
+  fseek(afile,0,SEEK_END);
+  const size_t flen = ftell(afile);
+  vector<char> fdata(flen + 1);
+  fseek(afile,0,SEEK_SET);
+  const size_t got = fread(&fdata[0],1,flen,afile);
+  fclose(afile);
+
+  enigma::sound *ns = enigma::sound_new();
+  if (!enigma::decode_wav(ns, (const unsigned char*)&fdata[0], got)) {
+    delete ns;
+    return false;
+  }
+  ns->loaded = enigma::LOADSTATE_COMPLETE;
+  if (snd->cleanup) snd->cleanup(snd->userdata);
+  delete snd;
+  enigma::sounds[sound] = ns;
+  return true;
+}
+
+int sound_mixer_render(int frames) {
+  return enigma::mixer_render(frames);
+}
+void sound_mixer_set_realtime(bool realtime) {
+  enigma::mixer_realtime = realtime;
+  gettimeofday(&enigma::mixer_last, NULL);
+}
+int sound_mixer_get_rate() {
+  return enigma::mixer_rate;
+}
+
+bool sound_mixer_wav_open(string fname)
+{
+  sound_mixer_wav_close();
+  enigma::wav_sink = fopen(fname.c_str(), "wb");
+  if (!enigma::wav_sink)
+    return false;
+  enigma::wav_frames = 0;
+  enigma::wav_write_header(enigma::wav_sink, 0); // Sizes are filled in on close
+  return true;
+}
+void sound_mixer_wav_close()
+{
+  if (!enigma::wav_sink) return;
+  fseek(enigma::wav_sink, 0, SEEK_SET);
+  enigma::wav_write_header(enigma::wav_sink, enigma::wav_frames);
+  fclose(enigma::wav_sink);
+  enigma::wav_sink = NULL;
+}
+void sound_mixer_capture(bool enable) {
+  enigma::capture_enabled = enable;
+}
+void sound_mixer_capture_clear() {
+  vector<float>().swap(enigma::capture_sink);
+}
+int sound_mixer_captured_frames() {
+  return enigma::capture_sink.size() / 2;
+}
+float sound_mixer_captured_sample(int frame, int channel)
+{
+  const size_t i = size_t(frame) * 2 + (channel != 0);
+  return frame >= 0 and i < enigma::capture_sink.size() ? enigma::capture_sink[i] : 0;
+}
@@ -0,0 +1,79 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <string>
+
+bool sound_exists(int sound);
+int sound_play(int sound);
+int sound_loop(int sound);
+int sound_play_priority(int sound, int priority, bool loop = false);
+void sound_stop(int sound);
+void sound_stop_all();
+void sound_volume(int sound, float volume);
+void sound_global_volume(float mastervolume);
+void sound_delete(int sound);
+bool sound_pause(int sound);
+void sound_pause_all();
+bool sound_resume(int sound);
+void sound_resume_all();
+
+float sound_get_length(int sound);
+float sound_get_position(int sound);
+void sound_seek(int sound, float position);
+void sound_seek_all(float position);
+
+bool sound_isplaying(int sound);
+bool sound_ispaused(int sound);
+
+void action_sound(int snd, bool loop);
+
+void sound_pan(int sound, float value);
+
+// Each call to sound_play starts a new voice; these act on one voice rather than on every voice of a sound.
+bool sound_voice_exists(int voice);
+int sound_voice_get_sound(int voice);
+void sound_voice_stop(int voice);
+bool sound_voice_pause(int voice);
+bool sound_voice_resume(int voice);
+bool sound_voice_isplaying(int voice);
+void sound_voice_volume(int voice, float volume);
+void sound_voice_pan(int voice, float value);
+int sound_voice_count();
+int sound_voice_max();
+
+int sound_add(std::string fname, int kind, bool preload);
+bool sound_replace(int sound, std::string fname, int kind, bool preload);
+inline bool action_replace_sound(int sound, std::string fname)
+{
+    return sound_replace(sound, fname, 0, true);
+}
+
+const char* sound_get_audio_error();
+
+// The mixer runs in step with the wall clock unless realtime mixing is turned off,
+// in which case nothing advances until sound_mixer_render is called.
+int sound_mixer_render(int frames);
+void sound_mixer_set_realtime(bool realtime);
+int sound_mixer_get_rate();
+
+// Mixed output goes to any combination of these sinks.
+bool sound_mixer_wav_open(std::string fname);
+void sound_mixer_wav_close();
+void sound_mixer_capture(bool enable);
+void sound_mixer_capture_clear();
+int sound_mixer_captured_frames();
+float sound_mixer_captured_sample(int frame, int channel);
@@ -0,0 +1 @@
+#include "as_software.h"
@@ -0,0 +1,100 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+/*\\\ This file implements the bookkeeping shared by audio systems that play sounds
+|*||| through a fixed number of voices. A voice is one playing instance of a sound;
+\*/// the same sound may occupy any number of voices at once.
+
+#ifndef _VOICE_POOL__H
+#define _VOICE_POOL__H
+
+#include <vector>
+
+namespace enigma
+{
+  struct voice_slot
+  {
+    int sound;           // Sound resource playing in this voice, or -1 if the voice is free
+    int priority;        // Higher priorities are stolen last
+    unsigned generation; // Bumped on every reuse, so handles to a stolen voice go stale
+    unsigned long started; // Allocation order; among equal priorities the oldest is stolen first
+    voice_slot(): sound(-1), priority(0), generation(0), started(0) {}
+  };
+
+  // Handles pack the slot in the low bits and the generation above them, and are never zero.
+  class voice_pool
+  {
+    std::vector<voice_slot> slots;
+    unsigned long clock;
+    static const int slot_bits = 12;
+
+  public:
+    voice_pool(): clock(0) {}
+    void resize(int count) { slots.resize(count); }
+    int size() const { return slots.size(); }
+    voice_slot& operator[](int slot) { return slots[slot]; }
+
+    /// Claims a voice for the sound. Free voices are used first; otherwise the
+    /// lowest-priority voice not above the requested priority is stolen, oldest first.
+    /// Returns the slot, or -1 if every voice outranks the request. The caller must
+    /// stop whatever the slot was playing if stolen is set.
+    int allocate(int sound, int priority, bool &stolen)
+    {
+      int best = -1;
+      stolen = false;
+      for (int i = 0; i < (int)slots.size(); i++)
+      {
+        if (slots[i].sound == -1) { best = i; break; }
+        if (slots[i].priority > priority) continue;
+        if (best == -1 or slots[i].priority < slots[best].priority
+        or (slots[i].priority == slots[best].priority and slots[i].started < slots[best].started))
+          best = i;
+      }
+      if (best == -1) return -1;
+
+      voice_slot &v = slots[best];
+      stolen = v.sound != -1;
+      v.sound = sound;
+      v.priority = priority;
+      v.generation = (v.generation + 1) & ((1 << (31 - slot_bits)) - 1);
+      if (!v.generation) v.generation = 1;
+      v.started = ++clock;
+      return best;
+    }
+
+    void release(int slot) {
+      slots[slot].sound = -1;
+    }
+
+    int handle(int slot) const {
+      return (slots[slot].generation << slot_bits) | slot;
+    }
+
+    /// Returns the slot a handle refers to, or -1 if the voice has ended or been stolen.
+    int slot_of(int handle) const
+    {
+      if (handle <= 0) return -1;
+      const int slot = handle & ((1 << slot_bits) - 1);
+      if (slot >= (int)slots.size() or slots[slot].sound == -1
+      or slots[slot].generation != unsigned(handle >> slot_bits))
+        return -1;
+      return slot;
+    }
+  };
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include "coll_funcs.h"
 #include "coll_impl.h"
 #include <limits>
+#include <vector>
 #include <cmath>
 #include "Universal_System/instance.h"
 
@@ -743,7 +744,30 @@ bool move_bounce_object(int object, bool adv, bool solid_only)
     return true;
 }
 
-typedef std::pair<int,enigma::inst_iter*> inode_pair;
+// Bounding box of a deactivated instance, for filing it in the deactivated buckets.
+static bool deactivated_border(enigma::object_basic* instance, int &left, int &top, int &right, int &bottom)
+{
+    enigma::object_collisions* const inst = (enigma::object_collisions*)instance;
+    if (inst->sprite_index == -1 && (inst->mask_index == -1)) //no sprite/mask then no collision
+        return false;
+
+    const bbox_rect_t &box = inst->$bbox_relative();
+    get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, inst->x, inst->y, inst->image_xscale, inst->image_yscale, inst->image_angle);
+    return true;
+}
+
+// Ids of the deactivated instances worth testing against a region: those filed near it if
+// instances inside it are wanted, or else all of them.
+static void deactivated_candidates(int left, int top, int right, int bottom, bool inside, std::vector<int> &ids)
+{
+    if (inside) {
+        enigma::instance_deactivated_place(deactivated_border);
+        enigma::instance_deactivated_near(left, top, right, bottom, ids);
+        return;
+    }
+    for (std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.begin(); iter != enigma::instance_deactivated_list.end(); iter++)
+        ids.push_back(iter->first);
+}
 
 void instance_deactivate_region(int rleft, int rtop, int rwidth, int rheight, int inside, bool notme) {
     for (enigma::iterator it = enigma::instance_list_first(); it; ++it) {
@@ -764,52 +788,33 @@ void instance_deactivate_region(int rleft, int rtop, int rwidth, int rheight, in
         if (left <= (rleft+rwidth) && rleft <= right && top <= (rtop+rheight) && rtop <= bottom) {
             if (inside) {
             inst->deactivate();
-            enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+            enigma::instance_deactivated_add(it.it);
             }
         } else {
             if (!inside) {
                 inst->deactivate();
-                enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+                enigma::instance_deactivated_add(it.it);
             }
         }
     }
 }
 
 void instance_activate_region(int rleft, int rtop, int rwidth, int rheight, int inside) {
-    std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.begin();
-    while (iter != enigma::instance_deactivated_list.end()) {
-
-        enigma::object_collisions* const inst = ((enigma::object_collisions*)(iter->second->inst));
-
-        if (inst->sprite_index == -1 && (inst->mask_index == -1)) { //no sprite/mask then no collision
-            ++iter;
+    std::vector<int> ids;
+    deactivated_candidates(rleft, rtop, rleft+rwidth, rtop+rheight, inside, ids);
+    for (size_t i = 0; i < ids.size(); i++) {
+        std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.find(ids[i]);
+        if (iter == enigma::instance_deactivated_list.end())
             continue;
-        }
-
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-        xscale = inst->image_xscale, yscale = inst->image_yscale,
-        ia = inst->image_angle;
+        enigma::object_collisions* const inst = ((enigma::object_collisions*)(iter->second->inst));
 
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        if (!deactivated_border(inst, left, top, right, bottom))
+            continue;
 
-        bool removed = false;
-        if (left <= (rleft+rwidth) && rleft <= right && top <= (rtop+rheight) && rtop <= bottom) {
-            if (inside) {
-                inst->activate();
-                enigma::instance_deactivated_list.erase(iter++);
-                removed = true;
-            }
-        } else {
-            if (!inside) {
-                inst->activate();
-                enigma::instance_deactivated_list.erase(iter++);
-                removed = true;
-            }
-        }
-        if (!removed) {
-            ++iter;
+        if ((left <= (rleft+rwidth) && rleft <= right && top <= (rtop+rheight) && rtop <= bottom) == bool(inside)) {
+            inst->activate();
+            enigma::instance_deactivated_remove(iter);
         }
     }
 }
@@ -858,7 +863,7 @@ void instance_deactivate_circle(int x, int y, int r, int inside, bool notme)
             if (inside)
             {
                 inst->deactivate();
-                enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+                enigma::instance_deactivated_add(it.it);
             }
         }
         else
@@ -866,7 +871,7 @@ void instance_deactivate_circle(int x, int y, int r, int inside, bool notme)
             if (!inside)
             {
                 inst->deactivate();
-                enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+                enigma::instance_deactivated_add(it.it);
             }
         }
     }
@@ -875,22 +880,17 @@ void instance_deactivate_circle(int x, int y, int r, int inside, bool notme)
 
 void instance_activate_circle(int x, int y, int r, int inside)
 {
-    std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.begin();
-    while (iter != enigma::instance_deactivated_list.end()) {
-        enigma::object_collisions* const inst = ((enigma::object_collisions*)(iter->second->inst));
-
-        if (inst->sprite_index == -1 && (inst->mask_index == -1)) { //no sprite/mask then no collision
-            ++iter;
+    std::vector<int> ids;
+    deactivated_candidates(x-r, y-r, x+r, y+r, inside, ids);
+    for (size_t i = 0; i < ids.size(); i++) {
+        std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.find(ids[i]);
+        if (iter == enigma::instance_deactivated_list.end())
             continue;
-        }
-
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x1 = inst->x, y1 = inst->y,
-        xscale = inst->image_xscale, yscale = inst->image_yscale,
-        ia = inst->image_angle;
+        enigma::object_collisions* const inst = ((enigma::object_collisions*)(iter->second->inst));
 
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x1, y1, xscale, yscale, ia);
+        if (!deactivated_border(inst, left, top, right, bottom))
+            continue;
 
         const bool intersects = line_ellipse_intersects(r, r, left-x, top-y, bottom-y) ||
                                  line_ellipse_intersects(r, r, right-x, top-y, bottom-y) ||
@@ -898,27 +898,10 @@ void instance_activate_circle(int x, int y, int r, int inside)
                                  line_ellipse_intersects(r, r, bottom-y, left-x, right-x) ||
                                  (x >= left && x <= right && y >= top && y <= bottom); // Circle inside bbox.
 
-        bool removed = false;
-        if (intersects)
-        {
-            if (inside)
-            {
-                inst->activate();
-                enigma::instance_deactivated_list.erase(iter++);
-                removed = true;
-            }
-        }
-        else
+        if (intersects == bool(inside))
         {
-            if (!inside)
-            {
-                inst->activate();
-                enigma::instance_deactivated_list.erase(iter++);
-                removed = true;
-            }
-        }
-        if (!removed) {
-            ++iter;
+            inst->activate();
+            enigma::instance_deactivated_remove(iter);
         }
     }
 }
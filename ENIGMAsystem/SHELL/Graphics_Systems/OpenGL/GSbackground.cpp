@@ -489,9 +489,7 @@ void texture_set_interpolation(int enable)
 	    if (!back)
             continue;
 
-        glBindTexture(GL_TEXTURE_2D, back->texture);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,enable?GL_LINEAR:GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,enable?GL_LINEAR:GL_NEAREST);
+        enigma::graphics_refilter_texture(back->texture);
 	}
 
 	for (i = 0; i < enigma::sprite_idmax; i++)
@@ -502,9 +500,7 @@ void texture_set_interpolation(int enable)
 
         for (ii = 0; ii < spr->subcount; ii++)
         {
-            glBindTexture(GL_TEXTURE_2D, spr->texturearray[ii]);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,enable?GL_LINEAR:GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,enable?GL_LINEAR:GL_NEAREST);
+            enigma::graphics_refilter_texture(spr->texturearray[ii]);
         }
     }
 }
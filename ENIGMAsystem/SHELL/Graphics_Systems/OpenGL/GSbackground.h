@@ -47,4 +47,18 @@ bool texture_get_interpolation();
 void texture_set_blending(bool enable);
 void texture_set_repeat(bool repeat);
 void texture_preload(int texid);
-void texture_set_priority(int texid, double prio);
+void texture_set_priority(int texid, double prio);
+
+enum {
+  texture_compress_none = 0,
+  texture_compress_dxt  = 1, // S3TC DXT5, where GL_EXT_texture_compression_s3tc is present
+  texture_compress_etc  = 2  // ETC2, where GL_ARB_ES3_compatibility is present
+};
+
+// These apply to textures created after they are called; images the card cannot compress stay uncompressed.
+void texture_set_compression(int mode);
+int texture_get_compression();
+void texture_set_mipmaps(bool enable);
+bool texture_get_mipmaps();
+bool texture_get_npot(); // Whether images are uploaded at their own size instead of padded to a power of two
+double texture_get_resident_bytes(); // Bytes held by every texture made from an image, as the driver reports them
@@ -20,6 +20,7 @@
 #include "OpenGLHeaders.h"
 #include "GSbackground.h"
 #include "GSscreen.h"
+#include "GStiles.h"
 #include "GSd3d.h"
 
 using namespace std;
@@ -34,6 +35,7 @@ using namespace std;
 #include "Universal_System/instance_system.h"
 #include "Universal_System/graphics_object.h"
 #include "Universal_System/depth_draw.h"
+#include "Universal_System/draw_culling.h"
 #include "Platforms/platforms_mandatory.h"
 #include "Graphics_Systems/graphics_mandatory.h"
 #include "Graphics_Systems/OpenGL/ParticleSystems/PS_particle_system.h"
@@ -105,18 +107,16 @@ void screen_redraw()
         }
         id_to_currentnextdepth.clear();
 
+        draw_culling_begin_view(0);
         for (enigma::diter dit = drawing_depths.rbegin(); dit != drawing_depths.rend(); dit++)
         {
-            //loop tiles
-            for(std::vector<tile>::size_type i = 0; i !=  dit->second.tiles.size(); i++)
-            {
-                tile t = dit->second.tiles[i];
-                draw_background_part(t.bckid, t.bgx, t.bgy, t.width, t.height, t.roomX, t.roomY);
-            }
+            //tiles
+            draw_tile_layer(dit->first, dit->second.tiles);
             enigma::inst_iter* push_it = enigma::instance_event_iterator;
             //loop instances
             for (enigma::instance_event_iterator = dit->second.draw_events->next; enigma::instance_event_iterator != NULL; enigma::instance_event_iterator = enigma::instance_event_iterator->next)
-                enigma::instance_event_iterator->inst->myevent_draw();
+                if (draw_culling_check(0, enigma::instance_event_iterator->inst, 0, 0, room_width, room_height))
+                    enigma::instance_event_iterator->inst->myevent_draw();
             enigma::instance_event_iterator = push_it;
             //particles
             draw_particlesystems(dit->second.particlesystem_ids);
@@ -246,22 +246,19 @@ void screen_redraw()
                 }
                 id_to_currentnextdepth.clear();
 
+                draw_culling_begin_view(vc);
+                const double cull_left = view_xview[vc], cull_top = view_yview[vc],
+                             cull_right = cull_left + view_wview[vc], cull_bottom = cull_top + view_hview[vc];
                 for (enigma::diter dit = drawing_depths.rbegin(); dit != drawing_depths.rend(); dit++)
                 {
-                    //loop tiles
-                    for(std::vector<tile>::size_type i = 0; i !=  dit->second.tiles.size(); i++)
-                    {
-                        tile t = dit->second.tiles[i];
-                        if (t.roomX + t.width < view_xview[vc] || t.roomY + t.height < view_yview[vc] || t.roomX > view_xview[vc] + view_wview[vc] || t.roomY > view_yview[vc] + view_hview[vc])
-                            continue;
-
-                        draw_background_part(t.bckid, t.bgx, t.bgy, t.width, t.height, t.roomX, t.roomY);
-                    }
+                    //tiles
+                    draw_tile_layer(dit->first, dit->second.tiles, cull_left, cull_top, cull_right, cull_bottom);
 
                     enigma::inst_iter* push_it = enigma::instance_event_iterator;
                     //loop instances
                     for (enigma::instance_event_iterator = dit->second.draw_events->next; enigma::instance_event_iterator != NULL; enigma::instance_event_iterator = enigma::instance_event_iterator->next)
-                        enigma::instance_event_iterator->inst->myevent_draw();
+                        if (draw_culling_check(vc, enigma::instance_event_iterator->inst, cull_left, cull_top, cull_right, cull_bottom))
+                            enigma::instance_event_iterator->inst->myevent_draw();
                     enigma::instance_event_iterator = push_it;
                     //particles
                     draw_particlesystems(dit->second.particlesystem_ids);
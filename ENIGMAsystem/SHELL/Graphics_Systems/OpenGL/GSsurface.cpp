@@ -18,8 +18,10 @@
 #include "OpenGLHeaders.h"
 using namespace std;
 #include <cstddef>
+#include <cstring>
 #include <iostream>
-#include <math.h>
+#include <vector>
+#include <math.h>
 
 #include "binding.h"
 #include <stdio.h> //for file writing (surface_save)
@@ -61,6 +63,94 @@ namespace enigma
 {
   surface **surface_array;
   int surface_max=0;
+  extern bool pbo_isgo;
+}
+
+namespace
+{
+  // Reads a region of the surface's color attachment, in GL row order, into buf.
+  void surface_read_rgba(enigma::surface *surf, int x, int y, int w, int h, void *buf)
+  {
+    int prevFbo;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surf->fbo);
+    glReadPixels(x,y,w,h,GL_RGBA,GL_UNSIGNED_BYTE,buf);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, prevFbo);
+  }
+
+  // Whether the surface is bound as the drawing target, and so may still be drawn to.
+  bool surface_is_target(enigma::surface *surf)
+  {
+    int fbo;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &fbo);
+    return unsigned(fbo) == surf->fbo;
+  }
+
+  // Makes sure the CPU mirror of the surface is current; one readback serves every
+  // getpixel until the surface is next drawn to.
+  const unsigned char *surface_get_mirror(enigma::surface *surf)
+  {
+    if (!surf->mirror_valid)
+    {
+      if (!surf->mirror)
+        surf->mirror = new unsigned char[surf->width*surf->height*4];
+      surface_read_rgba(surf, 0, 0, surf->width, surf->height, surf->mirror);
+      surf->mirror_valid = !surface_is_target(surf);
+    }
+    return surf->mirror;
+  }
+
+  // The RGBA of one pixel. While the surface is the target, the mirror can't be kept,
+  // so only that pixel is read back.
+  const unsigned char *surface_get_pixel(enigma::surface *surf, int x, int y, unsigned char *buf)
+  {
+    if (surf->mirror_valid or !surface_is_target(surf))
+      return surface_get_mirror(surf) + (y*surf->width + x)*4;
+    surface_read_rgba(surf, x, y, 1, 1, buf);
+    return buf;
+  }
+
+  // A region requested with surface_readback_request. With pixel buffer objects, the
+  // transfer happens in the background and pixels is only filled once it is read.
+  struct surface_readback
+  {
+    GLuint pbo;
+    GLsync fence;
+    int x, y, w, h;
+    unsigned char *pixels;
+  };
+  std::vector<surface_readback*> readbacks;
+
+  surface_readback *get_readback(int handle) {
+    return handle >= 0 and size_t(handle) < readbacks.size() ? readbacks[handle] : NULL;
+  }
+
+  void readback_resolve(surface_readback *rb)
+  {
+    if (rb->pixels) return;
+    rb->pixels = new unsigned char[rb->w*rb->h*4];
+    if (rb->fence) {
+      glClientWaitSync(rb->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+      glDeleteSync(rb->fence);
+      rb->fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+    const void *mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (mapped) memcpy(rb->pixels, mapped, rb->w*rb->h*4);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(1, &rb->pbo);
+    rb->pbo = 0;
+  }
+
+  const unsigned char *readback_pixel(int handle, int x, int y)
+  {
+    surface_readback *rb = get_readback(handle);
+    if (!rb or x < rb->x or y < rb->y or x >= rb->x + rb->w or y >= rb->y + rb->h)
+      return NULL;
+    readback_resolve(rb);
+    return rb->pixels + ((y - rb->y)*rb->w + (x - rb->x))*4;
+  }
 }
 
 bool surface_is_supported()
@@ -103,6 +193,8 @@ int surface_create(int width, int height)
       enigma::surface_array[id] = new enigma::surface;
       enigma::surface_array[id]->width = w;
       enigma::surface_array[id]->height = h;
+      enigma::surface_array[id]->mirror = NULL;
+      enigma::surface_array[id]->mirror_valid = false;
 
       glGenTextures(1, &tex);
       glGenFramebuffers(1, &fbo);
@@ -134,6 +226,7 @@ int surface_create(int width, int height)
 void surface_set_target(int id)
 {
   get_surface(surf,id);
+  surf->mirror_valid = false;
   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surf->fbo); //bind it
   glPushMatrix(); //So you can pop it in the reset
   glPushAttrib(GL_VIEWPORT_BIT); //same
@@ -153,6 +246,7 @@ void surface_free(int id)
 {
   get_surface(surf,id);
   surf->width = surf->height = surf->tex = surf->fbo = 0;
+  delete[] surf->mirror;
   delete surf;
   enigma::surface_array[id] = NULL;
 }
@@ -514,25 +608,90 @@ int surface_get_height(int id)
 int surface_getpixel(int id, int x, int y)
 {
     get_surfacev(surf,id,-1);
-    unsigned char *pixelbuf=new unsigned char[3];
-    int prevFbo;
-	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surf->fbo);
-	glReadPixels(x,y,1,1,GL_RGB,GL_UNSIGNED_BYTE,pixelbuf);
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, prevFbo);
-    return pixelbuf[0] + (pixelbuf[1] << 8) + (pixelbuf[2] << 16);
+    if (x < 0 or y < 0 or x >= surf->width or y >= surf->height)
+        return -1;
+    unsigned char buf[4];
+    const unsigned char *pixel = surface_get_pixel(surf, x, y, buf);
+    return pixel[0] + (pixel[1] << 8) + (pixel[2] << 16);
 }
 
 int surface_getpixel_alpha(int id, int x, int y)
 {
     get_surfacev(surf,id,-1);
-    unsigned char *pixelbuf=new unsigned char[1];
-    int prevFbo;
-	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surf->fbo);
-	glReadPixels(x,y,1,1,GL_ALPHA,GL_UNSIGNED_BYTE,pixelbuf);
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, prevFbo);
-    return pixelbuf[0];
+    if (x < 0 or y < 0 or x >= surf->width or y >= surf->height)
+        return -1;
+    unsigned char buf[4];
+    return surface_get_pixel(surf, x, y, buf)[3];
+}
+
+int surface_readback_request(int id, int x, int y, int w, int h)
+{
+    get_surfacev(surf,id,-1);
+    if (w <= 0 or h <= 0 or x < 0 or y < 0 or x + w > surf->width or y + h > surf->height)
+        return -1;
+
+    surface_readback *rb = new surface_readback;
+    rb->pbo = 0, rb->fence = 0, rb->pixels = NULL;
+    rb->x = x, rb->y = y, rb->w = w, rb->h = h;
+
+    if (surf->mirror_valid) { // Nothing has been drawn since the last read; no need to touch the GPU.
+        rb->pixels = new unsigned char[w*h*4];
+        for (int row = 0; row < h; row++)
+            memcpy(rb->pixels + row*w*4, surf->mirror + ((y + row)*surf->width + x)*4, w*4);
+    }
+    else if (enigma::pbo_isgo)
+    {
+        glGenBuffers(1, &rb->pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, w*h*4, NULL, GL_STREAM_READ);
+        surface_read_rgba(surf, x, y, w, h, 0); // Returns immediately; the copy lands in the buffer later.
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (GLEW_ARB_sync)
+            rb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    else {
+        rb->pixels = new unsigned char[w*h*4];
+        surface_read_rgba(surf, x, y, w, h, rb->pixels);
+    }
+
+    for (size_t i = 0; i < readbacks.size(); i++)
+        if (!readbacks[i]) {
+            readbacks[i] = rb;
+            return i;
+        }
+    readbacks.push_back(rb);
+    return readbacks.size() - 1;
+}
+
+bool surface_readback_ready(int handle)
+{
+    surface_readback *rb = get_readback(handle);
+    if (!rb) return false;
+    if (rb->pixels or !rb->fence) return true;
+    return glClientWaitSync(rb->fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+}
+
+int surface_readback_getpixel(int handle, int x, int y)
+{
+    const unsigned char *pixel = readback_pixel(handle, x, y);
+    return pixel ? pixel[0] + (pixel[1] << 8) + (pixel[2] << 16) : -1;
+}
+
+int surface_readback_getpixel_alpha(int handle, int x, int y)
+{
+    const unsigned char *pixel = readback_pixel(handle, x, y);
+    return pixel ? pixel[3] : -1;
+}
+
+void surface_readback_free(int handle)
+{
+    surface_readback *rb = get_readback(handle);
+    if (!rb) return;
+    if (rb->fence) glDeleteSync(rb->fence);
+    if (rb->pbo) glDeleteBuffers(1, &rb->pbo);
+    delete[] rb->pixels;
+    delete rb;
+    readbacks[handle] = NULL;
 }
 
 int surface_get_bound()
@@ -556,23 +715,18 @@ int surface_save(int id, string filename)
 	FILE *bmp=fopen(filename.c_str(),"wb");
 	if(!bmp) return -1;
 	unsigned int w=surf->width,h=surf->height,sz=w*h;
-	char *surfbuf=new char[sz*3];
 	char *revbuf=new char[sz*3];
-    int prevFbo;
-	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
 
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surf->fbo);
-	glReadPixels(0,0,w,h,GL_BGR,GL_UNSIGNED_BYTE,surfbuf);
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, prevFbo);
-
-    //This code flips the buffer vertically. It needs to be done or else the picture will be upside down.
+    // Read through the mirror, so saving a surface that was just sampled costs no second readback.
+    //This code flips the buffer vertically and converts it to BGR. It needs to be done or else the picture will be upside down.
+    const unsigned char *surfbuf = surface_get_mirror(surf);
     for (unsigned int i=0; i<h; i++)
     {
         for (unsigned int c=0; c<w; c++)
         {
-            revbuf[(c+(i)*w)*3]=surfbuf[(c+(h-i)*w)*3];
-            revbuf[(c+(i)*w)*3+1]=surfbuf[(c+(h-i)*w)*3+1];
-            revbuf[(c+(i)*w)*3+2]=surfbuf[(c+(h-i)*w)*3+2];
+            revbuf[(c+(i)*w)*3]=surfbuf[(c+(h-1-i)*w)*4+2];
+            revbuf[(c+(i)*w)*3+1]=surfbuf[(c+(h-1-i)*w)*4+1];
+            revbuf[(c+(i)*w)*3+2]=surfbuf[(c+(h-1-i)*w)*4];
         }
     }
 
@@ -597,7 +751,6 @@ int surface_save(int id, string filename)
 		}
 	} else fwrite(revbuf,w*3,h,bmp);
 	fclose(bmp);
-	delete[] surfbuf;
 	delete[] revbuf;
 	return 1;
 }
@@ -659,8 +812,7 @@ int sprite_create_from_surface(int id,int x,int y,int w,int h,bool removeback,bo
 {
     get_surfacev(surf,id,-1);
     int full_width=nlpo2dc(w)+1, full_height=nlpo2dc(h)+1;
-    enigma::spritestructarray_reallocate();
-    int sprid=enigma::sprite_idmax;
+    int sprid=enigma::spritestructarray.claim();
     enigma::sprite_new_empty(sprid, 1, w, h, xorig, yorig, 0, h, 0, w, 1,0);
 
     unsigned sz=full_width*full_height;
@@ -679,6 +831,7 @@ void surface_copy_part(int destination,double x,double y,int source,int xs,int y
 {
     get_surface(ssurf,source);
     get_surface(dsurf,destination);
+    dsurf->mirror_valid = false;
     unsigned char *surfbuf=new unsigned char[ws*hs*4];
     int prevFbo;
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
@@ -703,6 +856,7 @@ void surface_copy(int destination,double x,double y,int source)
 {
     get_surface(ssurf,source);
     get_surface(dsurf,destination);
+    dsurf->mirror_valid = false;
     unsigned char *surfbuf=new unsigned char[dsurf->width*dsurf->height*4];
     int prevFbo;
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &prevFbo);
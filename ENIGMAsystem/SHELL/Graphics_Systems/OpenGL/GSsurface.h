@@ -28,6 +28,8 @@ namespace enigma
   {
     GLuint tex, fbo;
     int width, height;
+    unsigned char *mirror; // RGBA copy of the surface for getpixel; NULL until first read
+    bool mirror_valid;     // Cleared whenever the surface may have been drawn to
   };
 }
 
@@ -53,6 +55,11 @@ int surface_get_width(int id);
 int surface_get_height(int id);
 int surface_getpixel(int id, int x, int y);
 int surface_getpixel_alpha(int id, int x, int y);
+int surface_readback_request(int id, int x, int y, int w, int h);
+bool surface_readback_ready(int handle);
+int surface_readback_getpixel(int handle, int x, int y);
+int surface_readback_getpixel_alpha(int handle, int x, int y);
+void surface_readback_free(int handle);
 int surface_save(int id, string filename);
 int surface_save_part(int id, string filename,unsigned x,unsigned y,unsigned w,unsigned h);
 void surface_copy(int destination,double x,double y,int source);
@@ -16,43 +16,128 @@
 **/
 
 #include <stdio.h>
+#include <map>
 #include "OpenGLHeaders.h"
 #include <string>
 using std::string;
 #include "GStextures.h"
+#include "GSbackground.h"
 #include "Graphics_Systems/graphics_mandatory.h"
+#include "Universal_System/IMGloading.h"
 #include "binding.h"
 
-inline unsigned int lgpp2(unsigned int x){//Trailing zero count. lg for perfect powers of two
-	x =  (x & -x) - 1;
-	x -= ((x >> 1) & 0x55555555);
-	x =  ((x >> 2) & 0x33333333) + (x & 0x33333333);
-	x =  ((x >> 4) + x) & 0x0f0f0f0f;
-	x += x >> 8;
-	return (x + (x >> 16)) & 63;
-}
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+// Every texture made from pixel data comes through texture_upload, which picks the
+// internal format, asks for mipmaps, and records what the texture occupies on the card.
+// Sizes are read back from the driver after the upload, so a compressed texture counts
+// what the driver actually kept rather than an estimate.
 
 namespace enigma
 {
   bool interpolate_textures = false; //NOTE: set value here when game settings are used
+  int texture_compression = texture_compress_none; //NOTE: as above
+  bool texture_mipmaps = false;
+  bool npot_textures = false;
 
-  unsigned graphics_create_texture(int fullwidth, int fullheight, void* pxdata)
-  {
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, 4, fullwidth, fullheight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pxdata);
-    if (interpolate_textures)
+  namespace {
+    struct texture_info {
+      size_t bytes;
+      bool mipmapped;
+    };
+    std::map<unsigned, texture_info> textures;
+    size_t texture_resident = 0;
+
+    GLenum texture_format(int compression)
     {
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+      switch (compression)
+      {
+        case texture_compress_dxt:
+          if (GLEW_EXT_texture_compression_s3tc)
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+          break;
+        case texture_compress_etc:
+          if (glewGetExtension("GL_ARB_ES3_compatibility"))
+            return GL_COMPRESSED_RGBA8_ETC2_EAC;
+          break;
+      }
+      return GL_RGBA8;
     }
-    else
+
+    size_t texture_level_bytes(int level)
     {
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+      GLint compressed = 0, w = 0, h = 0;
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+      if (compressed) {
+        GLint size = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        return size;
+      }
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &w);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &h);
+      return size_t(w) * h * 4;
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Applies the interpolation setting to the bound texture.
+    void texture_filter(bool mipmapped)
+    {
+      if (interpolate_textures)
+      {
+          glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+          glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+      }
+      else
+      {
+          glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,mipmapped ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+          glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+      }
+    }
+
+    // (Re)defines the image of a texture and accounts for its new size.
+    void texture_upload(GLuint texture, int width, int height, void* pxdata)
+    {
+      glBindTexture(GL_TEXTURE_2D, texture);
+      const bool mipmapped = texture_mipmaps and GLEW_VERSION_1_4;
+      if (mipmapped)
+        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+
+      // Drivers are free to refuse to encode some formats themselves; fall back to plain RGBA
+      while (glGetError() != GL_NO_ERROR);
+      GLenum format = texture_format(texture_compression);
+      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pxdata);
+      if (format != GL_RGBA8 and glGetError() != GL_NO_ERROR)
+        glTexImage2D(GL_TEXTURE_2D, 0, format = GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pxdata);
+      texture_filter(mipmapped);
+
+      texture_info &info = textures[texture];
+      texture_resident -= info.bytes;
+      info.bytes = texture_level_bytes(0);
+      info.mipmapped = mipmapped;
+      if (mipmapped)
+        for (int level = 1, w = width, h = height; w > 1 or h > 1; level++)
+        {
+          w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1;
+          info.bytes += texture_level_bytes(level);
+        }
+      texture_resident += info.bytes;
+      glBindTexture(GL_TEXTURE_2D, 0);
+    }
+  }
+
+  void graphics_textures_initialize()
+  {
+    // NPOT textures are core since 2.0. Without them, images keep being padded to a power of two.
+    npot_textures = GLEW_VERSION_2_0 or GLEW_ARB_texture_non_power_of_two;
+    image_pad_pow2 = !npot_textures;
+  }
+
+  unsigned graphics_create_texture(int fullwidth, int fullheight, void* pxdata)
+  {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    texture_upload(texture, fullwidth, fullheight, pxdata);
     return texture;
   }
 
@@ -68,7 +153,7 @@ namespace enigma
     int w, h;
     glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_WIDTH, &w);
     glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_HEIGHT, &h);
-    char* bitmap = new char[(h<<(lgpp2(w)+2))|2];
+    char* bitmap = new char[w*h*4];
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
     unsigned dup_tex = graphics_create_texture(w, h, bitmap);
     delete[] bitmap;
@@ -88,7 +173,7 @@ namespace enigma
     glBindTexture(GL_TEXTURE_2D, texture);
     glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_WIDTH, &w);
     glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_HEIGHT, &h);
-    size = (h<<(lgpp2(w)+2))|2;
+    size = w*h*4;
     char* bitmap = new char[size];
     char* bitmap2 = new char[size];
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
@@ -98,19 +183,7 @@ namespace enigma
     for (int i = 3; i < size; i += 4)
         bitmap[i] = (bitmap2[i-1] + bitmap2[i-2] + bitmap2[i-3])/3;
 
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, 4, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
-    if (interpolate_textures)
-    {
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    }
-    else
-    {
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texture_upload(texture, w, h, bitmap);
 
     delete[] bitmap;
     delete[] bitmap2;
@@ -120,9 +193,21 @@ namespace enigma
   void graphics_delete_texture(int tex)
   {
     GLuint texture = tex;
+    std::map<unsigned, texture_info>::iterator it = textures.find(texture);
+    if (it != textures.end()) {
+      texture_resident -= it->second.bytes;
+      textures.erase(it);
+    }
     glDeleteTextures(1, &texture);
   }
 
+  void graphics_refilter_texture(unsigned texture)
+  {
+    std::map<unsigned, texture_info>::iterator it = textures.find(texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    texture_filter(it != textures.end() and it->second.mipmapped);
+  }
+
   //Retrieve image data from a texture, in unsigned char, RGBA format.
   unsigned char* graphics_get_texture_rgba(unsigned texture)
   {
@@ -138,3 +223,33 @@ namespace enigma
     return ret;
   }
 }
+
+void texture_set_compression(int mode)
+{
+    enigma::texture_compression = mode;
+}
+
+int texture_get_compression()
+{
+    return enigma::texture_compression;
+}
+
+void texture_set_mipmaps(bool enable)
+{
+    enigma::texture_mipmaps = enable;
+}
+
+bool texture_get_mipmaps()
+{
+    return enigma::texture_mipmaps;
+}
+
+bool texture_get_npot()
+{
+    return enigma::npot_textures;
+}
+
+double texture_get_resident_bytes()
+{
+    return enigma::texture_resident;
+}
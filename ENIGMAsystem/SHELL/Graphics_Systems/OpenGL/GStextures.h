@@ -34,4 +34,12 @@
 namespace enigma
 {
     extern bool interpolate_textures;
+    extern int texture_compression; // One of the texture_compress_ constants; applies to textures created afterward
+    extern bool texture_mipmaps;    // Whether textures created afterward get mipmaps
+    extern bool npot_textures;      // Whether textures need not be padded to a power of two
+
+    /// Called once the GL context exists, to see which texture features the card has.
+    void graphics_textures_initialize();
+    /// Binds a texture and reapplies the interpolation setting to it.
+    void graphics_refilter_texture(unsigned texture);
 }
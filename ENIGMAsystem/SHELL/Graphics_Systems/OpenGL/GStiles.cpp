@@ -0,0 +1,292 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include "OpenGLHeaders.h"
+#include "GStiles.h"
+#include "binding.h"
+
+using namespace std;
+
+#include "Universal_System/var4.h"
+#include "Universal_System/roomsystem.h"
+#include "Universal_System/instance_system.h"
+#include "Universal_System/depth_draw.h"
+#include "Universal_System/backgroundstruct.h"
+#include "Graphics_Systems/graphics_mandatory.h"
+
+namespace enigma {
+  extern size_t background_idmax;
+}
+
+namespace
+{
+  // One draw call's worth of tiles: the tiles in a layer that share a texture and begin in the same
+  // square of the room. Its bounds let views skip it without looking at the tiles.
+  struct tile_batch
+  {
+    unsigned texture;
+    GLuint buffer; // Zero when vertex buffer objects are unavailable; data is then drawn from client memory.
+    GLsizei vertices;
+    vector<GLfloat> data; // Interleaved x, y, u, v; emptied once uploaded to a buffer.
+    int left, top, right, bottom;
+    tile_batch(unsigned tex): texture(tex), buffer(0), vertices(0), left(0), top(0), right(0), bottom(0) {}
+  };
+  const int tile_batch_span = 1024; // Side of the squares of the room that batches are cut into
+
+  struct tile_layer_cache
+  {
+    vector<tile_batch> batches;
+    bool dirty, hidden;
+    tile_layer_cache(): dirty(true), hidden(false) {}
+  };
+
+  map<double,tile_layer_cache> tile_layers;
+  int tile_idmax = 0;
+
+  inline bool use_vbo() {
+    return GLEW_VERSION_1_5;
+  }
+
+  void free_batches(tile_layer_cache &cache)
+  {
+    for (size_t i = 0; i < cache.batches.size(); i++)
+      if (cache.batches[i].buffer)
+        glDeleteBuffers(1, &cache.batches[i].buffer);
+    cache.batches.clear();
+  }
+
+  void bake_layer(tile_layer_cache &cache, const vector<enigma::tile> &tiles)
+  {
+    free_batches(cache);
+    cache.dirty = false;
+
+    // Batches are kept in order of each texture and square's first appearance in the layer.
+    typedef pair<pair<int,int>,unsigned> batch_key;
+    map<batch_key,size_t> batch_of_key;
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+      const enigma::tile &t = tiles[i];
+      if (t.bckid < 0 or size_t(t.bckid) >= enigma::background_idmax or !enigma::backgroundstructarray[t.bckid])
+        continue;
+      const enigma::background *const bck2d = enigma::backgroundstructarray[t.bckid];
+
+      const batch_key key(pair<int,int>(int(floor(double(t.roomX) / tile_batch_span)), int(floor(double(t.roomY) / tile_batch_span))), bck2d->texture);
+      map<batch_key,size_t>::iterator bit = batch_of_key.find(key);
+      if (bit == batch_of_key.end()) {
+        bit = batch_of_key.insert(pair<batch_key,size_t>(key, cache.batches.size())).first;
+        cache.batches.push_back(tile_batch(bck2d->texture));
+        tile_batch &nb = cache.batches.back();
+        nb.left = nb.right = t.roomX, nb.top = nb.bottom = t.roomY;
+      }
+      tile_batch &b = cache.batches[bit->second];
+      b.left = min(b.left, t.roomX), b.right = max(b.right, t.roomX + t.width);
+      b.top = min(b.top, t.roomY), b.bottom = max(b.bottom, t.roomY + t.height);
+
+      const float tbw = bck2d->width/(float)bck2d->texbordx, tbh = bck2d->height/(float)bck2d->texbordy,
+                  tbx1 = t.bgx/tbw, tbx2 = tbx1 + t.width/tbw,
+                  tby1 = t.bgy/tbh, tby2 = tby1 + t.height/tbh;
+      const GLfloat quad[16] = {
+        GLfloat(t.roomX),           GLfloat(t.roomY),            tbx1, tby1,
+        GLfloat(t.roomX + t.width), GLfloat(t.roomY),            tbx2, tby1,
+        GLfloat(t.roomX + t.width), GLfloat(t.roomY + t.height), tbx2, tby2,
+        GLfloat(t.roomX),           GLfloat(t.roomY + t.height), tbx1, tby2
+      };
+      b.data.insert(b.data.end(), quad, quad + 16);
+      b.vertices += 4;
+    }
+
+    if (use_vbo())
+    {
+      for (size_t i = 0; i < cache.batches.size(); i++)
+      {
+        tile_batch &b = cache.batches[i];
+        glGenBuffers(1, &b.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, b.buffer);
+        glBufferData(GL_ARRAY_BUFFER, b.data.size() * sizeof(GLfloat), &b.data[0], GL_STATIC_DRAW);
+        vector<GLfloat>().swap(b.data);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+  }
+
+  bool find_tile(int id, double &depth, size_t &index)
+  {
+    for (enigma::diter dit = enigma::drawing_depths.rbegin(); dit != enigma::drawing_depths.rend(); dit++)
+      for (size_t i = 0; i < dit->second.tiles.size(); i++)
+        if (dit->second.tiles[i].id == id) {
+          depth = dit->first, index = i;
+          return true;
+        }
+    return false;
+  }
+
+  vector<enigma::tile> *layer_tiles(int depth)
+  {
+    map<double,enigma::depth_layer>::iterator it = enigma::drawing_depths.find(depth);
+    if (it == enigma::drawing_depths.end() or it->second.tiles.empty())
+      return NULL;
+    return &it->second.tiles;
+  }
+}
+
+namespace enigma
+{
+  void tile_layer_invalidate(double depth) {
+    tile_layers[depth].dirty = true;
+  }
+
+  void graphics_rebuild_tiles()
+  {
+    for (map<double,tile_layer_cache>::iterator it = tile_layers.begin(); it != tile_layers.end(); it++)
+      free_batches(it->second);
+    tile_layers.clear();
+
+    for (map<double,depth_layer>::iterator it = drawing_depths.begin(); it != drawing_depths.end(); it++)
+    {
+      if (it->second.tiles.empty()) continue;
+      for (size_t i = 0; i < it->second.tiles.size(); i++)
+        if (it->second.tiles[i].id >= tile_idmax)
+          tile_idmax = it->second.tiles[i].id + 1;
+      bake_layer(tile_layers[it->first], it->second.tiles);
+    }
+  }
+
+  void draw_tile_layer(double depth, const vector<tile> &tiles, double left, double top, double right, double bottom)
+  {
+    if (tiles.empty()) return;
+
+    tile_layer_cache &cache = tile_layers[depth];
+    if (cache.hidden) return;
+    if (cache.dirty)
+      bake_layer(cache, tiles);
+
+    glPushAttrib(GL_CURRENT_BIT);
+    glColor4f(1,1,1,1);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    for (size_t i = 0; i < cache.batches.size(); i++)
+    {
+      const tile_batch &b = cache.batches[i];
+      if (b.right < left or b.bottom < top or b.left > right or b.top > bottom)
+        continue;
+      bind_texture(b.texture);
+      const GLfloat *base = NULL;
+      if (b.buffer)
+        glBindBuffer(GL_ARRAY_BUFFER, b.buffer);
+      else
+        base = &b.data[0];
+      glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), base);
+      glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), base + 2);
+      glDrawArrays(GL_QUADS, 0, b.vertices);
+    }
+
+    if (use_vbo())
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPopAttrib();
+  }
+}
+
+int tile_add(int background, int left, int top, int width, int height, int x, int y, int depth)
+{
+  enigma::tile t;
+  t.id = tile_idmax++;
+  t.bckid = background;
+  t.bgx = left, t.bgy = top;
+  t.width = width, t.height = height;
+  t.roomX = x, t.roomY = y;
+  t.depth = depth;
+  enigma::drawing_depths[depth].tiles.push_back(t);
+  enigma::tile_layer_invalidate(depth);
+  return t.id;
+}
+
+bool tile_delete(int id)
+{
+  double depth; size_t index;
+  if (!find_tile(id, depth, index))
+    return false;
+  vector<enigma::tile> &tiles = enigma::drawing_depths[depth].tiles;
+  tiles.erase(tiles.begin() + index);
+  enigma::tile_layer_invalidate(depth);
+  return true;
+}
+
+bool tile_exists(int id)
+{
+  double depth; size_t index;
+  return find_tile(id, depth, index);
+}
+
+bool tile_layer_hide(int depth)
+{
+  if (!layer_tiles(depth)) return false;
+  tile_layers[depth].hidden = true;
+  return true;
+}
+
+bool tile_layer_show(int depth)
+{
+  if (!layer_tiles(depth)) return false;
+  tile_layers[depth].hidden = false;
+  return true;
+}
+
+bool tile_layer_delete(int depth)
+{
+  vector<enigma::tile> *tiles = layer_tiles(depth);
+  if (!tiles) return false;
+  tiles->clear();
+  enigma::tile_layer_invalidate(depth);
+  return true;
+}
+
+bool tile_layer_shift(int depth, int x, int y)
+{
+  vector<enigma::tile> *tiles = layer_tiles(depth);
+  if (!tiles) return false;
+  for (size_t i = 0; i < tiles->size(); i++)
+    (*tiles)[i].roomX += x, (*tiles)[i].roomY += y;
+  enigma::tile_layer_invalidate(depth);
+  return true;
+}
+
+bool tile_layer_depth(int depth, int newdepth)
+{
+  vector<enigma::tile> *tiles = layer_tiles(depth);
+  if (!tiles) return false;
+  if (depth == newdepth) return true;
+
+  vector<enigma::tile> &dest = enigma::drawing_depths[newdepth].tiles;
+  for (size_t i = 0; i < tiles->size(); i++) {
+    dest.push_back((*tiles)[i]);
+    dest.back().depth = newdepth;
+  }
+  tiles->clear();
+
+  tile_layers[newdepth].hidden = tile_layers[depth].hidden;
+  enigma::tile_layer_invalidate(depth);
+  enigma::tile_layer_invalidate(newdepth);
+  return true;
+}
@@ -0,0 +1,45 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef _GSTILES__H
+#define _GSTILES__H
+
+#include <vector>
+#include <cmath>
+
+namespace enigma
+{
+  struct tile;
+
+  /// Tiles are baked into one vertex buffer per background texture per square of the room per depth layer.
+  /// A layer is only re-baked after one of the tile functions below marks it dirty.
+  void tile_layer_invalidate(double depth);
+  /// Draws the layer's buffers that reach into the given rectangle of the room; without one, draws them all.
+  void draw_tile_layer(double depth, const std::vector<tile> &tiles, double left = -HUGE_VAL, double top = -HUGE_VAL,
+                       double right = HUGE_VAL, double bottom = HUGE_VAL);
+}
+
+int tile_add(int background, int left, int top, int width, int height, int x, int y, int depth);
+bool tile_delete(int id);
+bool tile_exists(int id);
+bool tile_layer_hide(int depth);
+bool tile_layer_show(int depth);
+bool tile_layer_delete(int depth);
+bool tile_layer_shift(int depth, int x, int y);
+bool tile_layer_depth(int depth, int newdepth);
+
+#endif
@@ -21,6 +21,7 @@
 #include "OpenGLHeaders.h"
 using namespace std;
 #include "OPENGLStd.h"
+#include "GStextures.h"
 #include "Universal_System/var4.h"
 #include "Universal_System/roomsystem.h" // Room dimensions.
 #include "Graphics_Systems/graphics_mandatory.h" // Room dimensions.
@@ -42,7 +43,8 @@ namespace enigma
     }
     #endif
 
-    //enigma::pbo_isgo=GL_ARB_pixel_buffer_object;
+    enigma::pbo_isgo = GLEW_ARB_pixel_buffer_object;
+    graphics_textures_initialize();
     glMatrixMode(GL_PROJECTION);
       glClearColor(0,0,0,0);
     glMatrixMode(GL_MODELVIEW);
@@ -45,6 +45,8 @@ void part_system_automatic_update(int id, bool automatic);
 void part_system_automatic_draw(int id, bool automatic);
 void part_system_update(int id);
 void part_system_drawit(int id);
+// Caps the threads that automatic updates spread large particle systems over. 0 means one per core.
+void part_system_threads(int count);
 // Particles.
 void part_particles_create(int id, double x, double y, int particle_type_id, int number);
 void part_particles_create_color(int id, double x, double y, int particle_type_id, int color, int number);
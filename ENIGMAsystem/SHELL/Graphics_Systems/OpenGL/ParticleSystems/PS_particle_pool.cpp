@@ -0,0 +1,182 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2012-2013 forthevin                                           **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include "PS_particle_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace enigma
+{
+  size_t particle_pool::grow(size_t number)
+  {
+    const size_t first = count(), n = first + number;
+    x.resize(n), y.resize(n);
+    speed.resize(n), hx.resize(n), hy.resize(n);
+    size.resize(n), angle.resize(n);
+    size_wiggle_offset.resize(n), ang_wiggle_offset.resize(n), speed_wiggle_offset.resize(n), dir_wiggle_offset.resize(n);
+    color.resize(n), alpha.resize(n);
+    life_current.resize(n), life_start.resize(n);
+    sprite_subimageindex_initial.resize(n), sequence.resize(n);
+    return first;
+  }
+
+  static inline int lerp_color(int color1, int color2, float part)
+  {
+    const float r = (1-part)*(color1 & 0xFF)         + part*(color2 & 0xFF);
+    const float g = (1-part)*((color1 >> 8) & 0xFF)  + part*((color2 >> 8) & 0xFF);
+    const float b = (1-part)*((color1 >> 16) & 0xFF) + part*((color2 >> 16) & 0xFF);
+    return int(r) | int(g) << 8 | int(b) << 16;
+  }
+  static inline unsigned char lerp_alpha(float alpha1, float alpha2, float part)
+  {
+    const float a = (1-part)*alpha1 + part*alpha2;
+    return a < 0 ? 0 : a > 255 ? 255 : (unsigned char)a;
+  }
+
+  void particle_pool::advance(size_t begin, size_t end, double wiggle)
+  {
+    const particle_type &t = *pt;
+    float *const px = &x[0], *const py = &y[0], *const sp = &speed[0], *const dx = &hx[0], *const dy = &hy[0];
+
+    // Particles of a destroyed type keep drifting the way they were going.
+    if (!t.alive) {
+      for (size_t i = begin; i < end; i++)
+        px[i] += sp[i]*dx[i], py[i] += sp[i]*dy[i];
+      return;
+    }
+
+    // Shape.
+    const float size_incr = t.size_incr, ang_incr = t.ang_incr;
+    if (size_incr != 0) {
+      float *const sz = &size[0];
+      for (size_t i = begin; i < end; i++)
+        sz[i] = std::max(sz[i] + size_incr, 0.0f);
+    }
+    if (ang_incr != 0) {
+      float *const an = &angle[0];
+      for (size_t i = begin; i < end; i++) {
+        const float a = an[i] + ang_incr;
+        an[i] = a - 360.0f*int(a/360.0f);
+      }
+    }
+
+    // Color and alpha, for the modes that fade over the particle's life.
+    const int *const lc = &life_current[0], *const ls = &life_start[0];
+    if (t.c_mode == two_color || t.c_mode == three_color) {
+      int *const co = &color[0];
+      for (size_t i = begin; i < end; i++) {
+        const float part = 1.0f - float(lc[i])/ls[i];
+        if (t.c_mode == two_color)
+          co[i] = lerp_color(t.color1, t.color2, part);
+        else
+          co[i] = part <= 0.5f ? lerp_color(t.color1, t.color2, 2.0f*part) : lerp_color(t.color2, t.color3, 2.0f*(part - 0.5f));
+      }
+    }
+    if (t.a_mode == two_alpha || t.a_mode == three_alpha) {
+      unsigned char *const al = &alpha[0];
+      const float alpha1 = int(t.alpha1), alpha2 = int(t.alpha2), alpha3 = int(t.alpha3);
+      for (size_t i = begin; i < end; i++) {
+        const float part = 1.0f - float(lc[i])/ls[i];
+        if (t.a_mode == two_alpha)
+          al[i] = lerp_alpha(alpha1, alpha2, part);
+        else
+          al[i] = part <= 0.5f ? lerp_alpha(alpha1, alpha2, 2.0f*part) : lerp_alpha(alpha2, alpha3, 2.0f*(part - 0.5f));
+      }
+    }
+
+    // Motion, in one pass. Turning by dir_incr is a fixed rotation of the heading, and gravity
+    // a fixed vector. Wiggles change how far a particle goes this step, but not its speed or heading.
+    const float speed_incr = t.speed_incr;
+    const float rc = cos(t.dir_incr*M_PI/180.0), rs = sin(t.dir_incr*M_PI/180.0);
+    const float gx = t.grav_amount*cos(t.grav_dir*M_PI/180.0), gy = -t.grav_amount*sin(t.grav_dir*M_PI/180.0);
+    const bool turning = t.dir_incr != 0, gravity = t.grav_amount != 0;
+    const float speed_wiggle = t.speed_wiggle, dir_wiggle = t.dir_wiggle, w = wiggle;
+    const float *const sw = &speed_wiggle_offset[0], *const dw = &dir_wiggle_offset[0];
+    for (size_t i = begin; i < end; i++)
+    {
+      float s = sp[i] + speed_incr, ux = dx[i], uy = dy[i];
+      if (turning) {
+        const float tx = ux*rc + uy*rs;
+        uy = uy*rc - ux*rs, ux = tx;
+      }
+      if (s < 0) { // Moving backward is moving forward the other way.
+        s = -s, ux = -ux, uy = -uy;
+      }
+      if (gravity) {
+        const float vx = s*ux + gx, vy = s*uy + gy;
+        s = sqrtf(vx*vx + vy*vy);
+        if (s > 0)
+          ux = vx/s, uy = vy/s;
+      }
+      sp[i] = s, dx[i] = ux, dy[i] = uy;
+
+      const float step = s + speed_wiggle*wiggle_result(w, sw[i]);
+      if (dir_wiggle != 0) {
+        const float a = dir_wiggle*wiggle_result(w, dw[i])*float(M_PI/180.0), c = cosf(a), sn = sinf(a);
+        const float tx = ux*c + uy*sn;
+        uy = uy*c - ux*sn, ux = tx;
+      }
+      px[i] += step*ux, py[i] += step*uy;
+    }
+  }
+
+  template<typename T> static inline void compact_array(std::vector<T> &v, const std::vector<int> &life, size_t first_dead)
+  {
+    size_t j = first_dead;
+    for (size_t i = first_dead; i < v.size(); i++)
+      if (life[i] > 0)
+        v[j++] = v[i];
+    v.resize(j);
+  }
+
+  size_t particle_pool::compact()
+  {
+    const size_t n = count();
+    size_t first_dead = 0;
+    while (first_dead < n && life_current[first_dead] > 0)
+      first_dead++;
+    if (first_dead == n)
+      return 0;
+
+    compact_array(x, life_current, first_dead), compact_array(y, life_current, first_dead);
+    compact_array(speed, life_current, first_dead), compact_array(hx, life_current, first_dead), compact_array(hy, life_current, first_dead);
+    compact_array(size, life_current, first_dead), compact_array(angle, life_current, first_dead);
+    compact_array(size_wiggle_offset, life_current, first_dead), compact_array(ang_wiggle_offset, life_current, first_dead);
+    compact_array(speed_wiggle_offset, life_current, first_dead), compact_array(dir_wiggle_offset, life_current, first_dead);
+    compact_array(color, life_current, first_dead), compact_array(alpha, life_current, first_dead);
+    compact_array(life_start, life_current, first_dead), compact_array(sprite_subimageindex_initial, life_current, first_dead);
+    compact_array(sequence, life_current, first_dead);
+    compact_array(life_current, life_current, first_dead); // Last, since it decides what the others keep.
+    return n - count();
+  }
+
+  double particle_pool::direction(size_t i) const
+  {
+    const double d = atan2(-hy[i], hx[i])*180.0/M_PI;
+    return d < 0 ? d + 360.0 : d;
+  }
+}
@@ -0,0 +1,76 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2012-2013 forthevin                                           **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef ENIGMA_PS_PARTICLEPOOL
+#define ENIGMA_PS_PARTICLEPOOL
+
+#include <vector>
+#include <cstddef>
+#include "PS_particle_type.h"
+
+namespace enigma
+{
+  // The particles of one type in one particle system, stored as parallel arrays so that
+  // each step runs as straight loops over contiguous memory with the type's settings
+  // hoisted out. Particles stay in the order they were created, which is the drawing order.
+  struct particle_pool
+  {
+    particle_type* pt;
+
+    std::vector<float> x, y;
+    std::vector<float> speed;
+    std::vector<float> hx, hy; // Unit vector along which the particle moves, with y pointing down the screen.
+    std::vector<float> size, angle;
+    std::vector<float> size_wiggle_offset, ang_wiggle_offset, speed_wiggle_offset, dir_wiggle_offset; // [0;1].
+    std::vector<int> color;
+    std::vector<unsigned char> alpha;
+    std::vector<int> life_current, life_start; // Particles left with no life are removed by compact().
+    std::vector<int> sprite_subimageindex_initial;
+    std::vector<unsigned long> sequence; // Creation order across every pool in the system, for drawing by age.
+
+    particle_pool(particle_type* pt): pt(pt) {}
+    size_t count() const { return x.size(); }
+    // Makes room for number particles at the end, and returns the index of the first.
+    size_t grow(size_t number);
+    // Applies the type's changes in shape, color, alpha and motion to particles [begin;end).
+    void advance(size_t begin, size_t end, double wiggle);
+    // Removes the particles with no life left, keeping the others in order. Returns how many were removed.
+    size_t compact();
+    // Direction of motion in degrees, as part_type_direction takes it.
+    double direction(size_t i) const;
+  };
+
+  // Position on the wiggle cycle of a particle, given the system's wiggle. Domain: [-1;1].
+  inline float wiggle_result(float wiggle, float wiggle_offset)
+  {
+    float result_wiggle = wiggle + wiggle_offset;
+    result_wiggle = result_wiggle > 1.0f ? result_wiggle - 1.0f : result_wiggle;
+    return result_wiggle < 0.5f ? -1.0f + 4.0f*result_wiggle : 3.0f - 4.0f*result_wiggle;
+  }
+}
+
+#endif // ENIGMA_PS_PARTICLEPOOL
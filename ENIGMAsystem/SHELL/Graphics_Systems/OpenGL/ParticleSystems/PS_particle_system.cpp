@@ -28,7 +28,8 @@
 #include "PS_particle_system.h"
 #include "PS_particle.h"
 #include "PS_particle_type.h"
-#include "PS_particle_instance.h"
+#include "PS_particle_pool.h"
+#include "PS_particle_workers.h"
 #include "PS_particle_emitter.h"
 #include "PS_particle_attractor.h"
 #include "PS_particle_destroyer.h"
@@ -43,7 +44,6 @@
 #include <GL/gl.h>
 #include <cmath>
 #include <cstdlib>
-#include <list>
 #include <vector>
 
 #define __GETR(x) ((x & 0x0000FF))
@@ -68,6 +68,7 @@ namespace enigma
     int number;
     particle_type* pt;
   };
+  struct particle_chunk;
   struct particle_system
   {
     // Wiggling.
@@ -81,11 +82,20 @@ namespace enigma
     bool oldtonew;
     double x_offset, y_offset;
     double depth; // Integer stored as double.
-    std::list<particle_instance> pi_list;
+    std::vector<particle_pool*> pools; // One per particle type with particles in this system, oldest type first.
+    unsigned long particles_created; // Numbers each new particle for particle_pool::sequence.
     bool auto_update, auto_draw;
     void initialize();
+    particle_pool* get_pool(particle_type* pt);
+    void remove_dead_particles();
+    void clear_particles();
+    int particle_count();
     void update_particlesystem();
-    void draw_particle(particle_instance* it);
+    // The parts of update_particlesystem before and after the particles are aged and
+    // advanced, which update_particlesystems runs for all systems at once.
+    void begin_update(std::vector<particle_chunk>& chunks);
+    void finish_update(particle_chunk* chunks, size_t chunk_count);
+    void batch_particles(particle_pool* pool, size_t begin, size_t end, bool reverse);
     void draw_particlesystem();
     void create_particles(double x, double y, particle_type* pt, int number, bool use_color=false, int given_color=c_white);
     // Emitters.
@@ -113,10 +123,7 @@ namespace enigma
   };
   double particle_system::get_wiggle_result(double wiggle_offset)
   {
-    double result_wiggle = wiggle + wiggle_offset;
-    result_wiggle = result_wiggle > 1.0 ? result_wiggle - 1.0 : result_wiggle;
-    if (result_wiggle < 0.5) return -1.0 + 4*result_wiggle;
-    else return 3.0 - 4.0*result_wiggle;
+    return wiggle_result(wiggle, wiggle_offset);
   }
   void particle_system::initialize()
   {
@@ -125,7 +132,8 @@ namespace enigma
     oldtonew = true;
     auto_update = true, auto_draw = true;
     depth = 0.0;
-    pi_list = std::list<particle_instance>();
+    pools = std::vector<particle_pool*>();
+    particles_created = 0;
     id_to_emitter = std::map<int,particle_emitter*>();
     emitter_max_id = 0;
     id_to_attractor = std::map<int,particle_attractor*>();
@@ -137,207 +145,162 @@ namespace enigma
     id_to_changer = std::map<int,particle_changer*>();
     changer_max_id = 0;
   }
-  void particle_system::update_particlesystem()
+  particle_pool* particle_system::get_pool(particle_type* pt)
   {
-    // Increase wiggle.
-    wiggle += 1.0/wiggle_frequency;
-    if (wiggle > 1.0) {
-      wiggle -= 1.0;
+    for (size_t i = 0; i < pools.size(); i++)
+      if (pools[i]->pt == pt)
+        return pools[i];
+    particle_pool* pool = new particle_pool(pt);
+    pools.push_back(pool);
+    return pool;
+  }
+  // Types whose count reaches 0 after being destroyed are deleted, so a pool is
+  // never left holding a type; empty pools are dropped along with their particles.
+  static void particles_died(particle_type* pt, size_t number)
+  {
+    pt->particle_count -= number;
+    if (pt->particle_count <= 0 && !pt->alive) {
+      // Particle type is no longer used, delete it.
+      int id = pt->id;
+      delete pt;
+      enigma::pt_manager.id_to_particletype.erase(id);
     }
-    // Increase subimage_index.
-    subimage_index++;
-
-    std::vector<generation_info> particles_to_generate;
-    // Handle life and death.
+  }
+  void particle_system::remove_dead_particles()
+  {
+    size_t kept = 0;
+    for (size_t i = 0; i < pools.size(); i++)
     {
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
-      {
-        // Decrease life.
-        it->life_current--;
-        if (it->life_current <= 0) { // Death.
-          particle_type* pt = it->pt;
-
-          // Generated upon end of life.
-          if (pt->alive && pt->death_on) {
-            std::map<int,particle_type*>::iterator death_pt_it = pt_manager.id_to_particletype.find(pt->death_particle_id);
-            if (death_pt_it != pt_manager.id_to_particletype.end()) {
-              generation_info gen_info;
-              gen_info.x = it->x;
-              gen_info.y = it->y;
-              gen_info.number = pt->death_number;
-              gen_info.pt = (*death_pt_it).second;
-              particles_to_generate.push_back(gen_info);
-            }
-          }
-
-          // Death handling.
-          pt->particle_count--;
-          if (pt->particle_count <= 0 && !pt->alive) {
-            // Particle type is no longer used, delete it.
-            int id = pt->id;
-            delete pt;
-            enigma::pt_manager.id_to_particletype.erase(id);
-          }
-          it = pi_list.erase(it);
-        }
+      particle_pool* pool = pools[i];
+      const size_t removed = pool->compact();
+      if (pool->count() == 0) {
+        particle_type* pt = pool->pt;
+        delete pool;
+        if (removed) particles_died(pt, removed);
+        continue;
       }
+      if (removed) particles_died(pool->pt, removed);
+      pools[kept++] = pool;
     }
-    // Shape.
+    pools.resize(kept);
+  }
+  void particle_system::clear_particles()
+  {
+    for (size_t i = 0; i < pools.size(); i++)
     {
-      std::list<particle_instance>::iterator end = pi_list.end();
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->size = std::max(it->size + pt->size_incr, 0.0);
-          it->angle = fmod(it->angle + pt->ang_incr, 360.0);
-        }
-      }
+      particle_type* pt = pools[i]->pt;
+      const size_t number = pools[i]->count();
+      delete pools[i];
+      particles_died(pt, number);
     }
-    // Color and blending.
-    {
-      std::list<particle_instance>::iterator end = pi_list.end();
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        // Color.
-        switch(pt->c_mode) {
-        case one_color : {break;}
-        case two_color : {
-          if (pt->alive) {
-            const int r1 = color_get_red(pt->color1),
-                g1 = color_get_green(pt->color1),
-                b1 = color_get_blue(pt->color1);
-            const int r2 = color_get_red(pt->color2),
-                g2 = color_get_green(pt->color2),
-                b2 = color_get_blue(pt->color2);
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
-        }
-        case three_color : {
-          if (pt->alive) {
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_color, second_color;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_color = pt->color1;
-              second_color = pt->color2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_color = pt->color2;
-              second_color = pt->color3;
-            }
-            const int r1 = color_get_red(first_color),
-                g1 = color_get_green(first_color),
-                b1 = color_get_blue(first_color);
-            const int r2 = color_get_red(second_color),
-                g2 = color_get_green(second_color),
-                b2 = color_get_blue(second_color);
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
-        }
-        case mix_color : {break;}
-        case rgb_color : {break;}
-        case hsv_color : {break;}
-        }
-        // Alpha.
-        switch(pt->a_mode) {
-        case one_alpha : {break;}
-        case two_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->alpha = bounds(int((1-part)*alpha1 + part*alpha2), 0, 255);
-          }
-          break;
-        }
-        case three_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const int alpha3 = pt->alpha3;
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_alpha, second_alpha;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_alpha = alpha1;
-              second_alpha = alpha2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_alpha = alpha2;
-              second_alpha = alpha3;
-            }
-            it->alpha = bounds(int((1-part)*first_alpha + part*second_alpha), 0, 255);
-          }
-          break;
+    pools.clear();
+  }
+  int particle_system::particle_count()
+  {
+    size_t number = 0;
+    for (size_t i = 0; i < pools.size(); i++)
+      number += pools[i]->count();
+    return number;
+  }
+  // A run of one pool's particles, aged and advanced by one job. Spawns are only
+  // collected here, by the job, and created by finish_update in chunk order, so the
+  // result is the same however the chunks were spread over the threads.
+  struct particle_chunk
+  {
+    particle_system* ps;
+    particle_pool* pool;
+    size_t begin, end;
+    int death_particle_id, step_particle_id; // -1 if the type spawns nothing.
+    std::vector<generation_info> deaths, steps;
+  };
+  static const size_t particle_chunk_size = 4096;
+
+  static void update_chunk(void* data, size_t c)
+  {
+    particle_chunk& chunk = ((particle_chunk*)data)[c];
+    particle_pool* pool = chunk.pool;
+    int *const life = &pool->life_current[0];
+    for (size_t i = chunk.begin; i < chunk.end; i++)
+      life[i]--;
+    if (chunk.death_particle_id != -1) {
+      for (size_t i = chunk.begin; i < chunk.end; i++)
+        if (life[i] <= 0) {
+          generation_info gen_info;
+          gen_info.x = pool->x[i];
+          gen_info.y = pool->y[i];
+          gen_info.number = pool->pt->death_number;
+          chunk.deaths.push_back(gen_info);
         }
+    }
+    if (chunk.step_particle_id != -1) {
+      for (size_t i = chunk.begin; i < chunk.end; i++)
+        if (life[i] > 0) {
+          generation_info gen_info;
+          gen_info.x = pool->x[i];
+          gen_info.y = pool->y[i];
+          gen_info.number = pool->pt->step_number;
+          chunk.steps.push_back(gen_info);
         }
-      }
     }
-    // Step.
-    {
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
-      {
-        particle_type* pt = it->pt;
+    pool->advance(chunk.begin, chunk.end, chunk.ps->wiggle);
+  }
 
-        // Generated each step.
-        if (pt->alive && pt->step_on) {
-          std::map<int,particle_type*>::iterator step_pt_it = pt_manager.id_to_particletype.find(pt->step_particle_id);
-          if (step_pt_it != pt_manager.id_to_particletype.end()) {
-            generation_info gen_info;
-            gen_info.x = it->x;
-            gen_info.y = it->y;
-            gen_info.number = pt->step_number;
-            gen_info.pt = (*step_pt_it).second;
-            particles_to_generate.push_back(gen_info);
-          }
-        }
-      }
+  void particle_system::begin_update(std::vector<particle_chunk>& chunks)
+  {
+    // Increase wiggle.
+    wiggle += 1.0/wiggle_frequency;
+    if (wiggle > 1.0) {
+      wiggle -= 1.0;
     }
-    // Move particles.
+    // Increase subimage_index.
+    subimage_index++;
+
+    for (size_t p = 0; p < pools.size(); p++)
     {
-      std::list<particle_instance>::iterator end = pi_list.end();
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+      particle_pool* pool = pools[p];
+      particle_type* pt = pool->pt;
+      particle_chunk chunk;
+      chunk.ps = this, chunk.pool = pool;
+      chunk.death_particle_id = pt->alive && pt->death_on ? pt->death_particle_id : -1;
+      chunk.step_particle_id = pt->alive && pt->step_on ? pt->step_particle_id : -1;
+      for (size_t begin = 0; begin < pool->count(); begin += particle_chunk_size)
       {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->speed += pt->speed_incr;
-          it->direction += pt->dir_incr;
-          if (it->speed < 0) {
-            it->speed = -it->speed;
-            it->direction += 180.0;
-          }
-          it->direction = fmod(it->direction, 360.0);
-          const double speed = it->speed, direction = it->direction;
-          const double grav_amount = pt->grav_amount, grav_dir = pt->grav_dir;
-          const double vx = speed*cos(direction*M_PI/180.0) + grav_amount*cos(grav_dir*M_PI/180.0);
-          const double vy = -(speed*sin(direction*M_PI/180.0) + grav_amount*sin(grav_dir*M_PI/180.0));
-          it->speed = sqrt(vx*vx + vy*vy);
-          it->direction = vx == 0 && vy == 0 ? direction : -atan2(vy,vx)*180.0/M_PI;
-        }
-        double speed = it->speed, direction = it->direction;
-        if (pt->alive) {
-          speed += pt->speed_wiggle*get_wiggle_result(it->speed_wiggle_offset);
-          direction += pt->dir_wiggle*get_wiggle_result(it->dir_wiggle_offset);
-        }
-        it->x += speed*cos(direction*M_PI/180.0);
-        it->y += -speed*sin(direction*M_PI/180.0);
+        chunk.begin = begin;
+        chunk.end = std::min(begin + particle_chunk_size, pool->count());
+        chunks.push_back(chunk);
       }
     }
+  }
+  static void append_spawns(std::vector<generation_info>& to, std::vector<generation_info>& from, int particle_type_id)
+  {
+    std::map<int,particle_type*>::iterator pt_it = pt_manager.id_to_particletype.find(particle_type_id);
+    if (from.empty() || pt_it == pt_manager.id_to_particletype.end()) return;
+    for (size_t i = 0; i < from.size(); i++)
+      from[i].pt = (*pt_it).second;
+    to.insert(to.end(), from.begin(), from.end());
+  }
+  void particle_system::update_particlesystem()
+  {
+    std::vector<particle_chunk> chunks;
+    begin_update(chunks);
+    particle_workers_run(chunks.size(), update_chunk, chunks.empty() ? NULL : &chunks[0]);
+    finish_update(chunks.empty() ? NULL : &chunks[0], chunks.size());
+  }
+  void particle_system::finish_update(particle_chunk* chunks, size_t chunk_count)
+  {
+    // Particles generated by death and each step, as collected while aging.
+    std::vector<generation_info> particles_to_generate;
+    for (size_t c = 0; c < chunk_count; c++)
+    {
+      append_spawns(particles_to_generate, chunks[c].deaths, chunks[c].death_particle_id);
+      append_spawns(particles_to_generate, chunks[c].steps, chunks[c].step_particle_id);
+    }
     // Changers.
     {
       std::map<int,particle_changer*>::iterator end = id_to_changer.end();
       for (std::map<int,particle_changer*>::iterator ch_it = id_to_changer.begin(); ch_it != end; ch_it++)
       {
         particle_changer* p_ch = (*ch_it).second;
-        particle_type* pt1;
-        particle_type* pt2;
         std::map<int,enigma::particle_type*>::iterator pt_it1 = enigma::pt_manager.id_to_particletype.find(p_ch->parttypeid1);
         if (pt_it1 == enigma::pt_manager.id_to_particletype.end()) {
           continue;
@@ -346,31 +309,25 @@ namespace enigma
         if (pt_it2 == enigma::pt_manager.id_to_particletype.end()) {
           continue;
         }
-        pt1 = (*pt_it1).second;
-        pt2 = (*pt_it2).second;
+        particle_type* pt1 = (*pt_it1).second;
+        particle_type* pt2 = (*pt_it2).second;
 
-        std::list<particle_instance>::iterator end = pi_list.end();
-        for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+        for (size_t p = 0; p < pools.size(); p++)
         {
-          if (p_ch->is_inside(it->x, it->y) && it->pt->id == pt1->id) {
-            // Store position of old particle.
-            const double x = it->x, y = it->y;
-            // Destroy the old particle.
-            pt1->particle_count--;
-            if (pt1->particle_count <= 0 && !pt1->alive) {
-              // Particle type is no longer used, delete it.
-              int id = pt1->id;
-              delete pt1;
-              enigma::pt_manager.id_to_particletype.erase(id);
+          particle_pool* pool = pools[p];
+          if (pool->pt != pt1) continue;
+          for (size_t i = 0; i < pool->count(); i++)
+          {
+            if (pool->life_current[i] > 0 && p_ch->is_inside(pool->x[i], pool->y[i])) {
+              // Destroy the old particle, and create a new one at its position.
+              pool->life_current[i] = 0;
+              generation_info gen_info;
+              gen_info.x = pool->x[i];
+              gen_info.y = pool->y[i];
+              gen_info.number = 1;
+              gen_info.pt = pt2;
+              particles_to_generate.push_back(gen_info);
             }
-            it = pi_list.erase(it);
-            // Create a new particle at its position.
-            generation_info gen_info;
-            gen_info.x = x;
-            gen_info.y = y;
-            gen_info.number = 1;
-            gen_info.pt = pt2;
-            particles_to_generate.push_back(gen_info);
           }
         }
       }
@@ -410,38 +367,45 @@ namespace enigma
       for (std::map<int,particle_attractor*>::iterator at_it = id_to_attractor.begin(); at_it != end; at_it++)
       {
         particle_attractor* p_a = (*at_it).second;
-        std::list<particle_instance>::iterator end = pi_list.end();
-        for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+        const float ax = p_a->x, ay = p_a->y, reach = std::max(1.0, p_a->dist_effect);
+        for (size_t p = 0; p < pools.size(); p++)
         {
-          // If the particle is not inside the attractor range of influence,
-          // or is at the attractor's exact position,
-          // skip to next attractor. 
-          const double dx = it->x - p_a->x;
-          const double dy = it->y - p_a->y;
-          const double relative_distance = sqrt(dx*dx + dy*dy)/std::max(1.0, p_a->dist_effect);
-          if (relative_distance > 1.0 || (dx == 0 && dy == 0)) {
-            continue;
-          }
-          const double direction_radians = atan2(-(p_a->y - it->y), p_a->x - it->x);
-          // Determine force.
-          double force_effective_strength;
-          switch (p_a->force_kind)  {
-          case ps_fo_constant : force_effective_strength = p_a->force_strength; break;
-          case ps_fo_linear : force_effective_strength = (1.0 - relative_distance)*p_a->force_strength; break;
-          case ps_fo_quadratic : force_effective_strength = (1.0 - relative_distance)*(1.0 - relative_distance)*p_a->force_strength; break;
-          default : force_effective_strength = p_a->force_strength; break;
-          }
-          // Apply force.
-          if (p_a->additive) {
-            const double vx = it->speed*cos(it->direction*M_PI/180.0) + force_effective_strength*cos(direction_radians);
-            const double vy = -it->speed*sin(it->direction*M_PI/180.0) - force_effective_strength*sin(direction_radians);
-            it->speed = sqrt(vx*vx + vy*vy);
-            const double direction = it->direction;
-            it->direction = vx == 0.0 && vy == 0.0 ? direction : -atan2(vy,vx)*180.0/M_PI;
-          }
-          else {
-            it->x += force_effective_strength*cos(direction_radians);
-            it->y += -force_effective_strength*sin(direction_radians);
+          particle_pool* pool = pools[p];
+          for (size_t i = 0; i < pool->count(); i++)
+          {
+            // If the particle is not inside the attractor range of influence,
+            // or is at the attractor's exact position,
+            // skip to next particle.
+            const float dx = pool->x[i] - ax;
+            const float dy = pool->y[i] - ay;
+            const float distance = sqrtf(dx*dx + dy*dy);
+            const float relative_distance = distance/reach;
+            if (relative_distance > 1.0f || distance == 0) {
+              continue;
+            }
+            // Determine force.
+            double force_effective_strength;
+            switch (p_a->force_kind)  {
+            case ps_fo_constant : force_effective_strength = p_a->force_strength; break;
+            case ps_fo_linear : force_effective_strength = (1.0 - relative_distance)*p_a->force_strength; break;
+            case ps_fo_quadratic : force_effective_strength = (1.0 - relative_distance)*(1.0 - relative_distance)*p_a->force_strength; break;
+            default : force_effective_strength = p_a->force_strength; break;
+            }
+            // Apply force, toward the attractor.
+            const float fx = -force_effective_strength*dx/distance, fy = -force_effective_strength*dy/distance;
+            if (p_a->additive) {
+              const float vx = pool->speed[i]*pool->hx[i] + fx;
+              const float vy = pool->speed[i]*pool->hy[i] + fy;
+              const float speed = sqrtf(vx*vx + vy*vy);
+              pool->speed[i] = speed;
+              if (speed > 0) {
+                pool->hx[i] = vx/speed, pool->hy[i] = vy/speed;
+              }
+            }
+            else {
+              pool->x[i] += fx;
+              pool->y[i] += fy;
+            }
           }
         }
       }
@@ -452,21 +416,14 @@ namespace enigma
       for (std::map<int,particle_destroyer*>::iterator ds_it = id_to_destroyer.begin(); ds_it != end; ds_it++)
       {
         particle_destroyer* p_ds = (*ds_it).second;
-        std::list<particle_instance>::iterator end = pi_list.end();
-        for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+        for (size_t p = 0; p < pools.size(); p++)
         {
-          if (p_ds->is_inside(it->x, it->y)) {
-            particle_type* pt = it->pt;
-
-            // Death handling.
-            pt->particle_count--;
-            if (pt->particle_count <= 0 && !pt->alive) {
-              // Particle type is no longer used, delete it.
-              int id = pt->id;
-              delete pt;
-              enigma::pt_manager.id_to_particletype.erase(id);
+          particle_pool* pool = pools[p];
+          for (size_t i = 0; i < pool->count(); i++)
+          {
+            if (p_ds->is_inside(pool->x[i], pool->y[i])) {
+              pool->life_current[i] = 0;
             }
-            it = pi_list.erase(it);
           }
         }
       }
@@ -477,217 +434,245 @@ namespace enigma
       for (std::map<int,particle_deflector*>::iterator df_it = id_to_deflector.begin(); df_it != end; df_it++)
       {
         particle_deflector* p_df = (*df_it).second;
-        std::list<particle_instance>::iterator end = pi_list.end();
-        for (std::list<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+        for (size_t p = 0; p < pools.size(); p++)
         {
-          if (p_df->is_inside(it->x, it->y)) {
-            particle_type* pt = it->pt;
-
-            // Direction changing.
-            it->direction = fmod(it->direction + 360.0, 360.0);
-            switch (p_df->deflection_kind) {
-            case ps_de_horizontal : {
-              it->direction = it->direction <= 180.0 ? 180.0 - it->direction : 540.0 - it->direction;
-              break;
-            }
-            case ps_de_vertical : {
-              it->direction = 360.0 - it->direction;
-              break;
-            }
-            default : {
-              break;
-            }
+          particle_pool* pool = pools[p];
+          for (size_t i = 0; i < pool->count(); i++)
+          {
+            if (p_df->is_inside(pool->x[i], pool->y[i])) {
+              // Direction changing.
+              switch (p_df->deflection_kind) {
+              case ps_de_horizontal : {
+                pool->hx[i] = -pool->hx[i];
+                break;
+              }
+              case ps_de_vertical : {
+                pool->hy[i] = -pool->hy[i];
+                break;
+              }
+              default : {
+                break;
+              }
+              }
+              // Friction handling.
+              const float new_speed = std::max(0.0, pool->speed[i] - p_df->friction);
+              const float friction_effect = pool->speed[i] - new_speed;
+              pool->speed[i] = new_speed;
+              // Move one step.
+              pool->x[i] += friction_effect*pool->hx[i];
+              pool->y[i] += friction_effect*pool->hy[i];
             }
-            // Friction handling.
-            const double new_speed = std::max(0.0, it->speed - p_df->friction);
-            const double friction_effect = it->speed - new_speed;
-            it->speed = new_speed;
-            // Move one step.
-            it->x += friction_effect*cos(it->direction*M_PI/180.0);
-            it->y += -friction_effect*sin(it->direction*M_PI/180.0);
           }
         }
       }
     }
+    // Remove particles that died or were destroyed or changed this step.
+    remove_dead_particles();
   }
-  void particle_system::draw_particle(particle_instance* it)
+  // Particles are drawn as quads gathered into one vertex stream per system per frame.
+  // Consecutive quads with the same texture and blend mode make up one batch, which is
+  // drawn with a single call; the drawing order is kept.
+  struct particle_vertex
   {
+    GLfloat x, y, u, v;
+    GLubyte color[4];
+  };
+  struct particle_batch
+  {
+    unsigned texture;
+    int blend; // One of the particle_blend values below.
+    size_t first, count; // Vertices.
+  };
+  enum { particle_blend_unchanged, particle_blend_normal, particle_blend_additive };
+  static std::vector<particle_vertex> particle_vertices;
+  static std::vector<particle_batch> particle_batches;
+
+  // Adds a quad of w by h, rotated by rot radians about x,y, at which the point ox,oy of the
+  // image is placed, the way draw_sprite_ext places it.
+  static inline void batch_quad(unsigned texture, int blend, double x, double y, double ox, double oy, double w, double h,
+    double rot, float tbx, float tby, int color, unsigned char alpha)
+  {
+    if (particle_batches.empty() || particle_batches.back().texture != texture || particle_batches.back().blend != blend) {
+      particle_batch batch;
+      batch.texture = texture, batch.blend = blend;
+      batch.first = particle_vertices.size(), batch.count = 0;
+      particle_batches.push_back(batch);
+    }
+    particle_batches.back().count += 4;
+
+    const double c = cos(rot), s = sin(rot);
+    const float
+    ulcx = x - ox*c - oy*s, ulcy = y + ox*s - oy*c, // Upper left corner.
+    wx = w*c, wy = -w*s, hx = h*s, hy = h*c;        // Along the top edge and down the left edge.
+    const GLubyte r = __GETR(color), g = __GETG(color), b = __GETB(color);
+    const particle_vertex quad[4] = {
+      { ulcx,           ulcy,           0,   0,   { r, g, b, alpha } },
+      { ulcx + wx,      ulcy + wy,      tbx, 0,   { r, g, b, alpha } },
+      { ulcx + wx + hx, ulcy + wy + hy, tbx, tby, { r, g, b, alpha } },
+      { ulcx + hx,      ulcy + hy,      0,   tby, { r, g, b, alpha } }
+    };
+    particle_vertices.insert(particle_vertices.end(), quad, quad + 4);
+  }
+  // Batches particles [begin;end) of the pool, from the last to the first if reverse is set.
+  void particle_system::batch_particles(particle_pool* pool, size_t begin, size_t end, bool reverse)
+  {
+    particle_type* pt = pool->pt;
+    if (!pt->alive) { // Draw particles in a limited way if particle type not alive.
+      particle_sprite* ps = enigma::get_particle_sprite(enigma::pt_sh_pixel);
+      if (ps == NULL) return;
+      for (size_t k = begin; k < end; k++)
+      {
+        const size_t i = reverse ? end - 1 - (k - begin) : k;
+        const double size = pool->size[i];
+        if (size <= 0) continue;
+        batch_quad(ps->texture, particle_blend_unchanged, round(pool->x[i]), round(pool->y[i]),
+          size*ps->width/2.0, size*ps->height/2.0, ps->width*size, ps->height*size,
+          pool->angle[i]*M_PI/180.0, 1, 1, pool->color[i], pool->alpha[i]);
+      }
+      return;
+    }
+
+    const int blend = pt->blend_additive ? particle_blend_additive : particle_blend_normal;
+    const enigma::sprite* spr = NULL;
+    particle_sprite* ps = NULL;
+    if (!pt->is_particle_sprite) {
+      if (!enigma::spritestructarray.exists(pt->sprite_id)) return;
+      spr = enigma::spritestructarray[pt->sprite_id];
+    }
+    else {
+      ps = pt->part_sprite;
+    }
+    for (size_t k = begin; k < end; k++)
     {
-      int color = it->color;
-      int alpha = it->alpha;
-      if (it->pt->alive) {  
-        particle_type* pt = it->pt;
+      const size_t i = reverse ? end - 1 - (k - begin) : k;
+      const double size = std::max(0.0, pool->size[i] + pt->size_wiggle*get_wiggle_result(pool->size_wiggle_offset[i]));
+      if (size <= 0) continue;
+      double rot_degrees = pool->angle[i] + pt->ang_wiggle*get_wiggle_result(pool->ang_wiggle_offset[i]);
+      if (pt->ang_relative) {
+        rot_degrees += pool->direction(i);
+      }
+      const double xscale = pt->xscale*size, yscale = pt->yscale*size;
 
-        double size;
-        double rot_degrees;
-        size = std::max(0.0, it->size + pt->size_wiggle*get_wiggle_result(it->size_wiggle_offset));
-        rot_degrees = it->angle + pt->ang_wiggle*get_wiggle_result(it->ang_wiggle_offset);
-        if (pt->ang_relative) {
-          rot_degrees += it->direction;
+      if (spr) { // Sprite.
+        int subimg;
+        const int subimage_count = spr->subcount;
+        if (!pt->sprite_animated) {
+          subimg = pool->sprite_subimageindex_initial[i];
         }
-
-        if (size <= 0) return; // NOTE: Skip to next particle.
-
-        if (!pt->is_particle_sprite) { // Draw sprite.
-          int sprite_id = pt->sprite_id;
-          int subimg;
-          if (!pt->sprite_animated) {
-            subimg = it->sprite_subimageindex_initial;
-          }
-          else {
-            const enigma::sprite *const spr = enigma::spritestructarray[pt->sprite_id];
-            const int subimage_count = spr->subcount;
-            if (pt->sprite_stretched) {
-              subimg = int(subimage_count*(1.0 - 1.0*it->life_current/it->life_start));
-              subimg = subimg >= subimage_count ? subimage_count - 1 : subimg;
-              subimg = subimg % subimage_count;
-            }
-            else {
-              subimg = (subimage_index + it->sprite_subimageindex_initial) % subimage_count;
-            }
-          }
-          const double x = it->x, y = it->y;
-          const double xscale = pt->xscale*size, yscale = pt->yscale*size;
-
-          glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Push 1.
-          if (pt->blend_additive) {
-            glBlendFunc(GL_SRC_ALPHA,GL_ONE);
-          }
-          else {
-            glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-          }
-          draw_sprite_ext(sprite_id, subimg, x, y, xscale, yscale, rot_degrees, color, alpha/255.0);
-          glPopAttrib(); // Pop 1.
+        else if (pt->sprite_stretched) {
+          subimg = int(subimage_count*(1.0 - 1.0*pool->life_current[i]/pool->life_start[i]));
+          subimg = subimg >= subimage_count ? subimage_count - 1 : subimg;
+          subimg = subimg % subimage_count;
         }
-        else { // Draw particle sprite.
-
-          particle_sprite* ps = pt->part_sprite;
-          bind_texture(ps->texture);
-
-          glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Push 1.
-
-          if (pt->blend_additive) {
-            glBlendFunc(GL_SRC_ALPHA,GL_ONE);
-          }
-          else {
-            glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-          }
-
-          glColor4ub(__GETR(color),__GETG(color),__GETB(color), alpha);
-
-          const double rot = rot_degrees*M_PI/180.0;
-
-          const double x = it->x, y = it->y;
-          const double xscale = pt->xscale*size, yscale = pt->yscale*size;
-
-          const float
-          w = ps->width*xscale, h = ps->height*yscale,
-          tbx = 1, tby = 1,
-          wsinrot = w*sin(rot), wcosrot = w*cos(rot);
-
-          glBegin(GL_TRIANGLE_STRIP);
-
-          float
-          ulcx = x - xscale * (ps->width/2.0) * cos(rot) + yscale * (ps->height/2.0) * cos(M_PI/2+rot),
-          ulcy = y + xscale * (ps->width/2.0) * sin(rot) - yscale * (ps->height/2.0) * sin(M_PI/2+rot);
-          glTexCoord2f(0,0);
-          glVertex2f(ulcx,ulcy);
-          glTexCoord2f(tbx,0);
-          glVertex2f(ulcx + wcosrot, ulcy - wsinrot);
-
-          const double mpr = 3*M_PI/2 + rot;
-          ulcx += h * cos(mpr);
-          ulcy -= h * sin(mpr);
-          glTexCoord2f(0,tby);
-          glVertex2f(ulcx,ulcy);
-          glTexCoord2f(tbx,tby);
-          glVertex2f(ulcx + wcosrot, ulcy - wsinrot);
-
-          glEnd();
-
-          glPopAttrib(); // Pop 1.
+        else {
+          subimg = (subimage_index + pool->sprite_subimageindex_initial[i]) % subimage_count;
         }
+        subimg %= subimage_count;
+        batch_quad(spr->texturearray[subimg], blend, pool->x[i], pool->y[i],
+          xscale*spr->xoffset, yscale*spr->yoffset, spr->width*xscale, spr->height*yscale,
+          rot_degrees*M_PI/180.0, spr->texbordxarray[subimg], spr->texbordyarray[subimg], pool->color[i], pool->alpha[i]);
       }
-      else { // Draw particle in a limited way if particle type not alive.
-        double size = it->size;
-        double rot_degrees = it->angle;
-        if (size <= 0) return; // NOTE: Skip to next particle.
-
-        particle_sprite* ps = enigma::get_particle_sprite(enigma::pt_sh_pixel);
-        if (ps == NULL) return; // NOTE: Skip to next particle.
-        bind_texture(ps->texture);
-
-        glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Push 1.
-
-        glColor4ub(__GETR(color),__GETG(color),__GETB(color), alpha);
-
-        const double rot = rot_degrees*M_PI/180.0;
-
-        const double x = round(it->x), y = round(it->y);
-        const double xscale = size, yscale = size;
-
-        const float
-        w = ps->width*xscale, h = ps->height*yscale,
-        tbx = 1, tby = 1,
-        wsinrot = w*sin(rot), wcosrot = w*cos(rot);
-
-        glBegin(GL_TRIANGLE_STRIP);
-
-        float
-        ulcx = x - xscale * (ps->width/2.0) * cos(rot) + yscale * (ps->height/2.0) * cos(M_PI/2+rot),
-        ulcy = y + xscale * (ps->width/2.0) * sin(rot) - yscale * (ps->height/2.0) * sin(M_PI/2+rot);
-        glTexCoord2f(0,0);
-        glVertex2f(ulcx,ulcy);
-        glTexCoord2f(tbx,0);
-        glVertex2f(ulcx + wcosrot, ulcy - wsinrot);
-
-        const double mpr = 3*M_PI/2 + rot;
-        ulcx += h * cos(mpr);
-        ulcy -= h * sin(mpr);
-        glTexCoord2f(0,tby);
-        glVertex2f(ulcx,ulcy);
-        glTexCoord2f(tbx,tby);
-        glVertex2f(ulcx + wcosrot, ulcy - wsinrot);
-
-        glEnd();
-
-        glPopAttrib(); // Pop 1.
+      else { // Particle sprite.
+        batch_quad(ps->texture, blend, pool->x[i], pool->y[i],
+          xscale*ps->width/2.0, yscale*ps->height/2.0, ps->width*xscale, ps->height*yscale,
+          rot_degrees*M_PI/180.0, 1, 1, pool->color[i], pool->alpha[i]);
       }
     }
   }
   void particle_system::draw_particlesystem()
   {
-    glPushMatrix(); // Push 1.
-
-    glTranslated(x_offset, y_offset, 0.0);
-
     // Draw the particle system either from oldest to youngest or reverse.
-    if (oldtonew) {
-      const std::list<particle_instance>::iterator end = pi_list.end();
-      for (std::list<particle_instance>::iterator it = pi_list.begin(); it != end; it++)
+    // Each pool is already in age order, so they are merged by sequence, a run at a time:
+    // the chosen pool's particles are batched until another pool has one due first.
+    particle_vertices.clear();
+    particle_batches.clear();
+    std::vector<size_t> left(pools.size()); // Particles of each pool not yet batched; taken from the front if oldtonew, else the back
+    for (size_t p = 0; p < pools.size(); p++)
+      left[p] = pools[p]->count();
+    for (;;)
+    {
+      size_t next = pools.size(); // The pool holding the particle due first
+      unsigned long due = 0, bound = 0; // Its sequence, and that of the particle due after the run
+      bool bounded = false; // Whether any other pool has particles left
+      for (size_t p = 0; p < pools.size(); p++)
       {
-        draw_particle(&(*it));
+        if (!left[p]) continue;
+        const particle_pool* pool = pools[p];
+        const unsigned long s = pool->sequence[oldtonew ? pool->count() - left[p] : left[p] - 1];
+        if (next == pools.size() or (oldtonew ? s < due : s > due))
+        {
+          if (next != pools.size()) bound = due, bounded = true;
+          next = p, due = s;
+        }
+        else if (!bounded or (oldtonew ? s < bound : s > bound))
+          bound = s, bounded = true;
       }
+      if (next == pools.size()) break;
+
+      particle_pool* pool = pools[next];
+      size_t run = 0;
+      if (oldtonew) {
+        const size_t begin = pool->count() - left[next];
+        while (run < left[next] and (!bounded or pool->sequence[begin + run] < bound)) run++;
+        batch_particles(pool, begin, begin + run, false);
+      }
+      else {
+        while (run < left[next] and (!bounded or pool->sequence[left[next] - 1 - run] > bound)) run++;
+        batch_particles(pool, left[next] - run, left[next], true);
+      }
+      left[next] -= run;
     }
-    else {
-      const std::list<particle_instance>::reverse_iterator rend = pi_list.rend();
-      for (std::list<particle_instance>::reverse_iterator it = pi_list.rbegin(); it != rend; it++)
-      {
-        draw_particle(&(*it));
+    if (particle_vertices.empty()) return;
+
+    glPushMatrix(); // Push 1.
+    glTranslated(x_offset, y_offset, 0.0);
+    glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Push 2.
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    const particle_vertex* base = &particle_vertices[0];
+    glVertexPointer(2, GL_FLOAT, sizeof(particle_vertex), &base->x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(particle_vertex), &base->u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(particle_vertex), base->color);
+
+    // Batches which leave the blend mode unchanged draw with whatever was set on entry,
+    // not with whatever an earlier batch switched to.
+    GLint entry_src, entry_dst;
+    glGetIntegerv(GL_BLEND_SRC, &entry_src);
+    glGetIntegerv(GL_BLEND_DST, &entry_dst);
+    for (size_t b = 0; b < particle_batches.size(); b++)
+    {
+      const particle_batch& batch = particle_batches[b];
+      bind_texture(batch.texture);
+      if (batch.blend == particle_blend_additive) {
+        glBlendFunc(GL_SRC_ALPHA,GL_ONE);
+      }
+      else if (batch.blend == particle_blend_normal) {
+        glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
       }
+      else {
+        glBlendFunc(entry_src,entry_dst);
+      }
+      glDrawArrays(GL_QUADS, batch.first, batch.count);
     }
 
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPopAttrib(); // Pop 2.
     glPopMatrix(); // Pop 1.
   }
   void particle_system::create_particles(double x, double y, particle_type* pt, int number, bool use_color, int given_color)
   {
-    if (number > 0) {
-      pt->particle_count += number;
+    if (number <= 0) {
+      return;
     }
-    for (int i = 0; i < number; i++)
+    pt->particle_count += number;
+    particle_pool* pool = get_pool(pt);
+    const size_t first = pool->grow(number);
+    for (size_t i = first; i < first + number; i++)
     {
-      particle_instance pi;
-      pi.pt = pt;
+      pool->sequence[i] = particles_created++;
       // Shape.
       if (!pt->is_particle_sprite) {
         const enigma::sprite *const spr = enigma::spritestructarray[pt->sprite_id];
@@ -699,21 +684,21 @@ namespace enigma
         else {
           subimageindex_initial = 0;
         }
-        pi.sprite_subimageindex_initial = subimageindex_initial;
+        pool->sprite_subimageindex_initial[i] = subimageindex_initial;
       }
       else {
-        pi.sprite_subimageindex_initial = -1;
+        pool->sprite_subimageindex_initial[i] = -1;
       }
-      pi.size = pt->size_min + (pt->size_max-pt->size_min)*1.0*rand()/(RAND_MAX-1);
-      pi.size_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
-      pi.angle = pt->ang_min + (pt->ang_max-pt->ang_min)*1.0*rand()/(RAND_MAX-1);
-      pi.ang_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
+      pool->size[i] = pt->size_min + (pt->size_max-pt->size_min)*1.0*rand()/(RAND_MAX-1);
+      pool->size_wiggle_offset[i] = 1.0*rand()/(RAND_MAX-1);
+      pool->angle[i] = pt->ang_min + (pt->ang_max-pt->ang_min)*1.0*rand()/(RAND_MAX-1);
+      pool->ang_wiggle_offset[i] = 1.0*rand()/(RAND_MAX-1);
       // Color and blending.
-      pi.color = pt->color1;
+      int color = pt->color1;
       switch(pt->c_mode) {
       case one_color : {
         if (use_color) {
-          pi.color = given_color;
+          color = given_color;
           break;
         }
         break;
@@ -722,51 +707,53 @@ namespace enigma
       case three_color : {break;}
       case mix_color : {
         if (use_color) {
-          pi.color = given_color;
+          color = given_color;
           break;
         }
         double random_fact = 1.0*rand()/(RAND_MAX-1);
         unsigned char r = bounds(pt->rmin + (pt->rmax - pt->rmin)*random_fact, 0, 255);
         unsigned char g = bounds(pt->gmin + (pt->gmax - pt->gmin)*random_fact, 0, 255);
         unsigned char b = bounds(pt->bmin + (pt->bmax - pt->bmin)*random_fact, 0, 255);
-        pi.color = make_color_rgb(r, g, b);
+        color = make_color_rgb(r, g, b);
         break;
       }
       case rgb_color : {
         if (use_color) {
-          pi.color = given_color;
+          color = given_color;
           break;
         }
         unsigned char r = bounds(pt->rmin + (pt->rmax - pt->rmin)*1.0*rand()/(RAND_MAX-1), 0, 255);
         unsigned char g = bounds(pt->gmin + (pt->gmax - pt->gmin)*1.0*rand()/(RAND_MAX-1), 0, 255);
         unsigned char b = bounds(pt->bmin + (pt->bmax - pt->bmin)*1.0*rand()/(RAND_MAX-1), 0, 255);
-        pi.color = make_color_rgb(r, g, b);
+        color = make_color_rgb(r, g, b);
         break;
       }
       case hsv_color : {
         if (use_color) {
-          pi.color = given_color;
+          color = given_color;
           break;
         }
         unsigned char h = bounds(pt->hmin + (pt->hmax - pt->hmin)*1.0*rand()/(RAND_MAX-1), 0, 255);
         unsigned char s = bounds(pt->smin + (pt->smax - pt->smin)*1.0*rand()/(RAND_MAX-1), 0, 255);
         unsigned char v = bounds(pt->vmin + (pt->vmax - pt->vmin)*1.0*rand()/(RAND_MAX-1), 0, 255);
-        pi.color = make_color_hsv(h, s, v);
+        color = make_color_hsv(h, s, v);
         break;
       }
       }
-      pi.alpha = pt->alpha1;
+      pool->color[i] = color;
+      pool->alpha[i] = bounds(int(pt->alpha1), 0, 255);
       // Life and death.
-      pi.life_current = pt->life_min == pt->life_max ? pt->life_min : pt->life_min + rand() % (	pt->life_max - pt->life_min);
-      pi.life_start = pi.life_current;
+      pool->life_current[i] = pt->life_min == pt->life_max ? pt->life_min : pt->life_min + rand() % (	pt->life_max - pt->life_min);
+      pool->life_start[i] = pool->life_current[i];
       // Motion.
-      pi.x = x;
-      pi.y = y;
-      pi.speed = pt->speed_min + (pt->speed_max-pt->speed_min)*1.0*rand()/(RAND_MAX-1);
-      pi.direction = pt->dir_min + (pt->dir_max-pt->dir_min)*1.0*rand()/(RAND_MAX-1);
-      pi.speed_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
-      pi.dir_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
-      pi_list.push_back(pi);
+      pool->x[i] = x;
+      pool->y[i] = y;
+      pool->speed[i] = pt->speed_min + (pt->speed_max-pt->speed_min)*1.0*rand()/(RAND_MAX-1);
+      const double direction = (pt->dir_min + (pt->dir_max-pt->dir_min)*1.0*rand()/(RAND_MAX-1))*M_PI/180.0;
+      pool->hx[i] = cos(direction);
+      pool->hy[i] = -sin(direction);
+      pool->speed_wiggle_offset[i] = 1.0*rand()/(RAND_MAX-1);
+      pool->dir_wiggle_offset[i] = 1.0*rand()/(RAND_MAX-1);
     }
   }
   int particle_system::create_emitter()
@@ -847,13 +834,26 @@ namespace enigma
 
   void update_particlesystems()
   {
+    // Aging and motion touch nothing outside a system's own particles, so the chunks
+    // of every system are run as one batch; the rest runs system by system.
+    std::vector<particle_system*> systems;
+    std::vector<size_t> first_chunk;
+    std::vector<particle_chunk> chunks;
     std::map<int,particle_system*>::iterator end = ps_manager.id_to_particlesystem.end();
     for (std::map<int,particle_system*>::iterator it = ps_manager.id_to_particlesystem.begin(); it != end; it++)
     {
       if ((*it).second->auto_update) {
-        (*it).second->update_particlesystem();
+        systems.push_back((*it).second);
+        first_chunk.push_back(chunks.size());
+        (*it).second->begin_update(chunks);
       }
     }
+    first_chunk.push_back(chunks.size());
+    particle_workers_run(chunks.size(), update_chunk, chunks.empty() ? NULL : &chunks[0]);
+    for (size_t s = 0; s < systems.size(); s++)
+    {
+      systems[s]->finish_update(chunks.empty() ? NULL : &chunks[0] + first_chunk[s], first_chunk[s + 1] - first_chunk[s]);
+    }
   }
 
   void draw_particlesystems(std::set<int>& particlesystem_ids)
@@ -905,6 +905,7 @@ void part_system_destroy(int id)
   std::map<int,particle_system*>::iterator it = ps_manager.id_to_particlesystem.find(id);
   if (it != ps_manager.id_to_particlesystem.end()) {
     particle_system* p_s = (*it).second;
+    p_s->clear_particles();
     delete p_s;
     ps_manager.id_to_particlesystem.erase(it);
   }
@@ -1027,22 +1028,16 @@ void part_particles_clear(int id)
 {
   std::map<int,particle_system*>::iterator ps_it = ps_manager.id_to_particlesystem.find(id);
   if (ps_it != ps_manager.id_to_particlesystem.end()) {
-    particle_system* p_s = (*ps_it).second;
-    for (std::list<enigma::particle_instance>::iterator it = p_s->pi_list.begin(); it != p_s->pi_list.end(); it++)
-    {
-      particle_type* pt = it->pt;
-
-      // Death handling.
-      pt->particle_count--;
-      if (pt->particle_count <= 0 && !pt->alive) {
-        // Particle type is no longer used, delete it.
-        int id = pt->id;
-        delete pt;
-        enigma::pt_manager.id_to_particletype.erase(id);
-      }
-    }
-    p_s->pi_list.clear();
+    (*ps_it).second->clear_particles();
+  }
+}
+int part_particles_count(int id)
+{
+  std::map<int,particle_system*>::iterator ps_it = ps_manager.id_to_particlesystem.find(id);
+  if (ps_it != ps_manager.id_to_particlesystem.end()) {
+    return (*ps_it).second->particle_count();
   }
+  return 0;
 }
 void part_particles_position(int id, double x, double y)
 {
@@ -0,0 +1,132 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2012-2013 forthevin                                           **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include "PS_particle_workers.h"
+#include "PS_particle.h"
+
+#ifdef _WIN32
+  // No thread library is linked on this platform; jobs run one after another on the calling thread.
+  namespace enigma
+  {
+    void particle_workers_run(size_t count, void (*job)(void* data, size_t i), void* data)
+    {
+      for (size_t i = 0; i < count; i++)
+        job(data, i);
+    }
+    int particle_workers_count() { return 1; }
+  }
+  void part_system_threads(int count) {}
+#else
+  #include <pthread.h>
+  #include <unistd.h>
+  #include <vector>
+  namespace enigma
+  {
+    // Workers are started the first time they are needed and sleep between batches.
+    // A batch is claimed job by job under the mutex; jobs are chunks of thousands of
+    // particles, so the lock is never contended for long.
+    static int workers_wanted = 0; // Cap set by part_system_threads, or 0 for one thread per core.
+    static std::vector<pthread_t> workers;
+    static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_cond_t batch_start = PTHREAD_COND_INITIALIZER, batch_done = PTHREAD_COND_INITIALIZER;
+    static unsigned long batch_serial = 0;
+    static size_t batch_count = 0, batch_next = 0, batch_finished = 0;
+    static void (*batch_job)(void*, size_t) = NULL;
+    static void* batch_data = NULL;
+
+    // Runs jobs of the current batch until none are left. Called and returns with batch_mutex held.
+    static void take_jobs()
+    {
+      while (batch_next < batch_count)
+      {
+        const size_t i = batch_next++;
+        pthread_mutex_unlock(&batch_mutex);
+        batch_job(batch_data, i);
+        pthread_mutex_lock(&batch_mutex);
+        if (++batch_finished == batch_count)
+          pthread_cond_broadcast(&batch_done);
+      }
+    }
+
+    // Workers beyond a lowered cap stay asleep.
+    static void *worker_thread(void* index)
+    {
+      unsigned long serial = 0;
+      pthread_mutex_lock(&batch_mutex);
+      for (;;)
+      {
+        while (batch_serial == serial)
+          pthread_cond_wait(&batch_start, &batch_mutex);
+        serial = batch_serial;
+        if (size_t(index) + 1 < size_t(particle_workers_count()))
+          take_jobs();
+      }
+      return NULL;
+    }
+
+    int particle_workers_count()
+    {
+      if (workers_wanted)
+        return workers_wanted;
+      static long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      return cores > 1 ? cores : 1;
+    }
+
+    void particle_workers_run(size_t count, void (*job)(void* data, size_t i), void* data)
+    {
+      const size_t wanted = particle_workers_count();
+      if (count <= 1 or wanted <= 1) {
+        for (size_t i = 0; i < count; i++)
+          job(data, i);
+        return;
+      }
+      pthread_mutex_lock(&batch_mutex);
+      while (workers.size() + 1 < wanted) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_thread, (void*)workers.size()))
+          break;
+        workers.push_back(thread);
+      }
+      batch_job = job, batch_data = data;
+      batch_count = count, batch_next = 0, batch_finished = 0;
+      batch_serial++;
+      pthread_cond_broadcast(&batch_start);
+      take_jobs();
+      while (batch_finished < batch_count)
+        pthread_cond_wait(&batch_done, &batch_mutex);
+      batch_count = 0, batch_next = 0;
+      pthread_mutex_unlock(&batch_mutex);
+    }
+  }
+
+  void part_system_threads(int count)
+  {
+    pthread_mutex_lock(&enigma::batch_mutex);
+    enigma::workers_wanted = count > 0 ? count : 0;
+    pthread_mutex_unlock(&enigma::batch_mutex);
+  }
+#endif
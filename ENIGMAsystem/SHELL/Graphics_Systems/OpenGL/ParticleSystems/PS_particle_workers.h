@@ -25,31 +25,19 @@
 **                                                                              **
 \********************************************************************************/
 
-#ifndef ENIGMA_PS_PARTICLEINSTANCE
-#define ENIGMA_PS_PARTICLEINSTANCE
+#ifndef ENIGMA_PS_PARTICLEWORKERS
+#define ENIGMA_PS_PARTICLEWORKERS
 
-#include "PS_particle_type.h"
+#include <cstddef>
 
 namespace enigma
 {
-  struct particle_instance
-  {
-    particle_type* pt;
-
-    int sprite_subimageindex_initial;
-    double size;
-    double size_wiggle_offset; // [-1;1].
-    double angle;
-    double ang_wiggle_offset; // [-1;1].
-    int color;
-    int alpha;
-    int life_current, life_start;
-    double x, y;
-    double speed, direction;
-    double speed_wiggle_offset; // [-1;1].
-    double dir_wiggle_offset; // [-1;1].
-  };
+  // Calls job(data, i) once for every i in [0;count), spread over the worker threads, and
+  // returns once all calls have finished. The calling thread takes jobs as well. Jobs must
+  // not touch anything another job touches; with threads capped at 1, they run in order.
+  void particle_workers_run(size_t count, void (*job)(void* data, size_t i), void* data);
+  // Number of threads jobs are spread over, counting the calling thread.
+  int particle_workers_count();
 }
 
-#endif // ENIGMA_PS_PARTICLEINSTANCE
-
+#endif // ENIGMA_PS_PARTICLEWORKERS
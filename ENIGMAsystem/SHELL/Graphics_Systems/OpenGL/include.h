@@ -1,6 +1,7 @@
 #include "OPENGLStd.h"
 #include "GSsprite.h"
 #include "GSbackground.h"
+#include "GStiles.h"
 
 #include "GSfont.h"
 #include "GScurves.h"
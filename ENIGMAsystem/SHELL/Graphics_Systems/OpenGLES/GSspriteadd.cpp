@@ -70,8 +70,9 @@ int sprite_add(string filename,double imgnumb,double precise,double transparent,
 	delete[] pxdata;
 	//ns.pixeldata=(void**) malloc(sizeof(void*));
 	//ns.pixeldata[0]=bitmapbuffer;
-	enigma::sprite *ns = enigma::spritestructarray[enigma::sprite_idmax] = new enigma::sprite;
-	ns->id = enigma::sprite_idmax;
+	const int id = enigma::spritestructarray.claim();
+	enigma::sprite *ns = enigma::spritestructarray[id] = new enigma::sprite;
+	ns->id = id;
 	ns->subcount  = 1;
 	ns->width     = width;
 	ns->height    = height;
@@ -80,7 +81,7 @@ int sprite_add(string filename,double imgnumb,double precise,double transparent,
 	ns->texbordx  = (double) width/fullwidth;
 	ns->texbordy  = (double) height/fullheight;
 	ns->texturearray[0] = texture;
-	return enigma::sprite_idmax++;
+	return id;
 }
 
 
@@ -94,15 +95,13 @@ int sprite_add(string filename,double imgnumb,double precise,double transparent,
 namespace enigma
 {
   //Allocates and zero-fills the array at game start
-  void sprites_allocate_initial(int spr_highid)
+  void sprites_allocate_initial()
   {
-    spritestructarray = new sprite*[spr_highid+1];
-    for (int i = 0; i < spr_highid; i++)
-      spritestructarray[i] = NULL;
+    spritestructarray.init();
   }
   
   void sprite_safety_override() {
-    sprites_allocate_initial(sprite_idmax);
+    sprites_allocate_initial();
   }
   
   //Adds an empty sprite to the list
@@ -65,5 +65,8 @@ namespace enigma
         
         return ret;
   }
+
+  // OpenGLES doesn't draw tiles yet, so there is nothing cached to rebuild.
+  void graphics_rebuild_tiles() {}
     
 }
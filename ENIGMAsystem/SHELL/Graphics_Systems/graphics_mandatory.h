@@ -39,6 +39,9 @@ namespace enigma
   void graphics_replace_texture_alpha_from_texture(int tex, int copy_tex);
   void graphics_delete_texture(int tex);
 
+  /// Called once the room's tiles have been loaded into the depth layers.
+  void graphics_rebuild_tiles(); /// This should discard any geometry cached for the previous room's tiles.
+
   /// Retrieve image data from a texture, in unsigned char, RGBA format.
   /// This data will be allocated afresh; the pointer and data are yours to manipulate
   /// and must be freed once you are done.
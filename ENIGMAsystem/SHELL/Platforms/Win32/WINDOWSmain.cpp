@@ -63,6 +63,7 @@ namespace enigma //TODO: Find where this belongs
 namespace enigma {
   int initialize_everything();
   int ENIGMA_events();
+  void image_preload_discard();
 } // TODO: synchronize with XLib by moving these declarations to a platform_includes header in the root.
 
 extern double fps;
@@ -159,6 +160,7 @@ int WINAPI WinMain (HINSTANCE hInstance,HINSTANCE hPrevInstance,LPSTR lpCmdLine,
                 enigma::input_push();
             }
         }
+    enigma::image_preload_discard();
 
 
     enigma::DisableDrawing (enigma::hWnd, enigma::window_hDC, hRC);
@@ -89,6 +89,7 @@ extern int amain();
 #include "Universal_System/resource_data.h"
 #include "Universal_System/highscore_functions.h"
 #include "Universal_System/path_functions.h"
+#include "Universal_System/draw_culling.h"
 //#include "Universal_System/motion_planning.h"
 //#include "Universal_System/mp_movement.h"
 
@@ -125,10 +126,12 @@ extern int amain();
 namespace enigma
 {
   int game_ending();
+  void image_preload_discard();
   int game_ending()
   {
     for (enigma::iterator i = instance_list_first(); i; ++i)
       { i->unlink(); delete *i; }
+    image_preload_discard();
     return 0;
   }
 }
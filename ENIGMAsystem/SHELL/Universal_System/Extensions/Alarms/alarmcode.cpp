@@ -2,14 +2,17 @@
 // Copyright 2011 Josh Ventura
 // Licensed under the GNU General Public License, Version 3 or later.
 
+#include <vector>
+#include <cstddef>
 #include "Universal_System/Extensions/recast.h"
 #include "implement.h"
 #include "include.h"
+#include "Universal_System/instance_system_base.h"
 
 declare_recast(enigma::extension_alarm);
 
 extern bool argument_relative;
- 
+
 void action_set_alarm(int steps, int alarmno)
 {
   if (argument_relative)
@@ -17,6 +20,154 @@ void action_set_alarm(int steps, int alarmno)
   else
     recast_current_instance()->alarm[alarmno] = (steps);
 }
-namespace enigma {
-extension_alarm::extension_alarm() { for (int i = 0; i < 12; i++) alarm[i] = -1; }
+
+namespace
+{
+  /* A hierarchical timer wheel: four levels of 64 slots. Level 0 holds alarms due within
+  ** the next 64 steps, one slot per step; each higher level holds 64 times the span of the
+  ** level beneath it, and a slot is redistributed downward when the wheel reaches it.
+  ** Entries are never removed early; a reset or cancelled alarm leaves a stale entry
+  ** behind, which is recognized and skipped when it comes due. */
+  struct alarm_entry
+  {
+    int inst, alarm;
+    unsigned long due;
+    alarm_entry(int i, int a, unsigned long d): inst(i), alarm(a), due(d) {}
+  };
+
+  const int wheel_bits = 6, wheel_size = 1 << wheel_bits, wheel_levels = 4;
+  const unsigned long wheel_span = 1UL << (wheel_bits * wheel_levels);
+
+  std::vector<alarm_entry> wheel[wheel_levels][wheel_size];
+  std::vector<alarm_entry> expiring;
+  size_t expiring_pos = 0;
+
+  // The step currently being dispatched is alarm_tick - 1; alarms set now count from alarm_tick.
+  unsigned long alarm_tick = 0;
+  int alarm_firing = -1;
+
+  inline int slot_of(unsigned long due, int level) {
+    return (due >> (wheel_bits * level)) & (wheel_size - 1);
+  }
+
+  void wheel_insert(const alarm_entry &e)
+  {
+    unsigned long delta = e.due - alarm_tick;
+    if (delta >= wheel_span) // Park distant alarms in the farthest slot; they are reinserted when it cascades
+      delta = wheel_span - 1;
+    int level = 0;
+    while (delta >= 1UL << (wheel_bits * (level + 1)))
+      level++;
+    wheel[level][slot_of(alarm_tick + delta, level)].push_back(e);
+  }
+
+  // Moves every entry in this level's current slot down to where it now belongs.
+  bool cascade(int level)
+  {
+    const int slot = slot_of(alarm_tick, level);
+    std::vector<alarm_entry> moving;
+    moving.swap(wheel[level][slot]);
+    for (size_t i = 0; i < moving.size(); i++)
+      wheel_insert(moving[i]);
+    return slot == 0;
+  }
+}
+
+namespace enigma
+{
+  extension_alarm::extension_alarm() {}
+
+  alarm_list::alarm_list(): owner(-1) {
+    for (int i = 0; i < 12; i++) due[i] = -1;
+  }
+
+  double alarm_list::get(int n) const
+  {
+    if (n < 0 or n >= 12 or due[n] < 0)
+      return -1;
+    if (owner == -1)
+      return due[n];
+    // Alarms of other instances that fire later in the step being dispatched read as 0 until they do.
+    return due[n] > long(alarm_tick) ? due[n] - long(alarm_tick) : 0;
+  }
+
+  void alarm_list::set(int n, double value)
+  {
+    if (n < 0 or n >= 12)
+      return;
+    const long steps = long(value);
+    if (steps < 0) {
+      due[n] = -1;
+      return;
+    }
+    if (owner == -1) {
+      due[n] = steps;
+      return;
+    }
+    due[n] = alarm_tick + steps;
+    wheel_insert(alarm_entry(owner, n, due[n]));
+  }
+
+  void alarm_list::link(int id)
+  {
+    owner = id;
+    for (int n = 0; n < 12; n++)
+      if (due[n] >= 0) {
+        due[n] += alarm_tick;
+        wheel_insert(alarm_entry(owner, n, due[n]));
+      }
+  }
+
+  void alarm_list::unlink()
+  {
+    if (owner == -1)
+      return;
+    for (int n = 0; n < 12; n++)
+      if (due[n] >= 0)
+        due[n] = get(n);
+    owner = -1;
+  }
+
+  bool alarm_list::fire(int n)
+  {
+    if (n != alarm_firing or owner != expiring[expiring_pos - 1].inst or due[n] != long(alarm_tick - 1))
+      return false;
+    due[n] = -1;
+    return true;
+  }
+
+  alarm_ref::alarm_ref(alarm_list *l, int i): variant(l->get(i)), list(l), index(i) {}
+  alarm_ref& alarm_ref::operator=(double value) {
+    list->set(index, value);
+    rval.d = list->get(index);
+    return *this;
+  }
+
+  void alarm_wheel_advance()
+  {
+    if (!slot_of(alarm_tick, 0))
+      for (int level = 1; level < wheel_levels and cascade(level); level++);
+
+    expiring.clear();
+    expiring.swap(wheel[0][slot_of(alarm_tick, 0)]);
+    expiring_pos = 0;
+    alarm_tick++;
+  }
+
+  object_basic *alarm_wheel_next()
+  {
+    while (expiring_pos < expiring.size())
+    {
+      const alarm_entry &e = expiring[expiring_pos++];
+      if (e.due != alarm_tick - 1)
+        continue;
+      object_basic *inst = fetch_instance_by_int(e.inst);
+      if (!inst)
+        continue;
+      alarm_firing = e.alarm;
+      return inst;
+    }
+    alarm_firing = -1;
+    return NULL;
+  }
 }
@@ -3,10 +3,60 @@
 // Licensed under the GNU General Public License, Version 3 or later.
 
 namespace enigma {
+  struct object_basic;
+  struct alarm_list;
+
+  // Stands in for alarm[n] so that reads and writes go through the scheduler. It holds the
+  // alarm's value as a variant, so a read binds anywhere a real or variant could; every
+  // assignment is overridden to write through, since the variant's own would only change the copy.
+  struct alarm_ref: variant
+  {
+    alarm_list *list;
+    int index;
+    alarm_ref(alarm_list *l, int i);
+
+    alarm_ref& operator=(double value);
+    alarm_ref& operator=(const alarm_ref& other) { return *this = other.rval.d; }
+    alarm_ref& operator+=(double value)  { return *this = rval.d + value; }
+    alarm_ref& operator-=(double value)  { return *this = rval.d - value; }
+    alarm_ref& operator*=(double value)  { return *this = rval.d * value; }
+    alarm_ref& operator/=(double value)  { variant::operator/=(value);  return *this = rval.d; }
+    alarm_ref& operator%=(double value)  { variant::operator%=(value);  return *this = rval.d; }
+    alarm_ref& operator<<=(double value) { variant::operator<<=(value); return *this = rval.d; }
+    alarm_ref& operator>>=(double value) { variant::operator>>=(value); return *this = rval.d; }
+    alarm_ref& operator&=(double value)  { variant::operator&=(value);  return *this = rval.d; }
+    alarm_ref& operator|=(double value)  { variant::operator|=(value);  return *this = rval.d; }
+    alarm_ref& operator^=(double value)  { variant::operator^=(value);  return *this = rval.d; }
+    alarm_ref& operator++() { return *this += 1; }
+    alarm_ref& operator--() { return *this -= 1; }
+    double operator++(int) { const double r = rval.d; *this += 1; return r; }
+    double operator--(int) { const double r = rval.d; *this -= 1; return r; }
+  };
+
+  // Alarms of linked instances hold the step on which they fire, so nothing has to
+  // count them down; unlinked (deactivated) instances hold steps remaining instead.
+  struct alarm_list
+  {
+    long due[12];
+    int owner; // Instance id while linked to the timer wheel, or -1
+
+    alarm_list();
+    alarm_ref operator[](int n) { return alarm_ref(this, n); }
+    double get(int n) const;
+    void set(int n, double value);
+
+    void link(int id);   // Called when the instance is activated
+    void unlink();       // Called when the instance is deactivated or destroyed
+    bool fire(int n);    // Sub check for Alarm n; true only while the wheel is dispatching it
+  };
+
   struct extension_alarm
   {
-    var alarm;
+    alarm_list alarm;
     extension_alarm();
   };
-}
 
+  // Runs once per step in place of iterating every instance's alarms.
+  void alarm_wheel_advance();
+  object_basic *alarm_wheel_next(); // Next instance with an alarm expiring this step, or NULL
+}
@@ -39,27 +39,30 @@ using namespace std;
 int collision_rectangle(double x1, double y1, double x2, double y2, int obj, bool prec /*ignored*/, bool notme);
 
 namespace enigma {
-	extern size_t grid_idmax;
 	extern unsigned bound_texture;
 }
 
 unsigned mp_grid_create(int left,int top,int hcells,int vcells,int cellwidth,int cellheight, double speed_modifier)
 {
-    enigma::gridstructarray_reallocate();
-    new enigma::grid(enigma::grid_idmax, left, top, hcells, vcells, cellwidth, cellheight, 1, speed_modifier);
-    return enigma::grid_idmax-1;
+    const unsigned id = enigma::gridstructarray.claim();
+    new enigma::grid(id, left, top, hcells, vcells, cellwidth, cellheight, 1, speed_modifier);
+    return id;
 }
 
 void mp_grid_destroy(unsigned id)
 {
     delete enigma::gridstructarray[id];
+    enigma::gridstructarray.release(id);
 }
 
 unsigned mp_grid_duplicate(unsigned id)
 {
-    enigma::gridstructarray_reallocate();
-    enigma::gridstructarray[enigma::grid_idmax] = new enigma::grid(*enigma::gridstructarray[id]);
-    return enigma::grid_idmax-1;
+    // A copy of the grid would keep the source's id, and its nodes would point into the source's node array
+    const enigma::grid *src = enigma::gridstructarray[id];
+    const unsigned nid = enigma::gridstructarray.claim();
+    new enigma::grid(nid, src->left, src->top, src->hcells, src->vcells, src->cellwidth, src->cellheight, src->threshold, src->speed_modifier);
+    mp_grid_copy(nid, id);
+    return nid;
 }
 
 void mp_grid_copy(unsigned id, unsigned srcid)
@@ -37,8 +37,8 @@ using std::list;
 
 namespace enigma
 {
-	grid** gridstructarray;
 	size_t grid_idmax=0;
+	resource_registry<grid> gridstructarray(grid_idmax);
 }
 
 namespace enigma
@@ -46,6 +46,7 @@ namespace enigma
     grid::grid(unsigned int id,int left,int top,unsigned int hcells,unsigned int vcells,unsigned int cellwidth,unsigned int cellheight,unsigned threshold,double speed_modifier):
         id(id), left(left), top(top), hcells(hcells), vcells(vcells), cellwidth(cellwidth), cellheight(cellheight), threshold(threshold), speed_modifier(speed_modifier), nodearray()
     {
+        gridstructarray.place(id);
         gridstructarray[id] = this;
         gridstructarray[id]->nodearray.reserve(hcells*vcells);
         for (unsigned int i = 0; i < hcells*vcells; i++)
@@ -78,20 +79,10 @@ namespace enigma
                 gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[i*vcells+c+1]); //bottom
 
             }
-        }
-
-        if (enigma::grid_idmax < id+1)
-          enigma::grid_idmax = id+1;
+        }
     }
     grid::~grid() { gridstructarray[id] = NULL; }
 
-    void gridstructarray_reallocate()
-    {
-        enigma::grid** gridold = gridstructarray;
-        gridstructarray = new grid*[enigma::grid_idmax+2];
-        for (size_t i = 0; i < enigma::grid_idmax; i++) gridstructarray[i] = gridold[i]; delete[] gridold;
-    }
-
     //Helper functions
     unsigned find_heuristic(const node* n0, const node* n1, bool allow_diag) //Distance from n0 to n1
     {
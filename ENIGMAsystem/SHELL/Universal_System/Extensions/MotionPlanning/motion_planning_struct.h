@@ -26,6 +26,7 @@
 \********************************************************************************/
 #include <vector>
 #include <map>
+#include "Universal_System/resource_registry.h"
 using std::vector;
 using std::multimap;
 
@@ -52,7 +53,7 @@ namespace enigma
     grid(unsigned int id,int left,int top,unsigned int hcells,unsigned int vcells,unsigned int cellwidth,unsigned int cellheight, unsigned int threshold, double speed_modifier);
     ~grid();
   };
-  extern grid** gridstructarray;
-  void gridstructarray_reallocate();
+  extern size_t grid_idmax;
+  extern resource_registry<grid> gridstructarray;
   multimap<unsigned,node*> find_path(unsigned id, node* n0, node* n1, bool allow_diag, bool &status);
 }
@@ -3,15 +3,30 @@
 #endif
 
 namespace enigma {
+  struct object_planar;
+
   struct extension_path
   {
     int path_index;
     int path_endaction;
-    bool path_orientation;
+    double path_orientation;
     double path_position;
     double path_positionprevious;
     double path_scale;
     double path_speed;
-    extension_path(): path_index(-1), path_endaction(0), path_orientation(0), path_position(0), path_positionprevious(0), path_scale(1), path_speed(0) {}
+    double path_xorigin, path_yorigin; // Where the first point of the path is placed in the room
+    unsigned path_generation;          // Generation of path_index when the path was started, to notice its id being reused
+    int path_follower;                 // Slot in the follower array while linked and on a path, or -1
+    unsigned long path_ended_at;       // Value of path_step when the end of the path was last reached
+    extension_path(): path_index(-1), path_endaction(0), path_orientation(0), path_position(0), path_positionprevious(0), path_scale(1), path_speed(0),
+      path_xorigin(0), path_yorigin(0), path_generation(0), path_follower(-1), path_ended_at(0) {}
   };
+
+  // Instances on a path sit in one dense array, which is advanced in a single pass each step.
+  void path_follower_link(object_planar *inst, extension_path *ext);   // Called when the instance is activated
+  void path_follower_unlink(extension_path *ext);                      // Called when the instance is deactivated or destroyed
+  void path_update_followers();
+
+  extern unsigned long path_step;   // Number of follower passes run so far
+  extern int path_ends_this_step;   // Number of instances that reached the end of their path in the last pass
 }
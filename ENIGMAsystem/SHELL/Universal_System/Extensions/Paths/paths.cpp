@@ -0,0 +1,206 @@
+// ENIGMA Path Extension
+// Licensed under the GNU General Public License, Version 3 or later.
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include "Universal_System/Extensions/recast.h"
+#include "implement.h"
+#include "Universal_System/planar_object.h"
+#include "Universal_System/pathstruct.h"
+#include "Universal_System/path_functions.h"
+
+declare_recast(enigma::extension_path);
+
+namespace
+{
+  struct path_follower
+  {
+    enigma::object_planar *inst;
+    enigma::extension_path *ext;
+  };
+
+  std::vector<path_follower> followers;
+
+  inline enigma::path *path_of(int index) {
+    return enigma::pathstructarray.exists(index) ? enigma::pathstructarray[index] : NULL;
+  }
+
+  // Scales and rotates an offset from the path's first point, the way path_scale and path_orientation ask.
+  inline void path_transform(const enigma::extension_path *ext, double &dx, double &dy)
+  {
+    const double a = ext->path_orientation * (M_PI / 180), c = cos(a) * ext->path_scale, s = sin(a) * ext->path_scale;
+    const double tx = dx * c + dy * s;
+    dy = dy * c - dx * s, dx = tx;
+  }
+
+  // Where the path, as placed for this instance, puts position @param position.
+  void path_place(const enigma::extension_path *ext, enigma::path *pth, double position, double &x, double &y)
+  {
+    double sx, sy;
+    enigma::path_getXY(pth, sx, sy, 0);
+    enigma::path_getXY(pth, x, y, position);
+    x -= sx, y -= sy;
+    path_transform(ext, x, y);
+    x += ext->path_xorigin, y += ext->path_yorigin;
+  }
+
+  // Applies path_endaction to a follower whose position has run off either end. Returns false if it stopped.
+  bool path_end_reached(enigma::extension_path *ext, enigma::path *pth)
+  {
+    const bool forward = ext->path_position > 1;
+    ext->path_ended_at = enigma::path_step;
+    enigma::path_ends_this_step++;
+    switch (ext->path_endaction)
+    {
+      case 1: // Restart: jump back to the beginning
+          ext->path_position = forward ? fmod(ext->path_position, 1) : 1 - fmod(-ext->path_position, 1);
+        return true;
+      case 2: // Continue: place the path again where this lap ended
+        {
+          double sx, sy, ex, ey;
+          enigma::path_getXY(pth, sx, sy, 0);
+          enigma::path_getXY(pth, ex, ey, 1);
+          double dx = ex - sx, dy = ey - sy;
+          path_transform(ext, dx, dy);
+          if (forward)
+            ext->path_xorigin += dx, ext->path_yorigin += dy;
+          else
+            ext->path_xorigin -= dx, ext->path_yorigin -= dy;
+          ext->path_position = forward ? fmod(ext->path_position, 1) : 1 - fmod(-ext->path_position, 1);
+        }
+        return true;
+      case 3: // Reverse: bounce off the end and head back
+          ext->path_position = forward ? 2 - ext->path_position : -ext->path_position;
+          ext->path_speed = -ext->path_speed;
+        return true;
+      default: // Stop at the end
+          ext->path_position = forward ? 1 : 0;
+        return false;
+    }
+  }
+}
+
+namespace enigma
+{
+  unsigned long path_step = 0;
+  int path_ends_this_step = 0;
+
+  void path_follower_link(object_planar *inst, extension_path *ext)
+  {
+    if (ext->path_index == -1 or ext->path_follower != -1)
+      return;
+    const path_follower f = { inst, ext };
+    ext->path_follower = followers.size();
+    followers.push_back(f);
+  }
+
+  void path_follower_unlink(extension_path *ext)
+  {
+    if (ext->path_follower == -1)
+      return;
+    const size_t slot = ext->path_follower;
+    followers[slot] = followers.back();
+    followers[slot].ext->path_follower = slot;
+    followers.pop_back();
+    ext->path_follower = -1;
+  }
+
+  void path_update_followers()
+  {
+    path_step++;
+    path_ends_this_step = 0;
+    for (size_t i = 0; i < followers.size(); )
+    {
+      object_planar *const inst = followers[i].inst;
+      extension_path *const ext = followers[i].ext;
+      path *const pth = path_of(ext->path_index);
+      if (!pth or pth->pointarray.empty() or pathstructarray.generation(ext->path_index) != ext->path_generation) { // The path was deleted out from under us
+        path_follower_unlink(ext);
+        ext->path_index = -1;
+        continue;
+      }
+
+      // Positions advance by pixels of the placed path, so a larger path_scale means a longer trip
+      ext->path_positionprevious = ext->path_position;
+      const double distance = ext->path_scale ? ext->path_speed / ext->path_scale : 0;
+      double x, y;
+      path_advance(pth, 1, &ext->path_position, &distance, &x, &y);
+
+      bool following = true, jumped = false;
+      if (ext->path_position > 1 or ext->path_position < 0)
+        following = path_end_reached(ext, pth), jumped = ext->path_endaction == 1;
+
+      path_place(ext, pth, ext->path_position, x, y);
+      if (!jumped and (x != inst->x or y != inst->y))
+        inst->direction = fmod(atan2(inst->y - y, x - inst->x) * (180 / M_PI) + 360, 360);
+      inst->x = x, inst->y = y;
+
+      if (following) {
+        inst->speed = 0; // The path moves the instance; its own speed must not move it as well
+        i++;
+      }
+      else {
+        path_follower_unlink(ext);
+        ext->path_index = -1;
+      }
+    }
+  }
+}
+
+void path_start(unsigned pathid, double speed, unsigned endaction, bool absolute)
+{
+  enigma::object_planar *const inst = (enigma::object_planar*)enigma::instance_event_iterator->inst;
+  enigma::extension_path *const ext = recast_current_instance();
+  enigma::path *const pth = path_of(pathid);
+  if (!pth or pth->pointarray.empty())
+    return;
+
+  ext->path_index = pathid;
+  ext->path_generation = enigma::pathstructarray.generation(pathid);
+  ext->path_speed = speed;
+  ext->path_endaction = endaction;
+  ext->path_position = ext->path_positionprevious = speed < 0 ? 1 : 0;
+  inst->speed = 0;
+
+  // An absolute path is followed where it lies; a relative one is moved so that it begins at the instance.
+  double sx, sy;
+  enigma::path_getXY(pth, sx, sy, 0);
+  if (absolute)
+    ext->path_xorigin = sx, ext->path_yorigin = sy;
+  else
+  {
+    double dx, dy;
+    enigma::path_getXY(pth, dx, dy, ext->path_position);
+    dx -= sx, dy -= sy;
+    path_transform(ext, dx, dy);
+    ext->path_xorigin = inst->x - dx, ext->path_yorigin = inst->y - dy;
+  }
+  path_place(ext, pth, ext->path_position, inst->x, inst->y);
+  enigma::path_follower_link(inst, ext);
+}
+
+void path_end()
+{
+  enigma::extension_path *const ext = recast_current_instance();
+  enigma::path_follower_unlink(ext);
+  ext->path_index = -1;
+}
+
+void path_set_position(double position, bool relative)
+{
+  enigma::object_planar *const inst = (enigma::object_planar*)enigma::instance_event_iterator->inst;
+  enigma::extension_path *const ext = recast_current_instance();
+  position = relative ? ext->path_position + position : position;
+  ext->path_position = position < 0 ? 0 : position > 1 ? 1 : position;
+
+  enigma::path *const pth = path_of(ext->path_index);
+  if (pth and !pth->pointarray.empty())
+    path_place(ext, pth, ext->path_position, inst->x, inst->y);
+}
+
+void path_set_speed(double speed, bool relative)
+{
+  enigma::extension_path *const ext = recast_current_instance();
+  ext->path_speed = relative ? ext->path_speed + speed : speed;
+}
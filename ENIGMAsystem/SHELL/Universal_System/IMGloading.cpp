@@ -17,79 +17,385 @@
 
 #include <string>
 using namespace std;
-#include "IMGloading.h"
-
-#include "nlpo2.h"
-inline unsigned int lgpp2(unsigned int x){//Trailing zero count. lg for perfect powers of two
-	x =  (x & -x) - 1;
-	x -= ((x >> 1) & 0x55555555);
-	x =  ((x >> 2) & 0x33333333) + (x & 0x33333333);
-	x =  ((x >> 4) + x) & 0x0f0f0f0f;
-	x += x >> 8;
-	return (x + (x >> 16)) & 63;
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "IMGloading.h"
+
+#include "nlpo2.h"
+inline unsigned int lgpp2(unsigned int x){//Trailing zero count. lg for perfect powers of two
+	x =  (x & -x) - 1;
+	x -= ((x >> 1) & 0x55555555);
+	x =  ((x >> 2) & 0x33333333) + (x & 0x33333333);
+	x =  ((x >> 4) + x) & 0x0f0f0f0f;
+	x += x >> 8;
+	return (x + (x >> 16)) & 63;
 }
-namespace enigma
+
+// Images are decoded from one bulk read of the file into RGBA rows, top row first, with
+// any padding to a power of two left zeroed to the right and bottom. The row converters
+// are plain loops over whole rows so that the compiler can vectorize them.
+
+namespace enigma
 {
-  char* load_bitmap(string filename,int* width,int* height, int* fullwidth, int* fullheight)
+  bool image_pad_pow2 = true;
+
+  static inline unsigned le16(const unsigned char *p) { return p[0] | p[1] << 8; }
+  static inline unsigned le32(const unsigned char *p) { return p[0] | p[1] << 8 | p[2] << 16 | (unsigned)p[3] << 24; }
+  static inline unsigned be32(const unsigned char *p) { return (unsigned)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+  // Allocates a zeroed RGBA buffer for an image of the given size, padded as configured.
+  static unsigned char *image_alloc(int w, int h, int *width, int *height, int *fullwidth, int *fullheight)
+  {
+    *width = w, *height = h;
+    *fullwidth  = image_pad_pow2 ? nlpo2dc(w) + 1 : w;
+    *fullheight = image_pad_pow2 ? nlpo2dc(h) + 1 : h;
+    const size_t size = size_t(*fullwidth) * *fullheight * 4;
+    unsigned char *res = (unsigned char*)new char[size];
+    memset(res, 0, size);
+    return res;
+  }
+
+  static void row_bgr_to_rgba(unsigned char *dst, const unsigned char *src, int n) {
+    for (int i = 0; i < n; i++, dst += 4, src += 3)
+      dst[0] = src[2], dst[1] = src[1], dst[2] = src[0], dst[3] = 255;
+  }
+  static void row_bgra_to_rgba(unsigned char *dst, const unsigned char *src, int n) {
+    for (int i = 0; i < n; i++, dst += 4, src += 4)
+      dst[0] = src[2], dst[1] = src[1], dst[2] = src[0], dst[3] = src[3];
+  }
+
+  static int mask_shift(unsigned mask) {
+    int s = 0;
+    while (s < 32 and !(mask >> s & 1)) s++;
+    return s;
+  }
+
+  static unsigned char *decode_bmp(const unsigned char *data, size_t size, int *width, int *height, int *fullwidth, int *fullheight)
   {
-    FILE *imgfile;
-    int bmpstart,bmpwidth,bmpheight;
-    if(!(imgfile=fopen(filename.c_str(),"r"))) return 0;
-    fseek(imgfile,0,SEEK_END);
-    fseek(imgfile,10,SEEK_SET);
-    if (fread(&bmpstart,1,4,imgfile) != 4)
+    if (size < 54 or data[0] != 'B' or data[1] != 'M')
+      return NULL;
+    const unsigned bmpstart = le32(data + 10), dibsize = le32(data + 14);
+    const int bmpwidth = (int)le32(data + 18), rawheight = (int)le32(data + 22);
+    const unsigned bpp = le16(data + 28), compression = le32(data + 30);
+    const bool bottom_up = rawheight > 0;
+    const int bmpheight = bottom_up ? rawheight : -rawheight;
+    if (bmpwidth <= 0 or bmpheight <= 0 or bmpwidth > 32768 or bmpheight > 32768)
       return NULL;
-    fseek(imgfile,18,SEEK_SET);
-    if (fread(&bmpwidth,1,4,imgfile) != 4)
+    if (!(bpp == 24 and compression == 0) and !(bpp == 32 and (compression == 0 or compression == 3)))
+      return NULL; // Only take 24 and 32-bit bitmaps for now
+
+    const size_t stride = ((size_t(bpp) * bmpwidth + 31) / 32) * 4;
+    if (bmpstart > size or stride * bmpheight > size - bmpstart)
+      return NULL;
+
+    // 32-bit masks; standard BGRA unless the file says otherwise
+    unsigned masks[4] = { 0xFF0000, 0xFF00, 0xFF, 0 };
+    if (compression == 3) {
+      if (size < 66) return NULL;
+      masks[0] = le32(data + 54), masks[1] = le32(data + 58), masks[2] = le32(data + 62);
+      masks[3] = dibsize >= 56 and size >= 70 ? le32(data + 66) : 0;
+    }
+    else if (bpp == 32)
+      masks[3] = 0xFF000000;
+    const bool plain = masks[0] == 0xFF0000 and masks[1] == 0xFF00 and masks[2] == 0xFF;
+
+    unsigned char *bitmap = image_alloc(bmpwidth, bmpheight, width, height, fullwidth, fullheight);
+    const size_t pitch = size_t(*fullwidth) * 4;
+    bool any_alpha = false;
+    for (int ih = 0; ih < bmpheight; ih++)
+    {
+      const unsigned char *src = data + bmpstart + stride * (bottom_up ? bmpheight - 1 - ih : ih);
+      unsigned char *dst = bitmap + pitch * ih;
+      if (bpp == 24)
+        row_bgr_to_rgba(dst, src, bmpwidth);
+      else if (plain)
+        row_bgra_to_rgba(dst, src, bmpwidth);
+      else
+        for (int iw = 0; iw < bmpwidth; iw++) {
+          const unsigned px = le32(src + iw * 4);
+          for (int c = 0; c < 4; c++)
+            dst[iw * 4 + c] = masks[c] ? (px & masks[c]) >> mask_shift(masks[c]) : 255;
+        }
+      if (bpp == 32 and masks[3])
+        for (int iw = 0; iw < bmpwidth and !any_alpha; iw++)
+          any_alpha = dst[iw * 4 + 3];
+    }
+
+    // Most 32-bit bitmaps leave the fourth byte zeroed rather than storing alpha.
+    if (bpp == 32 and !any_alpha)
+      for (int ih = 0; ih < bmpheight; ih++)
+        for (int iw = 0; iw < bmpwidth; iw++)
+          bitmap[pitch * ih + iw * 4 + 3] = 255;
+    return bitmap;
+  }
+
+  static inline unsigned char paeth(int a, int b, int c) {
+    const int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return pa <= pb and pa <= pc ? a : pb <= pc ? b : c;
+  }
+
+  // Non-interlaced PNG of any color type and bit depth; 16-bit samples are cut to 8.
+  static unsigned char *decode_png(const unsigned char *data, size_t size, int *width, int *height, int *fullwidth, int *fullheight)
+  {
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    if (size < 8 or memcmp(data, signature, 8))
       return NULL;
-    if (fread(&bmpheight,1,4,imgfile) != 4)
-      return NULL;
-    
-    fseek(imgfile,28,SEEK_SET); // Color depth
-    
-    if(fgetc(imgfile) != 24) // Only take 24-bit bitmaps for now
-      return 0;
-    
-    int
-      wfdc = nlpo2dc(bmpwidth), widfull = wfdc+1, wflgp2 = lgpp2(widfull)+2,
-      hgtfull = nlpo2dc(bmpheight),
-      ih,iw,tmp=hgtfull++<<wflgp2;
-    char* bitmap=new char[(hgtfull<<wflgp2)|2];
-    long int pad=bmpwidth & 3; //This is that set of nulls that follows each line
-      fseek(imgfile,bmpstart,SEEK_SET);
-    
-    for (ih = 0; ih < hgtfull-bmpheight; ih++) {
-      for (iw = 0; iw < widfull; iw++) {
-        bitmap[tmp]=0;
-        bitmap[tmp+1]=0;
-        bitmap[tmp+2]=0;
-        bitmap[tmp+3]=0;
-        tmp+=4;
+
+    unsigned w = 0, h = 0, depth = 0, ctype = 0, interlace = 0;
+    unsigned char palette[256][4];
+    for (int i = 0; i < 256; i++)
+      palette[i][0] = palette[i][1] = palette[i][2] = 0, palette[i][3] = 255;
+    bool has_key = false;
+    unsigned key[3] = { 0, 0, 0 };
+    string idat;
+
+    for (size_t pos = 8; pos + 12 <= size; )
+    {
+      const unsigned len = be32(data + pos);
+      const unsigned char *type = data + pos + 4, *body = data + pos + 8;
+      if (len > size - pos - 12)
+        return NULL;
+      if (!memcmp(type, "IHDR", 4) and len >= 13) {
+        w = be32(body), h = be32(body + 4), depth = body[8], ctype = body[9], interlace = body[12];
       }
+      else if (!memcmp(type, "PLTE", 4))
+        for (unsigned i = 0; i < len / 3 and i < 256; i++)
+          palette[i][0] = body[i*3], palette[i][1] = body[i*3 + 1], palette[i][2] = body[i*3 + 2];
+      else if (!memcmp(type, "tRNS", 4)) {
+        if (ctype == 3)
+          for (unsigned i = 0; i < len and i < 256; i++)
+            palette[i][3] = body[i];
+        else if (ctype == 0 and len >= 2)
+          has_key = true, key[0] = key[1] = key[2] = body[0] << 8 | body[1];
+        else if (ctype == 2 and len >= 6)
+          has_key = true, key[0] = body[0] << 8 | body[1], key[1] = body[2] << 8 | body[3], key[2] = body[4] << 8 | body[5];
+      }
+      else if (!memcmp(type, "IDAT", 4))
+        idat.append((const char*)body, len);
+      else if (!memcmp(type, "IEND", 4))
+        break;
+      pos += 12 + len;
+    }
+
+    static const unsigned channel_count[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    if (!w or !h or w > 32768 or h > 32768 or interlace or ctype > 6 or !channel_count[ctype])
+      return NULL;
+    if (depth != 1 and depth != 2 and depth != 4 and depth != 8 and depth != 16)
+      return NULL;
+    const unsigned channels = channel_count[ctype], bits = channels * depth;
+    const size_t stride = (size_t(w) * bits + 7) / 8, pxbytes = bits >= 8 ? bits / 8 : 1;
+
+    uLongf rawlen = (stride + 1) * h;
+    unsigned char *raw = (unsigned char*)malloc(rawlen);
+    if (uncompress(raw, &rawlen, (const Bytef*)idat.data(), idat.length()) != Z_OK or rawlen != (stride + 1) * h) {
+      free(raw);
+      return NULL;
     }
-    for(ih=0; ih < bmpheight; ih++)
+
+    // Undo the per-row filters in place; each row follows its filter byte.
+    for (unsigned y = 0; y < h; y++)
     {
-      for (iw=0; iw < bmpwidth; iw++){
-        bitmap[tmp+3] = 255;
-        bitmap[tmp+2] = fgetc(imgfile);
-        bitmap[tmp+1] = fgetc(imgfile);
-        bitmap[tmp]   = fgetc(imgfile);
-        tmp+=4;
+      unsigned char *row = raw + y * (stride + 1) + 1;
+      const unsigned char *up = y ? row - (stride + 1) : NULL;
+      switch (row[-1]) {
+        case 0: break;
+        case 1: for (size_t i = pxbytes; i < stride; i++) row[i] += row[i - pxbytes]; break;
+        case 2: if (up) for (size_t i = 0; i < stride; i++) row[i] += up[i]; break;
+        case 3: for (size_t i = 0; i < stride; i++)
+                  row[i] += ((i >= pxbytes ? row[i - pxbytes] : 0) + (up ? up[i] : 0)) >> 1;
+                break;
+        case 4: for (size_t i = 0; i < stride; i++)
+                  row[i] += paeth(i >= pxbytes ? row[i - pxbytes] : 0, up ? up[i] : 0, i >= pxbytes and up ? up[i - pxbytes] : 0);
+                break;
+        default: free(raw); return NULL;
       }
-      for (iw=0; iw < widfull-bmpwidth; iw++){
-        bitmap[tmp]   = 0;
-        bitmap[tmp+1] = 0;
-        bitmap[tmp+2] = 0;
-        bitmap[tmp+3] = 0;
-        tmp+=4;
+    }
+
+    unsigned char *bitmap = image_alloc(w, h, width, height, fullwidth, fullheight);
+    const size_t pitch = size_t(*fullwidth) * 4;
+    const unsigned maxval = (1 << depth) - 1;
+    for (unsigned y = 0; y < h; y++)
+    {
+      const unsigned char *row = raw + y * (stride + 1) + 1;
+      unsigned char *dst = bitmap + pitch * y;
+      for (unsigned x = 0; x < w; x++, dst += 4)
+      {
+        unsigned s[4]; // Full-precision samples
+        for (unsigned c = 0; c < channels; c++) {
+          const size_t bit = size_t(x * channels + c) * depth;
+          s[c] = depth == 16 ? row[bit / 8] << 8 | row[bit / 8 + 1]
+               : depth == 8 ? row[bit / 8]
+               : (row[bit / 8] >> (8 - depth - bit % 8)) & maxval;
+        }
+        #define to8(v) (depth == 16 ? (v) >> 8 : depth == 8 ? (v) : (v) * 255 / maxval)
+        switch (ctype) {
+          case 0: dst[0] = dst[1] = dst[2] = to8(s[0]); dst[3] = has_key and s[0] == key[0] ? 0 : 255; break;
+          case 2: dst[0] = to8(s[0]), dst[1] = to8(s[1]), dst[2] = to8(s[2]);
+                  dst[3] = has_key and s[0] == key[0] and s[1] == key[1] and s[2] == key[2] ? 0 : 255; break;
+          case 3: memcpy(dst, palette[s[0] & 255], 4); break;
+          case 4: dst[0] = dst[1] = dst[2] = to8(s[0]); dst[3] = to8(s[1]); break;
+          case 6: dst[0] = to8(s[0]), dst[1] = to8(s[1]), dst[2] = to8(s[2]), dst[3] = to8(s[3]); break;
+        }
+        #undef to8
       }
-      fseek(imgfile,pad,SEEK_CUR);
-    }
-    fclose(imgfile);
-    *width  = bmpwidth;
-    *height = bmpheight;
-    *fullwidth  = widfull;
-    *fullheight = hgtfull;
+    }
+    free(raw);
     return bitmap;
   }
+
+  char* decode_image(const unsigned char* data, size_t size, int* width, int* height, int* fullwidth, int* fullheight)
+  {
+    unsigned char *res = decode_bmp(data, size, width, height, fullwidth, fullheight);
+    if (!res)
+      res = decode_png(data, size, width, height, fullwidth, fullheight);
+    return (char*)res;
+  }
+
+  static char *load_image_file(string filename, int* width, int* height, int* fullwidth, int* fullheight)
+  {
+    *width = *height = *fullwidth = *fullheight = 0;
+    FILE *imgfile = fopen(filename.c_str(), "rb");
+    if (!imgfile) return NULL;
+    fseek(imgfile, 0, SEEK_END);
+    const long size = ftell(imgfile);
+    fseek(imgfile, 0, SEEK_SET);
+    if (size <= 0) {
+      fclose(imgfile);
+      return NULL;
+    }
+    unsigned char *data = (unsigned char*)malloc(size);
+    const size_t got = fread(data, 1, size, imgfile);
+    fclose(imgfile);
+    char *res = decode_image(data, got, width, height, fullwidth, fullheight);
+    free(data);
+    return res;
+  }
+}
+
+// Files named to image_preload are decoded by a worker thread. Whichever of sprite_add,
+// sprite_replace or background_add asks for the file next waits for and takes the result;
+// only the texture upload is left for the main thread. Results nobody asked for are
+// freed by image_preload_discard when the game ends.
+
+#include <map>
+
+#ifdef _WIN32
+  // No thread library is linked on this platform; preloading decodes on the spot.
+  namespace enigma {
+    struct preload_job { char *pixels; int width, height, fullwidth, fullheight; };
+    static map<string, preload_job> preloaded;
+  }
+  bool image_preload(string filename) {
+    enigma::preload_job &job = enigma::preloaded[filename];
+    job.pixels = enigma::load_image_file(filename, &job.width, &job.height, &job.fullwidth, &job.fullheight);
+    return job.pixels;
+  }
+  bool image_preload_ready(string filename) {
+    return enigma::preloaded.find(filename) != enigma::preloaded.end();
+  }
+  namespace enigma {
+    static bool take_preloaded(string filename, char **pixels, int* width, int* height, int* fullwidth, int* fullheight) {
+      map<string, preload_job>::iterator it = preloaded.find(filename);
+      if (it == preloaded.end()) return false;
+      *pixels = it->second.pixels, *width = it->second.width, *height = it->second.height;
+      *fullwidth = it->second.fullwidth, *fullheight = it->second.fullheight;
+      preloaded.erase(it);
+      return true;
+    }
+    void image_preload_discard() {
+      for (map<string, preload_job>::iterator it = preloaded.begin(); it != preloaded.end(); it++)
+        delete[] it->second.pixels;
+      preloaded.clear();
+    }
+  }
+#else
+  #include <pthread.h>
+  namespace enigma {
+    struct preload_job {
+      string filename;
+      pthread_t thread;
+      bool done;
+      char *pixels; int width, height, fullwidth, fullheight;
+    };
+    static map<string, preload_job*> preloaded;
+    static pthread_mutex_t preload_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    static void *preload_thread(void *data) {
+      preload_job *job = (preload_job*)data;
+      char *pixels = load_image_file(job->filename, &job->width, &job->height, &job->fullwidth, &job->fullheight);
+      pthread_mutex_lock(&preload_mutex);
+      job->pixels = pixels, job->done = true;
+      pthread_mutex_unlock(&preload_mutex);
+      return NULL;
+    }
+
+    static bool take_preloaded(string filename, char **pixels, int* width, int* height, int* fullwidth, int* fullheight)
+    {
+      pthread_mutex_lock(&preload_mutex);
+      map<string, preload_job*>::iterator it = preloaded.find(filename);
+      if (it == preloaded.end()) {
+        pthread_mutex_unlock(&preload_mutex);
+        return false;
+      }
+      preload_job *job = it->second;
+      preloaded.erase(it);
+      pthread_mutex_unlock(&preload_mutex);
+
+      pthread_join(job->thread, NULL);
+      *pixels = job->pixels, *width = job->width, *height = job->height;
+      *fullwidth = job->fullwidth, *fullheight = job->fullheight;
+      delete job;
+      return true;
+    }
+
+    void image_preload_discard()
+    {
+      pthread_mutex_lock(&preload_mutex);
+      map<string, preload_job*> jobs;
+      jobs.swap(preloaded);
+      pthread_mutex_unlock(&preload_mutex);
+      for (map<string, preload_job*>::iterator it = jobs.begin(); it != jobs.end(); it++) {
+        pthread_join(it->second->thread, NULL);
+        delete[] it->second->pixels;
+        delete it->second;
+      }
+    }
+  }
+
+  bool image_preload(string filename)
+  {
+    enigma::preload_job *job = new enigma::preload_job();
+    job->filename = filename, job->done = false, job->pixels = NULL;
+    pthread_mutex_lock(&enigma::preload_mutex);
+    if (enigma::preloaded.find(filename) != enigma::preloaded.end() or pthread_create(&job->thread, NULL, enigma::preload_thread, job)) {
+      pthread_mutex_unlock(&enigma::preload_mutex);
+      delete job;
+      return false;
+    }
+    enigma::preloaded[filename] = job;
+    pthread_mutex_unlock(&enigma::preload_mutex);
+    return true;
+  }
+
+  bool image_preload_ready(string filename)
+  {
+    pthread_mutex_lock(&enigma::preload_mutex);
+    map<string, enigma::preload_job*>::iterator it = enigma::preloaded.find(filename);
+    const bool ready = it != enigma::preloaded.end() and it->second->done;
+    pthread_mutex_unlock(&enigma::preload_mutex);
+    return ready;
+  }
+#endif
+
+namespace enigma
+{
+  char* load_bitmap(string filename,int* width,int* height, int* fullwidth, int* fullheight)
+  {
+    char *pixels;
+    if (take_preloaded(filename, &pixels, width, height, fullwidth, fullheight))
+      return pixels;
+    return load_image_file(filename, width, height, fullwidth, fullheight);
+  }
 }
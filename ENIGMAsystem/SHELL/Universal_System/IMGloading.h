@@ -25,7 +25,18 @@
 **                                                                              **
 \********************************************************************************/
 
+#include <string>
+#include <stddef.h>
+using std::string;
+
 namespace enigma{
+	// Loads a BMP (24 or 32-bit) or PNG as RGBA rows, top first, padded to a power of two unless image_pad_pow2 is cleared.
 	char* load_bitmap(string filename,int* width,int* height, int* fullwidth, int* fullheight);
+	char* decode_image(const unsigned char* data, size_t size, int* width, int* height, int* fullwidth, int* fullheight);
+	extern bool image_pad_pow2; // Graphics systems that can use textures of any size clear this
+	void image_preload_discard(); // Waits for any preloads nobody took and frees what they decoded
 }
 
+bool image_preload(string filename);       // Begins decoding the file on a worker thread for a later sprite_add or background_add
+bool image_preload_ready(string filename); // Whether that decode has finished
+
@@ -184,7 +184,7 @@ inline void action_move_start() {
 }
 
 inline void action_execute_script(string script,string argument0,string argument1,string argument2,string argument3,string argument4) {}
-#define action_execute_script(script,argument0,argument1,argument2,argument3,argument4) script((argument0),(argument1),(argument2),(argument3),(argument4))
+#define action_execute_script(script,argument0,argument1,argument2,argument3,argument4) script_execute((script),(argument0),(argument1),(argument2),(argument3),(argument4))
 
 inline void action_draw_rectangle(const double x1, const double y1, const double x2, const double y2, const int filled) {
     if (argument_relative) {
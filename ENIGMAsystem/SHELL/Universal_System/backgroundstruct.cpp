@@ -47,8 +47,8 @@ using namespace std;
 #endif
 
 namespace enigma {
-	background** backgroundstructarray;
 	extern size_t background_idmax;
+	resource_registry<background> backgroundstructarray(background_idmax);
 }
 
 
@@ -80,7 +80,7 @@ namespace enigma
   //Adds a subimage to an existing sprite from the exe
   void background_new(int bkgid, unsigned w, unsigned h, unsigned char* chunk, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep)
   {
-    unsigned int fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
+    unsigned int fullwidth = image_pad_pow2 ? nlpo2dc(w)+1 : w, fullheight = image_pad_pow2 ? nlpo2dc(h)+1 : h;
     char *imgpxdata = new char[4*fullwidth*fullheight+1], *imgpxptr = imgpxdata;
     unsigned int rowindex,colindex;
     for (rowindex = 0; rowindex < h; rowindex++)
@@ -95,11 +95,12 @@ namespace enigma
       memset(imgpxptr, 0, (fullwidth-colindex) << 2);
       imgpxptr += (fullwidth-colindex) << 2;
     }
-    memset(imgpxptr,0,(fullheight-h) * fullwidth);
+    memset(imgpxptr,0,((fullheight-h) * fullwidth) << 2);
 
     unsigned texture = graphics_create_texture(fullwidth,fullheight,imgpxdata);
     delete[] imgpxdata;
 
+   backgroundstructarray.place(bkgid);
    backgroundstructarray[bkgid] = useAsTileset ? new background(w,h,texture,transparent,smoothEdges,preload) : new background_tileset(w,h,texture,transparent,smoothEdges,preload,tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
 	  background *bak = backgroundstructarray[bkgid];
 	  bak->texbordx  = (double) w/fullwidth;
@@ -142,18 +143,17 @@ namespace enigma
 	//Allocates and zero-fills the array at game start
 	void backgrounds_init()
 	{
-		backgroundstructarray = new background*[background_idmax+1];
-		for (unsigned i = 0; i < background_idmax; i++)
-			backgroundstructarray[i] = NULL;
+		backgroundstructarray.init();
 	}
 }
 
 #include "estring.h"
 int background_add(string filename, bool transparent, bool smooth, bool preload)
 {
-	enigma::background *bck = enigma::backgroundstructarray[enigma::background_idmax] = new enigma::background;
+	const int id = enigma::backgroundstructarray.claim();
+	enigma::background *bck = enigma::backgroundstructarray[id] = new enigma::background;
     enigma::background_add_to_index(bck, filename, transparent, smooth, preload);
-	return enigma::background_idmax++;
+	return id;
 }
 
 bool background_replace(int back, string filename, bool transparent, bool smooth, bool preload, bool free_texture)
@@ -173,15 +173,16 @@ void background_delete(int back, bool free_texture)
         enigma::graphics_delete_texture(bck->texture);
 
     delete enigma::backgroundstructarray[back];
-    enigma::backgroundstructarray[back] = NULL;
+    enigma::backgroundstructarray.release(back);
 }
 
 int background_duplicate(int back)
 {
     get_backgroundnv(bck_copy,back,-1);
-    enigma::background *bck = enigma::backgroundstructarray[enigma::background_idmax] = new enigma::background;
+    const int id = enigma::backgroundstructarray.claim();
+    enigma::background *bck = enigma::backgroundstructarray[id] = new enigma::background;
     enigma::background_add_copy(bck, bck_copy);
-	return enigma::background_idmax++;
+	return id;
 }
 
 void background_assign(int back, int copy_background, bool free_texture)
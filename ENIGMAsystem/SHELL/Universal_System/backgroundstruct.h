@@ -27,6 +27,7 @@
 \********************************************************************************/
 
 #include <string>
+#include "resource_registry.h"
 
 namespace enigma
 {
@@ -61,7 +62,8 @@ namespace enigma
     background_tileset(int w,int h,unsigned tex,bool trans,bool smth,bool prel,int tw, int th, int ho, int vo, int hs, int vs);
   };
 
-  extern background** backgroundstructarray;
+  extern size_t background_idmax;
+  extern resource_registry<background> backgroundstructarray;
   void background_new(int bkgid, unsigned w, unsigned h, unsigned char* chunk, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep);
   void background_add_to_index(background *nb, std::string filename, bool transparent, bool smoothEdges, bool preload);
   void background_add_copy(background *bak, background *bck_copy);
@@ -0,0 +1,108 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <vector>
+#include <cstddef>
+#include "collisions_object.h"
+#include "draw_culling.h"
+
+using namespace std;
+
+namespace
+{
+  struct draw_cull_info
+  {
+    bool cull;     // Whether instances of this object may be skipped at all
+    double margin; // How far past its bounding box an instance may draw
+    draw_cull_info(): cull(true), margin(0) {}
+  };
+
+  vector<draw_cull_info> object_cull;
+
+  draw_cull_info &cull_info(int obj)
+  {
+    if (size_t(obj) >= object_cull.size())
+      object_cull.resize(obj + 1);
+    return object_cull[obj];
+  }
+}
+
+namespace enigma
+{
+  bool draw_culling_enabled = false;
+  int draw_culling_culled[8], draw_culling_drawn[8];
+
+  void draw_culling_mark_custom(int obj) {
+    cull_info(obj).cull = false;
+  }
+
+  void draw_culling_begin_view(int view) {
+    draw_culling_culled[view] = draw_culling_drawn[view] = 0;
+  }
+
+  bool draw_culling_check(int view, object_basic* inst, double left, double top, double right, double bottom)
+  {
+    if (draw_culling_enabled and inst->object_index >= 0)
+    {
+      static const draw_cull_info defaults;
+      const draw_cull_info &ci = size_t(inst->object_index) < object_cull.size() ? object_cull[inst->object_index] : defaults;
+      if (ci.cull)
+      {
+        const object_collisions* const inst_c = (object_collisions*)inst;
+        if (inst_c->$bbox_right() + ci.margin < left or inst_c->$bbox_left() - ci.margin > right
+        or  inst_c->$bbox_bottom() + ci.margin < top or inst_c->$bbox_top() - ci.margin > bottom) {
+          draw_culling_culled[view]++;
+          return false;
+        }
+      }
+    }
+    draw_culling_drawn[view]++;
+    return true;
+  }
+}
+
+void draw_culling_set_enabled(bool enable) {
+  enigma::draw_culling_enabled = enable;
+}
+
+bool draw_culling_get_enabled() {
+  return enigma::draw_culling_enabled;
+}
+
+void object_set_draw_culling(int obj, bool enable) {
+  if (obj >= 0) cull_info(obj).cull = enable;
+}
+
+bool object_get_draw_culling(int obj) {
+  return obj >= 0 and size_t(obj) < object_cull.size() ? object_cull[obj].cull : true;
+}
+
+void object_set_draw_bounds(int obj, double margin) {
+  if (obj >= 0) cull_info(obj).margin = margin;
+}
+
+double object_get_draw_bounds(int obj) {
+  return obj >= 0 and size_t(obj) < object_cull.size() ? object_cull[obj].margin : 0;
+}
+
+int draw_culling_get_culled(int view) {
+  return view >= 0 and view < 8 ? enigma::draw_culling_culled[view] : 0;
+}
+
+int draw_culling_get_drawn(int view) {
+  return view >= 0 and view < 8 ? enigma::draw_culling_drawn[view] : 0;
+}
@@ -0,0 +1,50 @@
+/** Copyright (C) 2011 Josh Ventura
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+/// Optional culling of draw events against the view being drawn. When enabled,
+/// instances whose bounding box (grown by their object's draw bounds margin)
+/// lies outside the view are skipped. Objects that only use the default draw
+/// are culled automatically; objects with their own draw code must opt in.
+
+#ifndef _DRAW_CULLING__H
+#define _DRAW_CULLING__H
+
+namespace enigma
+{
+  struct object_basic;
+
+  extern bool draw_culling_enabled;
+  extern int draw_culling_culled[8], draw_culling_drawn[8];
+
+  /// Called at load for each object that defines its own draw event.
+  void draw_culling_mark_custom(int obj);
+  /// Resets the counters of the given view before it is drawn.
+  void draw_culling_begin_view(int view);
+  /// Returns whether the instance should be drawn in the given region, and counts the result.
+  bool draw_culling_check(int view, object_basic* inst, double left, double top, double right, double bottom);
+}
+
+void draw_culling_set_enabled(bool enable);
+bool draw_culling_get_enabled();
+void object_set_draw_culling(int obj, bool enable);
+bool object_get_draw_culling(int obj);
+void object_set_draw_bounds(int obj, double margin);
+double object_get_draw_bounds(int obj);
+int draw_culling_get_culled(int view);
+int draw_culling_get_drawn(int view);
+
+#endif
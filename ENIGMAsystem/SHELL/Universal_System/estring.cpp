@@ -18,8 +18,11 @@
 #include <stdio.h>
 #include <string>
 #include <cstdlib>
+#include <string.h>
+#include <map>
 #include "var4.h"
 #include "estring.h"
+using std::map;
 
 #ifdef DEBUG_MODE
 #include "libEGMstd.h"
@@ -37,24 +40,41 @@ static const char ldgrs[256] = {
   1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0
 };
 
+using enigma::string_ref;
+
+// Finds sub in str at or after from. memchr is vectorized by every libc we ship
+// with, so skipping to each candidate first character is much faster than
+// comparing at every position; memmem is not available everywhere.
+static size_t string_find(string_ref str, string_ref sub, size_t from = 0)
+{
+	if (sub.len > str.len or from > str.len - sub.len)
+		return string::npos;
+	if (!sub.len)
+		return from;
+	const char first = sub.ptr[0];
+	const char *p = str.ptr + from, *const end = str.ptr + (str.len - sub.len) + 1;
+	while (p < end) {
+		p = (const char*)memchr(p, first, end - p);
+		if (!p) break;
+		if (!memcmp(p + 1, sub.ptr + 1, sub.len - 1))
+			return p - str.ptr;
+		p++;
+	}
+	return string::npos;
+}
+
 bool is_string(variant val) { return val.type;  }
 bool is_real(variant val)   { return !val.type; }
 string chr(char val) { return string(1,val); }
-int ord(string str)  { return str[0]; }
+int ord(string_ref str)  { return str.len ? str[0] : 0; }
 
 double real(variant str) { return str.type ? atof(((string)str).c_str()) : (double) str; }
 
-size_t string_length(string str) { return str.length(); }
-size_t string_length(const char* str)
-{
-	const char* s = str;
-	while (*s++);
-	return str - s;
-}
+size_t string_length(string_ref str) { return str.len; }
 
-int string_pos(string substr,string str) {
-	const size_t res = str.find(substr,0)+1;
-	return res == string::npos ? -1 : (int)res;
+int string_pos(string_ref substr, string_ref str) {
+	const size_t res = string_find(str, substr);
+	return res == string::npos ? 0 : (int)res + 1;
 }
 
 string string_format(double val, unsigned tot, unsigned dec)
@@ -65,112 +85,136 @@ string string_format(double val, unsigned tot, unsigned dec)
     return fstr.c_str();
 }
 
-string string_copy(string str, int index, int count) {
-	return (size_t)index > str.length()? "": str.substr(index < 2? 0: index-1, count < 1? 0: count);
+string string_copy(string_ref str, int index, int count) {
+	const size_t start = index < 2? 0: index-1;
+	if ((size_t)index > str.len or count < 1) return string();
+	return string(str.ptr + start, (size_t)count < str.len - start? count: str.len - start);
 }
 
-string string_char_at(string str,int index) {
-	unsigned int n = index <= 1? 0: (unsigned int)index-1;
+string string_char_at(string_ref str, int index) {
+	const size_t n = index <= 1? 0: (size_t)index-1;
 	#ifdef DEBUG_MODE
-	  if (n > str.length())
-	    show_error("Index " + toString(index) + " is outside range " + toString(str.length()) + " in the following string:\n\"" + str + "\".", false);
+	  if (n > str.len)
+	    show_error("Index " + toString(index) + " is outside range " + toString(str.len) + " in the following string:\n\"" + str.str() + "\".", false);
   #endif
-	return string(1, str[n]);
+	return n < str.len? string(1, str[n]): string();
 }
 
-string string_delete(string str,int index,int count) {
-	return str.erase(index < 2? 0: index-1, count < 1? 0: count);
+string string_delete(string_ref str, int index, int count) {
+	const size_t start = index < 2? 0: index-1;
+	if (start >= str.len or count < 1) return str.str();
+	const size_t stop = (size_t)count < str.len - start? start + count: str.len;
+	string ret; ret.reserve(str.len - (stop - start));
+	ret.append(str.ptr, start).append(str.ptr + stop, str.len - stop);
+	return ret;
 }
 
-string string_insert(string substr,string str,int index) {
-	if (index<=1) return substr + str;
-	const size_t x = index-1;
-	return x>str.length()? str + substr: str.insert(x, substr);
+string string_insert(string_ref substr, string_ref str, int index) {
+	const size_t x = index <= 1? 0: (size_t)index-1 < str.len? index-1: str.len;
+	string ret; ret.reserve(str.len + substr.len);
+	ret.append(str.ptr, x).append(substr.ptr, substr.len).append(str.ptr + x, str.len - x);
+	return ret;
 }
 
-string string_replace(string str,string substr,string newstr) {
-	size_t pos=str.find(substr,0);
-	return pos==(size_t)-1?str:str.replace(pos,substr.length(),newstr);
+string string_replace(string_ref str, string_ref substr, string_ref newstr) {
+	const size_t pos = string_find(str, substr);
+	if (pos == string::npos) return str.str();
+	string ret; ret.reserve(str.len - substr.len + newstr.len);
+	ret.append(str.ptr, pos).append(newstr.ptr, newstr.len);
+	ret.append(str.ptr + pos + substr.len, str.len - pos - substr.len);
+	return ret;
 }
 
-string string_replace_all(string str,string substr,string newstr) {
-	size_t pos = 0;
-	const size_t sublen = substr.length(), newlen = newstr.length();
-    while((pos=str.find(substr,pos)) != string::npos) {
-		str.replace(pos,sublen,newstr);
-		pos += newlen;
-	}
-	return str;
+// Built front to back in one pass; replacing in place moved the tail once per match.
+string string_replace_all(string_ref str, string_ref substr, string_ref newstr) {
+	if (!substr.len) return str.str();
+	string ret; ret.reserve(str.len);
+	size_t last = 0;
+	for (size_t pos; (pos = string_find(str, substr, last)) != string::npos; last = pos + substr.len)
+		ret.append(str.ptr + last, pos - last).append(newstr.ptr, newstr.len);
+	ret.append(str.ptr + last, str.len - last);
+	return ret;
 }
 
-int string_count(string substr,string str) {
+int string_count(string_ref substr, string_ref str) {
+	if (!substr.len) return 0;
 	size_t pos = 0, occ = 0;
-	const size_t sublen = substr.length();
-  while((pos=str.find(substr,pos))!=-1) occ++, pos += sublen;
-  return occ;
-}
-
-string string_lower(string str) {
-	const size_t len = str.length()-1;
-	for(size_t i = 0; i < len; i++)
-		if(ldgrs[(int)(unsigned char)str[i]] & 2)
-		  str[i] += 32;
-	return str;
-}
-
-string string_upper(string str) {
-	int len=str.length()-1;
-	for(int i = 0; i < len; i++)
-		if(ldgrs[(unsigned char)str[i]]&1) str[i]-=32;
-	return str;
+	while ((pos = string_find(str, substr, pos)) != string::npos) occ++, pos += substr.len;
+	return occ;
 }
 
-string string_repeat(string str,int count) {
-	string ret; ret.reserve(str.length() * count);
-	for(int i = count; i; i--) ret.append(str);
+string string_lower(string_ref str) {
+	string ret(str.ptr, str.len);
+	for(size_t i = 0; i < str.len; i++)
+		if(ldgrs[(unsigned char)ret[i]] & 2)
+		  ret[i] += 32;
 	return ret;
 }
 
-string string_letters(string str) {
-	string ret;
-	for(const char*c=str.c_str();*c;c++)
-		if(ldgrs[(unsigned char)*c]&3) ret+=*c;
+string string_upper(string_ref str) {
+	string ret(str.ptr, str.len);
+	for(size_t i = 0; i < str.len; i++)
+		if(ldgrs[(unsigned char)ret[i]] & 1)
+		  ret[i] -= 32;
 	return ret;
 }
 
-string string_digits(string str) {
+string string_repeat(string_ref str,int count) {
 	string ret;
-	for(const char*c=str.c_str();*c;c++)
-		if(ldgrs[(unsigned char)*c]&4) ret += *c;
+	if (count < 1) return ret;
+	ret.reserve(str.len * count);
+	for(int i = count; i; i--) ret.append(str.ptr, str.len);
 	return ret;
 }
 
-string string_lettersdigits(string str) {
-	string ret;
-	for(const char*c=str.c_str();*c;c++)
-		if(ldgrs[(unsigned char)*c]) ret += *c;
+// Filters a string down to the characters whose class matches the mask.
+static string string_filter(string_ref str, char mask) {
+	string ret; ret.reserve(str.len);
+	for(size_t i = 0; i < str.len; i++)
+		if(ldgrs[(unsigned char)str[i]] & mask) ret += str[i];
 	return ret;
 }
-
-bool string_isletters(string str) {
-	for(const char*c = str.c_str(); *c; c++)
-		if(!(ldgrs[(unsigned char)*c] & 3))
-      return false;
-	return true;
-}
-
-bool string_isdigits(string str) {
-	for(const char*c = str.c_str(); *c; c++)
-		if(!(ldgrs[(unsigned char)*c] & 4))
+static bool string_all(string_ref str, char mask) {
+	for(size_t i = 0; i < str.len; i++)
+		if(!(ldgrs[(unsigned char)str[i]] & mask))
 		  return false;
 	return true;
 }
 
-bool string_islettersdigits(string str) {
-	for(const char*c=str.c_str(); *c; c++)
-		if(!ldgrs[(unsigned char)*c])
-		  return false;
-	return true;
+string string_letters(string_ref str)       { return string_filter(str, 3); }
+string string_digits(string_ref str)        { return string_filter(str, 4); }
+string string_lettersdigits(string_ref str) { return string_filter(str, 7); }
+
+bool string_isletters(string_ref str)       { return string_all(str, 3); }
+bool string_isdigits(string_ref str)        { return string_all(str, 4); }
+bool string_islettersdigits(string_ref str) { return string_all(str, 7); }
+
+static map<unsigned int, string> string_builders;
+static unsigned int string_builders_maxid = 0;
+
+unsigned int string_builder_create() {
+	string_builders[string_builders_maxid];
+	return string_builders_maxid++;
+}
+void string_builder_destroy(unsigned int id) {
+	string_builders.erase(id);
+}
+void string_builder_append(unsigned int id, string_ref str)
+{
+	// Grow geometrically ourselves; some runtimes only reserve what append asks for.
+	string &sb = string_builders[id];
+	if (sb.length() + str.len > sb.capacity())
+		sb.reserve((sb.length() + str.len) * 2);
+	sb.append(str.ptr, str.len);
+}
+void string_builder_clear(unsigned int id) {
+	string_builders[id].clear();
+}
+size_t string_builder_length(unsigned int id) {
+	return string_builders[id].length();
+}
+string string_builder_get(unsigned int id) {
+	return string_builders[id];
 }
 
 //filename fucntions place here as they are just string based
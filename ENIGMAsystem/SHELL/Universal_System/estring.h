@@ -15,41 +15,70 @@
 *** with this code. If not, see <http://www.gnu.org/licenses/>
 **/
 
+#include <string.h>
 #include "var4.h"
 
+namespace enigma
+{
+  // Borrows the characters of a string, var, or variant for the length of one call,
+  // so that passing one to the functions below copies nothing.
+  struct string_ref
+  {
+    const char *ptr;
+    size_t len;
+    
+    string_ref(const string &s):  ptr(s.data()), len(s.length()) {}
+    string_ref(const char *s):    ptr(s), len(strlen(s)) {}
+    string_ref(const variant &v): ptr(v.sval.c_str()), len(v.sval.length()) {}
+    string_ref(const var &v):     ptr((*v).sval.c_str()), len((*v).sval.length()) {}
+    
+    const char *data() const { return ptr; }
+    size_t length() const { return len; }
+    char operator[] (size_t i) const { return ptr[i]; }
+    string str() const { return string(ptr, len); }
+  };
+}
+
 bool is_string(variant val);
 bool is_real(variant val);
 
 string chr(char val);
-int ord(string str);
+int ord(enigma::string_ref str);
 
 double real(variant str);
 
-size_t string_length(string str);
-size_t string_length(const char* str);
-int string_pos(string substr,string str);
+size_t string_length(enigma::string_ref str);
+int string_pos(enigma::string_ref substr, enigma::string_ref str);
 
 string string_format(double val, unsigned tot, unsigned dec);
-string string_copy(string str,int index,int count);
-string string_char_at(string str,int index);
-string string_delete(string str,int index,int count);
-string string_insert(string substr,string str,int index);
-string string_replace(string str,string substr,string newstr);
-string string_replace_all(string str,string substr,string newstr);
-int string_count(string substr,string str);
-
-string string_lower(string str);
-string string_upper(string str);
-
-string string_repeat(string str,int count);
-
-string string_letters(string str);
-string string_digits(string str);
-string string_lettersdigits(string str);
-
-bool string_isletters(string str);
-bool string_isdigits(string str);
-bool string_islettersdigits(string str);
+string string_copy(enigma::string_ref str, int index, int count);
+string string_char_at(enigma::string_ref str, int index);
+string string_delete(enigma::string_ref str, int index, int count);
+string string_insert(enigma::string_ref substr, enigma::string_ref str, int index);
+string string_replace(enigma::string_ref str, enigma::string_ref substr, enigma::string_ref newstr);
+string string_replace_all(enigma::string_ref str, enigma::string_ref substr, enigma::string_ref newstr);
+int string_count(enigma::string_ref substr, enigma::string_ref str);
+
+string string_lower(enigma::string_ref str);
+string string_upper(enigma::string_ref str);
+
+string string_repeat(enigma::string_ref str, int count);
+
+string string_letters(enigma::string_ref str);
+string string_digits(enigma::string_ref str);
+string string_lettersdigits(enigma::string_ref str);
+
+bool string_isletters(enigma::string_ref str);
+bool string_isdigits(enigma::string_ref str);
+bool string_islettersdigits(enigma::string_ref str);
+
+// Accumulates text without building a new string for every concatenation.
+unsigned int string_builder_create();
+void string_builder_destroy(unsigned int id);
+void string_builder_append(unsigned int id, enigma::string_ref str);
+void string_builder_clear(unsigned int id);
+size_t string_builder_length(unsigned int id);
+string string_builder_get(unsigned int id);
 
 string filename_name(string fname);
 string filename_path(string fname);
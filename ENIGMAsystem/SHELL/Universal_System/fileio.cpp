@@ -18,9 +18,15 @@
 // Simple, untuitive, integer based file I/O
 
 #include <stdio.h> //fstream can get staked
+#include <stdlib.h>
+#include <string.h>
 #include <string> //We will use string, though
 using namespace std;
 
+#ifndef _WIN32
+#include <sys/mman.h> //Text files are mapped rather than read where we can
+#endif
+
 #include "darray.h" //Simpler vector with logarithmic time
 #include "fileio.h" //Simpler vector with logarithmic time
 
@@ -37,20 +43,143 @@ namespace enigma
   struct openFile
   {
     FILE *f;      //FILE we opened, or NULL if it has been closed.
-    string sdata; //Use varies depending on type.
-    int spos;      //position in sdata string
+    string sdata; //Name of the file; used to reopen binary files.
     bool eof;
 
-    openFile(): f(NULL), sdata(), spos(0), eof(false) {};
-    openFile(FILE* a,string b): f(a), sdata(b), spos(0), eof(false) {};
+    // Text files opened for reading are loaded whole, and each line is parsed where it lies.
+    const char *text;  //Contents of the file, or NULL
+    size_t tlen;       //Length of text
+    size_t tnext;      //Start of the line after the current one
+    size_t spos, send; //Read position within the current line, and its end
+    bool mapped;       //Whether text is a mapping rather than a malloc'd copy
+    bool at_end;       //Whether the current line ran into the end of the file
+
+    openFile(): f(NULL), sdata(), eof(false), text(NULL), tlen(0), tnext(0), spos(0), send(0), mapped(false), at_end(false) {};
+    openFile(FILE* a,string b): f(a), sdata(b), eof(false), text(NULL), tlen(0), tnext(0), spos(0), send(0), mapped(false), at_end(false) {};
   };
   varray<openFile> files; //Use a dynamic array to store as many files as the user cares to open
   int file_highid = 0; //This isn't what GM does, but it's not a bad idea. GM checks for the smallest unused ID.
+
+  static const size_t file_buffer_size = 1 << 16; //stdio's default buffer costs a system call every few kilobytes
+
+  static void load_text(openFile &mf)
+  {
+    fseek(mf.f, 0, SEEK_END);
+    const long len = ftell(mf.f);
+    fseek(mf.f, 0, SEEK_SET);
+    if (len <= 0)
+      return;
+    #ifndef _WIN32
+      void *m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(mf.f), 0);
+      if (m != MAP_FAILED) {
+        madvise(m, len, MADV_SEQUENTIAL);
+        mf.text = (const char*)m, mf.tlen = len, mf.mapped = true;
+        return;
+      }
+    #endif
+    char *buf = (char*)malloc(len);
+    mf.tlen = fread(buf, 1, len, mf.f); //Text mode translation can make this shorter than len
+    mf.text = buf, mf.mapped = false;
+  }
+
+  static void close_file(int fileid)
+  {
+    openFile &mf = files[fileid];
+    if (mf.text) {
+      #ifndef _WIN32
+        if (mf.mapped)
+          munmap((void*)mf.text, mf.tlen);
+        else
+      #endif
+          free((void*)mf.text);
+      mf.text = NULL;
+    }
+    fclose(mf.f);
+    mf.f = NULL;
+
+    //Determine new high id: Lowest possible
+    for (int i = file_highid; i >= 0; i--)
+      if (files[i].f == NULL)
+        file_highid = i;
+  }
+
+  // Has strtod parse a real from the first len characters at s; the text isn't terminated, so it is copied.
+  static size_t parse_real_strtod(const char *s, size_t len, double &res)
+  {
+    const string num(s, len);
+    char *stop;
+    res = strtod(num.c_str(), &stop);
+    return stop - num.c_str();
+  }
+
+  // Parses a real at s, reading no further than end, in the format sscanf's %lf accepts.
+  // Returns the number of characters used, or 0 if there is no number there.
+  // Decimal numbers of up to 15 significant digits with small exponents are computed
+  // exactly with one multiply or divide; anything else is handed to strtod.
+  static size_t parse_real(const char *s, const char *end, double &res)
+  {
+    static const double pow10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = s;
+    bool neg = false;
+    if (p < end and (*p == '-' or *p == '+'))
+      neg = *p++ == '-';
+    const size_t most = size_t(end - s) < 64 ? end - s : 64; // Enough for any special form
+    if ((end - p >= 2 and *p == '0' and (p[1] == 'x' or p[1] == 'X'))
+        or (p < end and (*p == 'i' or *p == 'I' or *p == 'n' or *p == 'N')))
+      return parse_real_strtod(s, most, res); // Hex, inf and nan
+
+    unsigned long long mant = 0;
+    int digits = 0, exp10 = 0;
+    bool any = false, exact = true;
+    for (; p < end and *p >= '0' and *p <= '9'; p++, any = true)
+      if (digits < 19 and (mant or *p != '0'))
+        mant = mant * 10 + (*p - '0'), digits++;
+      else if (mant)
+        exp10++, exact &= *p == '0';
+    if (p < end and *p == '.') {
+      for (p++; p < end and *p >= '0' and *p <= '9'; p++, any = true)
+        if (digits < 19 and (mant or *p != '0'))
+          mant = mant * 10 + (*p - '0'), digits++, exp10--;
+        else if (!mant)
+          exp10--;
+        else
+          exact &= *p == '0';
+    }
+
+    if (any and p < end and (*p == 'e' or *p == 'E'))
+    {
+      const char *q = p + 1;
+      bool eneg = false;
+      if (q < end and (*q == '-' or *q == '+'))
+        eneg = *q++ == '-';
+      if (q < end and *q >= '0' and *q <= '9') {
+        int e = 0;
+        for (; q < end and *q >= '0' and *q <= '9'; q++)
+          if (e < 100000) e = e * 10 + (*q - '0');
+        exp10 += eneg ? -e : e;
+        p = q;
+      }
+    }
+
+    if (any and exact and digits <= 15 and exp10 >= -22 and exp10 <= 22) {
+      const double m = double(mant);
+      res = exp10 < 0 ? m / pow10[-exp10] : m * pow10[exp10];
+      if (neg) res = -res;
+      return p - s;
+    }
+
+    // Long or inexact numbers
+    return parse_real_strtod(s, any ? p - s : most, res);
+  }
 }
 
 
 // Function family file_text*
-// Uses enigma::files[] for storage, treats sdata as last read string.
+// Text files opened for reading are parsed in place from enigma::files[].text.
 
 #include "estring.h"
 int file_text_open_read(string fname) // Opens the file with the indicated name for reading. The function returns the id of the file that must be used in the other functions. You can open multiple files at the same time (32 max). Don't forget to close them once you are finished with them.
@@ -58,7 +187,8 @@ int file_text_open_read(string fname) // Opens the file with the indicated name
   FILE *a = fopen(fname.c_str(),"rt"); //Read as text file
   if (!a)      //Failure
     return -1; //Behavior for fail is -1 return
-  enigma::files[enigma::file_highid] = enigma::openFile(a,""); //Store it in the lowest available ID, highid
+  enigma::files[enigma::file_highid] = enigma::openFile(a,fname); //Store it in the lowest available ID, highid
+  enigma::load_text(enigma::files[enigma::file_highid]);
   file_text_readln(enigma::file_highid);
   return enigma::file_highid++; //Return our index and increment it for next time
 }
@@ -67,6 +197,7 @@ int file_text_open_write(string fname) // Opens the indicated file for writing,
   FILE *a = fopen(fname.c_str(),"wt"); //Write as text file
   if (!a)      //Failure
     return -1; //Behavior for fail is -1 return
+  setvbuf(a, NULL, _IOFBF, enigma::file_buffer_size);
   enigma::files[enigma::file_highid] = enigma::openFile(a,fname); //Store it in the lowest available ID, highid
   return enigma::file_highid++; //Return our index and increment it for next time
 }
@@ -75,18 +206,13 @@ int file_text_open_append(string fname) // Opens the indicated file for appendin
   FILE *a = fopen(fname.c_str(),"at"); //Append as text file
   if (!a)      //Failure
     return -1; //Behavior for fail is -1 return
+  setvbuf(a, NULL, _IOFBF, enigma::file_buffer_size);
   enigma::files[enigma::file_highid] = enigma::openFile(a,fname); //Store it in the lowest available ID, highid
   return enigma::file_highid++; //Return our index and increment it for next time
 }
 void file_text_close(int fileid) // Closes the file with the given file id.
 {
-  fclose(enigma::files[fileid].f);
-  enigma::files[fileid].f = NULL;
-
-  //Determine new high id: Lowest possible
-  for (int i = enigma::file_highid; i >= 0; i--)
-    if (enigma::files[i].f == NULL)
-      enigma::file_highid = i;
+  enigma::close_file(fileid);
 }
 void file_text_write_string(int fileid,string str) { // Writes the string to the file with the given file id.
   fwrite(str.c_str(),1,str.length(),enigma::files[fileid].f);
@@ -103,53 +229,45 @@ void file_text_writeln(int fileid) // Write a newline character to the file.
 }
 string file_text_read_string(int fileid) { // Reads a string from the file with the given file id and returns this string. A string ends at the end of line.
   enigma::openFile &mf = enigma::files[fileid];
-  if (!mf.sdata[mf.spos]) return "";
-  string strr = mf.sdata.substr(mf.spos);
-  mf.spos = mf.sdata.length();
-  if (feof(mf.f))
+  if (mf.spos >= mf.send) return "";
+  string strr(mf.text + mf.spos, mf.send - mf.spos);
+  mf.spos = mf.send;
+  if (mf.at_end)
     mf.eof = true;
   return strr;
 }
 bool file_text_eoln(int fileid)
 {
     enigma::openFile &mf = enigma::files[fileid];
-    return (mf.spos >= (int)mf.sdata.length());
+    return (mf.spos >= mf.send);
 }
 
 inline bool is_whitespace(char x) { return x == ' ' or x == '\t' or x == '\r' or x == '\n'; }
 
 double file_text_read_real(int fileid) { // Reads a real value from the file and returns this value.
   enigma::openFile &mf = enigma::files[fileid];
-  double r1;
-  int apos;
-  if (!mf.sdata[mf.spos]) return -1;
-  while (is_whitespace(mf.sdata[mf.spos]))
+  double r1 = 0;
+  if (mf.spos >= mf.send) return -1;
+  while (mf.spos < mf.send and is_whitespace(mf.text[mf.spos]))
     mf.spos++;
-  if (sscanf(mf.sdata.substr(mf.spos).c_str(),"%lf%n",&r1,&apos),apos)
-    mf.spos += apos;
-  if (mf.spos >= (int)mf.sdata.length() && feof(mf.f))
+  mf.spos += enigma::parse_real(mf.text + mf.spos, mf.text + mf.send, r1);
+  if (mf.spos >= mf.send && mf.at_end)
     mf.eof = true;
   return r1;
 }
 void file_text_readln(int fileid) // Skips the rest of the line in the file and starts at the start of the next line.
 {
-  if (feof(enigma::files[fileid].f))
-    enigma::files[fileid].eof = true;
-  string ret;
-  char buf[BUFSIZ];
-    buf[0] = 0;
-  while (fgets(buf,BUFSIZ,enigma::files[fileid].f))
-  {
-    ret += buf;
-    if (ret[ret.length()-1] == '\n' or ret[ret.length()-1] == '\r')
-      break;
-    buf[0] = 0;
-  }
-  size_t dp;
-  for (dp = ret.length()-1; dp != size_t(-1) and (ret[dp] == '\n' or ret[dp] == '\r'); dp--);
-  ret.erase(dp+1);
-  enigma::files[fileid].sdata = ret;
-  enigma::files[fileid].spos = 0;
+  enigma::openFile &mf = enigma::files[fileid];
+  if (mf.at_end)
+    mf.eof = true;
+  const char *nl = mf.tnext < mf.tlen ? (const char*)memchr(mf.text + mf.tnext, '\n', mf.tlen - mf.tnext) : NULL;
+  mf.spos = mf.tnext;
+  if (nl)
+    mf.send = nl - mf.text, mf.tnext = mf.send + 1;
+  else
+    mf.send = mf.tnext = mf.tlen, mf.at_end = true;
+  while (mf.send > mf.spos and (mf.text[mf.send - 1] == '\r' or mf.text[mf.send - 1] == '\n'))
+    mf.send--;
 }
 bool file_text_eof(int fileid) { // Returns whether we reached the end of the file.
   return (enigma::files[fileid].eof);
@@ -168,6 +286,7 @@ int file_bin_open(string fname,int mode) // Opens the file with the indicated na
   if (!a)      //Failure
     return -1; //Behavior for fail is -1 return
 
+  setvbuf(a, NULL, _IOFBF, enigma::file_buffer_size);
   enigma::files[enigma::file_highid] = enigma::openFile(a,fname); //Store it in the lowest available ID, highid
   return enigma::file_highid++; //Return our index and increment it for next time
 }
@@ -186,13 +305,7 @@ bool file_bin_rewrite(int fileid) // Rewrites the file with the given file id, t
 }
 void file_bin_close(int fileid) // Closes the file with the given file id.
 {
-  fclose(enigma::files[fileid].f);
-  enigma::files[fileid].f = NULL;
-
-  //Determine new high id: Lowest possible
-  for (int i = enigma::file_highid; i >= 0; i--)
-    if (enigma::files[i].f == NULL)
-      enigma::file_highid = i;
+  enigma::close_file(fileid);
 }
 size_t file_bin_size(int fileid) // Returns the size (in bytes) of the file with the given file id.
 {
@@ -214,3 +327,17 @@ void file_bin_write_byte(int fileid,unsigned char byte) { // Writes a byte of da
 int file_bin_read_byte(int fileid) { // Reads a byte of data from the file and returns this.
   return fgetc(enigma::files[fileid].f);
 }
+size_t file_bin_read_buffer(int fileid, void *buffer, size_t size) { // Reads up to size bytes into buffer and returns how many were read.
+  return fread(buffer, 1, size, enigma::files[fileid].f);
+}
+size_t file_bin_write_buffer(int fileid, const void *buffer, size_t size) { // Writes size bytes from buffer and returns how many were written.
+  return fwrite(buffer, 1, size, enigma::files[fileid].f);
+}
+string file_bin_read_buffer(int fileid, size_t size) { // Reads up to size bytes and returns them as a string, which is shorter at the end of the file.
+  string ret(size, 0);
+  ret.resize(size ? fread(&ret[0], 1, size, enigma::files[fileid].f) : 0);
+  return ret;
+}
+size_t file_bin_write_buffer(int fileid, string data) { // Writes every byte of the string and returns how many were written.
+  return fwrite(data.data(), 1, data.length(), enigma::files[fileid].f);
+}
@@ -48,3 +48,7 @@ size_t  file_bin_position(int fileid);
 void    file_bin_seek(int fileid,size_t pos);
 void    file_bin_write_byte(int fileid,unsigned char byte);
 int     file_bin_read_byte(int fileid);
+size_t  file_bin_read_buffer(int fileid, void *buffer, size_t size);
+size_t  file_bin_write_buffer(int fileid, const void *buffer, size_t size);
+string  file_bin_read_buffer(int fileid, size_t size);
+size_t  file_bin_write_buffer(int fileid, string data);
@@ -47,7 +47,7 @@ namespace enigma
       return;
     }
 
-	  fontstructarray = (new font*[rawfontmaxid + 2]) + 1;
+	  fontstructarray.init();
 
 	  for (int rf = 0; rf < rawfontcount; rf++)
 	  {
@@ -57,6 +57,7 @@ namespace enigma
 		  if (!fread(&thgt,4,1,exe)) return;
 		  const int i = fntid;
 
+		  fontstructarray.place(i);
 		  fontstructarray[i] = new font;
 
 		  fontstructarray[i]->name = rawfontdata[rf].name;
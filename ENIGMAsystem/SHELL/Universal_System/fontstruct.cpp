@@ -31,8 +31,8 @@ using namespace std;
 
 namespace enigma
 {
-  font **fontstructarray = NULL;
   extern size_t font_idmax;
+  resource_registry<font> fontstructarray(font_idmax, -1);
 
   int font_new(unsigned char gs, unsigned char gc) // Creates a new font, allocating 'gc' glyphs
   {
@@ -42,16 +42,9 @@ namespace enigma
     ret->glyphs = new fontglyph[gc];
     ret->height = 0;
 
-    font **fsan = new font*[font_idmax+2];
-    font ** const fold = fontstructarray - 1;
-    if (fontstructarray and fold) {
-      for (unsigned i = 0; i <= font_idmax; i++)
-        fsan[i] = fold[i];
-      delete fold;
-    }
-    fontstructarray = fsan + 1;
-    fontstructarray[font_idmax] = ret;
-    return font_idmax++;
+    const int id = fontstructarray.claim();
+    fontstructarray[id] = ret;
+    return id;
   }
 
   int font_pack(enigma::font *font , int spr, unsigned char gcount, bool prop, int sep)
@@ -187,7 +180,7 @@ string font_get_fontname(int fnt)
 void font_delete(int fnt)
 {
     delete enigma::fontstructarray[fnt];
-    enigma::fontstructarray[fnt] = NULL;
+    enigma::fontstructarray.release(fnt);
 }
 
 bool font_exists(int fnt)
@@ -29,6 +29,8 @@
 #ifndef _FONTSTRUCT__H
 #define _FONTSTRUCT__H
 
+#include "resource_registry.h"
+
 namespace enigma
 {
   struct fontglyph
@@ -61,7 +63,8 @@ namespace enigma
     unsigned int glyphstart, glyphcount;
   };
   extern rawfont rawfontdata[];
-  extern font **fontstructarray;
+  extern size_t font_idmax;
+  extern resource_registry<font> fontstructarray; // Ids begin at -1
 
   extern int rawfontcount, rawfontmaxid;
   int font_new(unsigned char gs, unsigned char gc); // Creates a new font, allocating 'gc' glyphs
@@ -41,13 +41,12 @@ namespace enigma
   int destroycalls = 0, createcalls = 0;
 }
 
-typedef std::pair<int,enigma::inst_iter*> inode_pair;
 void instance_deactivate_all(bool notme) {
     for (enigma::iterator it = enigma::instance_list_first(); it; ++it) {
         if (notme && (*it)->id == enigma::instance_event_iterator->inst->id) continue;
 
         ((enigma::object_basic*)*it)->deactivate();
-        enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+        enigma::instance_deactivated_add(it.it);
     }
 }
 
@@ -57,14 +56,14 @@ void instance_activate_all() {
     std::map<int,enigma::inst_iter*>::iterator iter = enigma::instance_deactivated_list.begin();
     while (iter != enigma::instance_deactivated_list.end()) {
         ((enigma::object_basic*)(iter->second->inst))->activate();
-        enigma::instance_deactivated_list.erase(iter++);
+        enigma::instance_deactivated_remove(iter++);
     }
 }
 
 void instance_deactivate_object(int obj) {
     for (enigma::iterator it = enigma::fetch_inst_iter_by_int(obj); it; ++it) {
         ((enigma::object_basic*)*it)->deactivate();
-        enigma::instance_deactivated_list.insert(inode_pair((*it)->id,it.it));
+        enigma::instance_deactivated_add(it.it);
     }
 }
 
@@ -74,7 +73,7 @@ void instance_activate_object(int obj) {
         enigma::object_basic* const inst = ((enigma::object_basic*)(iter->second->inst));
         if (obj==all ||(obj<100000 && inst->object_index==obj)|| (obj>100000 && inst->id == obj)) {
             inst->activate();
-            enigma::instance_deactivated_list.erase(iter++);
+            enigma::instance_deactivated_remove(iter++);
         }
         else {
             iter++;
@@ -131,11 +130,17 @@ int instance_number(int obj)
 
 //TODO: Move these to an instance_planar
 #include "planar_object.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <vector>
 
 //TODO: replace all these fucking enigma::instance_iterators with enigma::institer_t i or something
 
 int instance_nearest(int x,int y,int obj,bool notme)
 {
+  if (enigma::spatial_index *index = enigma::spatial_index_for(obj))
+    return index->nearest(x, y, notme ? int(enigma::instance_event_iterator->inst->id) : noone);
+
   double dist_lowest=-1;
   int retid=-4;
   double xl,yl;
@@ -158,6 +163,9 @@ int instance_nearest(int x,int y,int obj,bool notme)
 
 int instance_furthest(int x,int y,int obj,bool notme)
 {
+  if (enigma::spatial_index *index = enigma::spatial_index_for(obj))
+    return index->furthest(x, y, notme ? int(enigma::instance_event_iterator->inst->id) : noone);
+
   double dist_highest = -1;
   int retid = noone;
   double xl,yl;
@@ -178,3 +186,45 @@ int instance_furthest(int x,int y,int obj,bool notme)
 
   return retid;
 }
+
+int instance_count_in_rectangle(double x1,double y1,double x2,double y2,int obj,bool notme)
+{
+  const int skip = notme ? int(enigma::instance_event_iterator->inst->id) : noone;
+  if (enigma::spatial_index *index = enigma::spatial_index_for(obj))
+    return index->count_in_rectangle(x1, y1, x2, y2, skip);
+
+  if (x1 > x2) std::swap(x1, x2);
+  if (y1 > y2) std::swap(y1, y2);
+  int count = 0;
+  for (enigma::iterator it = enigma::fetch_inst_iter_by_int(obj); it; ++it)
+  {
+    const enigma::object_planar* const inst = (enigma::object_planar*)*it;
+    count += inst->x >= x1 and inst->x <= x2 and inst->y >= y1 and inst->y <= y2 and int(inst->id) != skip;
+  }
+  return count;
+}
+
+namespace {
+  std::vector<int> instance_list_found; // Result of the last instance_list_in_circle
+}
+
+int instance_list_in_circle(double x,double y,double r,int obj,bool notme)
+{
+  const int skip = notme ? int(enigma::instance_event_iterator->inst->id) : noone;
+  instance_list_found.clear();
+  if (enigma::spatial_index *index = enigma::spatial_index_for(obj))
+    index->list_in_circle(x, y, r, skip, instance_list_found);
+  else
+    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(obj); it; ++it)
+    {
+      const enigma::object_planar* const inst = (enigma::object_planar*)*it;
+      if (hypot(inst->x - x, inst->y - y) <= r and int(inst->id) != skip)
+        instance_list_found.push_back(inst->id);
+    }
+  return instance_list_found.size();
+}
+
+int instance_list_get(int n)
+{
+  return n >= 0 and size_t(n) < instance_list_found.size() ? instance_list_found[n] : noone;
+}
@@ -51,6 +51,11 @@ enigma::instance_t instance_find   (int obj,int n);
 int instance_number (int obj);
 enigma::instance_t instance_nearest (int x,int y,int obj,bool notme = false);
 enigma::instance_t instance_furthest(int x,int y,int obj,bool notme = false);
+// Count instances whose position is in the rectangle, or list those within r of x,y.
+// The listed ids, in the order instance_find gives them, are read back with instance_list_get.
+int instance_count_in_rectangle(double x1,double y1,double x2,double y2,int obj,bool notme = false);
+int instance_list_in_circle(double x,double y,double r,int obj,bool notme = false);
+enigma::instance_t instance_list_get(int n);
 
 
 //int instance_place(x,y,obj)
@@ -31,6 +31,7 @@
 #include <math.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include "var4.h"
 #include "reflexive_types.h"
 #include <stdio.h>
@@ -47,7 +48,7 @@ extern  deque<int> instance_id;
 namespace enigma
 {
   inst_iter::inst_iter(object_basic* i,inst_iter *n = NULL,inst_iter *p = NULL): inst(i), next(n), prev(p) {}
-  objectid_base::objectid_base(): inst_iter(NULL,NULL,this), count(0) {}
+  objectid_base::objectid_base(): inst_iter(NULL,NULL,this), count(0), changes(0) {}
   event_iter::event_iter(string n): inst_iter(NULL,NULL,this), name(n) {}
   event_iter::event_iter(): inst_iter(NULL,NULL,this) {}
 
@@ -132,6 +133,7 @@ namespace enigma
     objectid_base *a = objects + oid;
     if (a->prev == which) a->prev = which->prev;
     a->count--;
+    a->changes++;
     update_iterators_for_destroy(which);
   }
 
@@ -145,6 +147,7 @@ namespace enigma
   // This is the all-inclusive, centralized list of instances.
   map<int,inst_iter*> instance_list;
   map<int,inst_iter*> instance_deactivated_list;
+  unsigned long instance_list_changes = 0;
   typedef map<int,inst_iter*>::iterator iliter;
   typedef pair<int,inst_iter*> inode_pair;
     
@@ -251,6 +254,7 @@ namespace enigma
   {
     inst_iter *ins = new inst_iter(who);
     instance_id.push_back(who->id);
+    instance_list_changes++;
     pair<iliter,bool> it = instance_list.insert(inode_pair(who->id,ins));
     if (!it.second) {
       delete ins;
@@ -274,6 +278,7 @@ namespace enigma
   inst_iter *link_obj_instance(object_basic* who, int oid)
   {
     objects[oid].count++;
+    objects[oid].changes++;
     return objects[oid].add_inst(who);
   }
 
@@ -295,6 +300,7 @@ namespace enigma
     if (a->prev) a->prev->next = a->next;
     if (a->next) a->next->prev = a->prev;
     instance_list.erase(who);
+    instance_list_changes++;
     update_iterators_for_destroy(a);
   }
   void unlink_main(pinstance_list_iterator whop)
@@ -303,6 +309,132 @@ namespace enigma
     if (a->prev) a->prev->next = a->next;
     if (a->next) a->next->prev = a->prev;
     instance_list.erase(whop->w);
+    instance_list_changes++;
     update_iterators_for_destroy(a);
   }
+
+  /* **  Deactivated instance buckets ** */
+  // Bucket entries are not removed one by one when an instance is reactivated; the stamp kept for each
+  // deactivated id tells current entries from stale ones, which are dropped when next visited. Once
+  // reactivations outnumber the instances still deactivated, everything is swept, so nothing piles up.
+  namespace {
+    struct bucket_entry {
+      int id;
+      unsigned long stamp;
+      bucket_entry(int i, unsigned long s): id(i), stamp(s) {}
+    };
+    const int bucket_size = 256, bucket_span_max = 16; // Boxes over more buckets than this a side are kept aside
+    map<long long, vector<bucket_entry> > deactivated_buckets;
+    vector<bucket_entry> deactivated_wide, deactivated_unplaced;
+    map<int, unsigned long> deactivated_stamps;
+    unsigned long deactivated_stamp = 0;
+    size_t deactivated_stale = 0; // Instances reactivated since the last sweep
+
+    inline int bucket_of(int v) { return v >= 0 ? v / bucket_size : -1 - (-1 - v) / bucket_size; }
+    inline long long bucket_key(int bx, int by) { return (long long)((unsigned long long)(unsigned)bx << 32 | (unsigned)by); }
+    inline bool entry_current(const bucket_entry &e) {
+      map<int, unsigned long>::iterator it = deactivated_stamps.find(e.id);
+      return it != deactivated_stamps.end() and it->second == e.stamp;
+    }
+    void collect_current(vector<bucket_entry> &entries, vector<int> &ids)
+    {
+      size_t kept = 0;
+      for (size_t i = 0; i < entries.size(); i++)
+        if (entry_current(entries[i]))
+          ids.push_back(entries[i].id), entries[kept++] = entries[i];
+      entries.erase(entries.begin() + kept, entries.end());
+    }
+    void drop_stale(vector<bucket_entry> &entries)
+    {
+      size_t kept = 0;
+      for (size_t i = 0; i < entries.size(); i++)
+        if (entry_current(entries[i]))
+          entries[kept++] = entries[i];
+      entries.erase(entries.begin() + kept, entries.end());
+    }
+    void sweep_stale()
+    {
+      drop_stale(deactivated_wide);
+      drop_stale(deactivated_unplaced);
+      for (map<long long, vector<bucket_entry> >::iterator it = deactivated_buckets.begin(); it != deactivated_buckets.end(); )
+      {
+        drop_stale(it->second);
+        if (it->second.empty()) deactivated_buckets.erase(it++);
+        else it++;
+      }
+      deactivated_stale = 0;
+    }
+  }
+
+  void instance_deactivated_add(inst_iter* it)
+  {
+    if (!instance_deactivated_list.insert(inode_pair(it->inst->id, it)).second)
+      return;
+    deactivated_stamps[it->inst->id] = ++deactivated_stamp;
+    deactivated_unplaced.push_back(bucket_entry(it->inst->id, deactivated_stamp));
+  }
+
+  void instance_deactivated_remove(instance_list_iterator it)
+  {
+    deactivated_stamps.erase(it->first);
+    instance_deactivated_list.erase(it);
+    if (instance_deactivated_list.empty()) { // As after instance_activate_all; every entry is stale
+      deactivated_buckets.clear();
+      deactivated_wide.clear();
+      deactivated_unplaced.clear();
+      deactivated_stale = 0;
+    }
+    else if (++deactivated_stale > instance_deactivated_list.size() + 64)
+      sweep_stale();
+  }
+
+  void instance_deactivated_place(bool (*border)(object_basic* inst, int &left, int &top, int &right, int &bottom))
+  {
+    for (size_t i = 0; i < deactivated_unplaced.size(); i++)
+    {
+      const bucket_entry &e = deactivated_unplaced[i];
+      if (!entry_current(e)) continue;
+      int left, top, right, bottom;
+      if (!border(instance_deactivated_list[e.id]->inst, left, top, right, bottom)) continue;
+      const int bl = bucket_of(left), bt = bucket_of(top), br = bucket_of(right), bb = bucket_of(bottom);
+      if (br - bl >= bucket_span_max or bb - bt >= bucket_span_max) {
+        deactivated_wide.push_back(e);
+        continue;
+      }
+      for (int by = bt; by <= bb; by++)
+        for (int bx = bl; bx <= br; bx++)
+          deactivated_buckets[bucket_key(bx, by)].push_back(e);
+    }
+    deactivated_unplaced.clear();
+  }
+
+  void instance_deactivated_near(int left, int top, int right, int bottom, vector<int> &ids)
+  {
+    const size_t first = ids.size();
+    collect_current(deactivated_wide, ids);
+    const int bl = bucket_of(left), bt = bucket_of(top), br = bucket_of(right), bb = bucket_of(bottom);
+    if (double(br - bl + 1) * (bb - bt + 1) > deactivated_buckets.size())
+    { // The region covers more buckets than are in use; go through those in use instead.
+      for (map<long long, vector<bucket_entry> >::iterator it = deactivated_buckets.begin(); it != deactivated_buckets.end(); )
+      {
+        const int bx = int(unsigned((unsigned long long)it->first >> 32)), by = int(unsigned(it->first));
+        if (bx >= bl and bx <= br and by >= bt and by <= bb)
+          collect_current(it->second, ids);
+        if (it->second.empty()) deactivated_buckets.erase(it++);
+        else it++;
+      }
+    }
+    else
+      for (int by = bt; by <= bb; by++)
+        for (int bx = bl; bx <= br; bx++)
+        {
+          map<long long, vector<bucket_entry> >::iterator it = deactivated_buckets.find(bucket_key(bx, by));
+          if (it == deactivated_buckets.end()) continue;
+          collect_current(it->second, ids);
+          if (it->second.empty()) deactivated_buckets.erase(it);
+        }
+    // Boxes over several buckets turn up once for each.
+    std::sort(ids.begin() + first, ids.end());
+    ids.erase(std::unique(ids.begin() + first, ids.end()), ids.end());
+  }
 }
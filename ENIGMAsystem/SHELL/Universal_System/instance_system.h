@@ -42,14 +42,27 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 namespace enigma {
   typedef std::map<int,inst_iter*>::iterator instance_list_iterator;
   extern std::map<int,inst_iter*> instance_list;
   extern std::map<int,inst_iter*> instance_deactivated_list;
   extern std::set<object_basic*> cleanups;
+  extern unsigned long instance_list_changes; // Bumped each time an instance joins or leaves instance_list
   
   void unlink_main(instance_list_iterator who);
+
+  // Instances deactivated in any way are also filed in square buckets by their bounding
+  // box, so that region activation only looks at instances near the region.
+  // Use these rather than changing instance_deactivated_list directly.
+  void instance_deactivated_add(inst_iter* it);
+  void instance_deactivated_remove(instance_list_iterator it);
+  // Files each instance deactivated since the last call in the buckets its box overlaps.
+  // @param border gives the box, or returns false if the instance has none to file.
+  void instance_deactivated_place(bool (*border)(object_basic* inst, int &left, int &top, int &right, int &bottom));
+  // Appends the ids of filed instances that may overlap the rectangle to @param ids, in id order.
+  void instance_deactivated_near(int left, int top, int right, int bottom, std::vector<int> &ids);
 }
 
 #endif
@@ -74,6 +74,7 @@ namespace enigma
     // Inherits inst_iter *next:    First of instances for which to perform this event (Can be NULL)
     // Inherits inst_iter *prev:    The last instance for which to perform it. (Can be NULL)
     size_t count;     // Number of instances on this list
+    unsigned long changes; // Bumped each time an instance joins or leaves this list
     inst_iter *add_inst(object_basic* inst);  // Append an instance to the list
     objectid_base();
   };
@@ -28,7 +28,7 @@
 #ifndef _H_LUA_TABLE
 #define _H_LUA_TABLE
 
-#include <map>      // Sparse part
+#include <new>      // Placement new
 #include <string.h> // Memcpy
 #include <stdlib.h> // Malloc, Realloc, Free
 
@@ -38,23 +38,144 @@
 
 /**
   This file implements a Lua-table-like structure. It borrows ideas not only from 
-  Lua, but from STL containers. It also borrows the entirety of std::map. This should
-  be replaced with a sparse hash map container when it's a "good time" to do so.
+  Lua, but from STL containers. Indexes far past the end of the dense part are kept
+  in an open-addressing hash table (lua_sparse, below) instead.
   
   By ENIGMA-defined standard, this table class takes up sizeof(void*) bytes. The class
   itself contains a single pointer to a dense part (dynamic array). This ctually points
   to a fixed-length position from the beginning of an allocated block. At the beginning
-  of this block is precisely enough room for the table's map component. The implication
+  of this block is precisely enough room for the table's sparse component. The implication
   is that the dense segment can be dereferenced without additional arithmetic (by unary
-  operator*), while the map section requires taking dense[-sizeof(map)],  where `dense`
-  has been cast to char*, then casting back to maptype*.
+  operator*), while the sparse section requires taking dense[-sizeof(sparse)],  where `dense`
+  has been cast to char*, then casting back to lua_sparse*.
+  
+  Both parts move their elements with realloc and memcpy, so T must not point into itself.
+  variant and lua_table both qualify.
 */
 
+template <class T> struct lua_sparse
+{
+  enum { slot_empty, slot_used, slot_removed };
+  struct slot { size_t key; char state; T value; };
+  
+  slot*  slots;  // Power-of-two sized, or NULL until the first sparse index is used
+  size_t cap;    // Number of slots
+  size_t used;   // Slots holding a value
+  size_t filled; // Slots holding a value or a removal marker; probes stop only at empty slots
+  
+  static size_t hash(size_t key) {
+    key *= (size_t)2654435769UL;
+    return key ^ (key >> 15);
+  }
+  
+  void initialize() {
+    slots = NULL;
+    cap = used = filled = 0;
+  }
+  void destroy()
+  {
+    for (size_t i = 0; i < cap; i++)
+      if (slots[i].state == slot_used)
+        slots[i].value.~T();
+    free(slots);
+    initialize();
+  }
+  void copy_from(const lua_sparse<T> &x)
+  {
+    initialize();
+    if (!x.used)
+      return;
+    slots = (slot*)malloc(x.cap * sizeof(slot));
+    cap = x.cap, used = filled = x.used;
+    for (size_t i = 0; i < cap; i++)
+      slots[i].state = slot_empty;
+    for (size_t i = 0; i < x.cap; i++)
+      if (x.slots[i].state == slot_used)
+        new(&claim(x.slots[i].key)->value) T(x.slots[i].value);
+  }
+  
+  // Finds an empty slot for a key known not to be present, and marks it used.
+  // Only valid while no removal markers exist, as right after a rehash.
+  slot *claim(size_t key)
+  {
+    size_t i = hash(key) & (cap - 1);
+    while (slots[i].state != slot_empty)
+      i = (i + 1) & (cap - 1);
+    slots[i].key = key, slots[i].state = slot_used;
+    return slots + i;
+  }
+  
+  // Moves every value into a fresh array of the given size, dropping removal markers.
+  void rehash(size_t ncap)
+  {
+    slot *old = slots;
+    const size_t ocap = cap;
+    slots = (slot*)malloc(ncap * sizeof(slot));
+    cap = ncap, filled = used;
+    for (size_t i = 0; i < cap; i++)
+      slots[i].state = slot_empty;
+    for (size_t i = 0; i < ocap; i++)
+      if (old[i].state == slot_used)
+        memcpy((void*)&claim(old[i].key)->value, (void*)&old[i].value, sizeof(T));
+    free(old);
+  }
+  
+  T& operator[] (size_t key)
+  {
+    if (cap)
+    {
+      slot *reuse = NULL;
+      for (size_t i = hash(key) & (cap - 1); slots[i].state != slot_empty; i = (i + 1) & (cap - 1))
+        if (slots[i].state == slot_used) {
+          if (slots[i].key == key)
+            return slots[i].value;
+        }
+        else if (!reuse)
+          reuse = slots + i;
+      if (reuse) {
+        reuse->key = key, reuse->state = slot_used, used++;
+        return *new(&reuse->value) T();
+      }
+    }
+    
+    // Keep the table at most three quarters full, doubling when it gets there.
+    if ((filled + 1) * 4 > cap * 3)
+      rehash(cap ? (used + 1) * 4 > cap * 3 ? cap << 1 : cap : 8);
+    used++, filled++;
+    return *new(&claim(key)->value) T();
+  }
+  
+  // Moves every value whose key is below `limit` into dense[key].
+  void drain_into(T* dense, size_t limit)
+  {
+    for (size_t i = 0; used and i < cap; i++)
+      if (slots[i].state == slot_used and slots[i].key < limit) {
+        dense[slots[i].key] = slots[i].value;
+        slots[i].value.~T();
+        slots[i].state = slot_removed;
+        used--;
+      }
+  }
+  
+  // Releases the slack left by growth and removals; frees the table outright if empty.
+  void shrink_to_fit()
+  {
+    if (!used) {
+      destroy();
+      return;
+    }
+    size_t ncap = 8;
+    while (used * 4 > ncap * 3)
+      ncap <<= 1;
+    if (ncap < cap or filled > used)
+      rehash(ncap);
+  }
+};
+
 template <class T> struct lua_table
 {
   // This is what kind of sparse container we'll be using
-  typedef std::map<size_t,T> lua_map_type;
-  typedef typename lua_map_type::iterator shiterator;
+  typedef lua_sparse<T> lua_map_type;
 
   // These are size calculations for the buffer we'll keep
   #define base_size (sizeof(lua_map_type) + sizeof(size_t))
@@ -72,23 +193,13 @@ template <class T> struct lua_table
     // Create our chunk of memory.
     char* databuf = (char*)malloc(base_size + sizeof(T));
     
-    // Construct a map for sparse indexes.
-    new(databuf) lua_map_type;
+    // Start with no sparse indexes.
+    base_map(databuf).initialize();
     
     base_length(databuf) = 1;  // We'll only allocate one object for now.
     dense = base_to_TA(databuf); // This is where we'll look for it.
     new(dense) T[1]; // Construct it there.
   }
-  void move_from_map()
-  {
-    const size_t clen = TA_length(dense);
-    for (shiterator it = TA_map(dense).begin(); it != TA_map(dense).end(); it++)
-    {
-      if (it->first > clen) break;
-      dense[it->first] = it->second;
-      TA_map(dense).erase(it++);
-    }
-  }
   inline void destroy()
   {
     // Iterate the dense part, destroying everything.
@@ -96,8 +207,8 @@ template <class T> struct lua_table
     for (size_t i = 0; i < dlen; i++)
       dense[i].~T();
     
-    // Destroy the map.
-    TA_map(dense).~lua_map_type();
+    // Destroy the sparse part.
+    TA_map(dense).destroy();
     
     // Give back the memory.
     free(TA_start(dense));
@@ -111,8 +222,8 @@ template <class T> struct lua_table
     // Create a new chunk, base and all. We'll be moving here.
     char* databuf = (char*)malloc(base_size + len*sizeof(T));
     
-    // Call map copy constructor.
-    new(databuf) lua_map_type(TA_map(who.dense));
+    // Copy the sparse part.
+    base_map(databuf).copy_from(TA_map(who.dense));
     
     base_length(databuf) = len;   // We share a length in common, though.... 
     T* ndense = base_to_TA(databuf); // Re-establish our array's location.
@@ -125,30 +236,17 @@ template <class T> struct lua_table
   {
     const size_t dense_size = TA_length(dense);
     
-    // Preserve our map
-    lua_map_type tmp; // Create a temporary map
-    tmp.swap(TA_map(dense)); // Move our old map into it
-    TA_map(dense).~lua_map_type(); // Destroy our old map
-    
+    // The sparse part is plain data, so it can ride along with the realloc.
     char* databuf = TA_start(dense); // Get the beginning of the data chunk
     databuf = (char*)realloc(databuf,base_size + c*sizeof(T));   // Ask system to give us more memory and maybe move us
     
-    // Restore our map
-    new(databuf) lua_map_type(); // Recreate our map
-    lua_map_type& nmap = base_map(databuf); // Reference our new map
-    nmap.swap(tmp); // Move our old content into it
-    // I know this looks like tail-chasing, but map<> WILL segfault otherwise. I can't tell why.
-    
     // Finish our move
     dense = base_to_TA(databuf);   // Get back our array pointer
     new(dense + dense_size) T[c - dense_size]; // Construct new array elements
-    
-    for (shiterator i = nmap.begin(); i != nmap.end(); ) {
-      if (i->first >= c) break;
-      dense[i->first] = i->second;
-      nmap.erase(i++);
-    }
     TA_length(dense) = c;    // Store new alloc size for dense array
+    
+    // Anything stored sparsely that now fits in the dense part moves there.
+    TA_map(dense).drain_into(dense, c);
   }
   
   T& operator[] (size_t ind) 
@@ -172,6 +270,11 @@ template <class T> struct lua_table
     return *dense;
   }
   
+  // Compacts the sparse part after heavy use. The dense part is left alone.
+  void shrink_to_fit() {
+    TA_map(dense).shrink_to_fit();
+  }
+  
   lua_table<T>& operator= (const lua_table<T>& x)
   {
     pick_up(x);
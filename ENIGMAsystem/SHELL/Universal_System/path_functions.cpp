@@ -40,90 +40,6 @@ namespace enigma {
 	extern unsigned bound_texture;
 }
 
-#include "collisions_object.h"
-#include "instance_system.h"
-#include "Extensions/Paths/implement.h"
-void path_start(unsigned pathid,double speed,unsigned endaction,bool absolute)
-{
-    #ifndef PATH_EXT_SET
-        return;
-    #endif
-
-    return;  //function can cause crashes atm, until extension variables fixed
-
-    enigma::object_collisions* const inst = ((enigma::object_collisions*)enigma::instance_event_iterator->inst);
-    enigma::extension_path* const inst_paths = ((enigma::extension_path*)enigma::instance_event_iterator->inst);
-    inst_paths->path_index = pathid;
-    inst_paths->path_speed = speed;
-    inst_paths->path_endaction = endaction;
-
-    if (absolute)
-    {
-        const double x1 = path_get_x(inst_paths->path_index, inst_paths->path_position), y1 = path_get_y(inst_paths->path_index, inst_paths->path_position);
-        inst->x = x1;
-        inst->y = y1;
-    }
-}
-
-void path_end()
-{
-    #ifndef PATH_EXT_SET
-        return;
-    #endif
-
-    return;  //function can cause crashes atm, until extension variables fixed
-
-    enigma::extension_path* const inst_paths = ((enigma::extension_path*)enigma::instance_event_iterator->inst);
-    inst_paths->path_index = -1;
-}
-
-void path_set_position(double position, bool relative)
-{
-    #ifndef PATH_EXT_SET
-        return;
-    #endif
-
-    return;  //function can cause crashes atm, until extension variables fixed
-
-    enigma::object_collisions* const inst = ((enigma::object_collisions*)enigma::instance_event_iterator->inst);
-    enigma::extension_path* const inst_paths = ((enigma::extension_path*)enigma::instance_event_iterator->inst);
-    inst_paths->path_position = position;
-    if (relative)
-    {
-        inst->x = path_get_x(inst_paths->path_index , inst_paths->path_position);
-        inst->x = path_get_y(inst_paths->path_index , inst_paths->path_position);
-    }
-}
-
-void path_set_speed(double speed, bool relative)
-{
-    #ifndef PATH_EXT_SET
-        return;
-    #endif
-
-    return;  //function can cause crashes atm, until extension variables fixed
-
-    enigma::object_collisions* const inst = ((enigma::object_collisions*)enigma::instance_event_iterator->inst);
-    enigma::extension_path* const inst_paths = ((enigma::extension_path*)enigma::instance_event_iterator->inst);
-    inst_paths->path_speed = relative ? speed : double(inst->speed + speed);
-}
-
-bool path_update()
-{
-    #ifndef PATH_EXT_SET
-        return false;
-    #endif
-    return false;  //function can cause crashes atm, until extension variables fixed
-
-    enigma::object_collisions* const inst = ((enigma::object_collisions*)enigma::instance_event_iterator->inst);
-    enigma::extension_path* const inst_paths = ((enigma::extension_path*)enigma::instance_event_iterator->inst);
-
-    if (inst_paths->path_index == -1 || inst_paths->path_speed == 0)
-        return false;
-
-    return true;
-}
-
 bool path_exists(unsigned pathid)
 {
     return (pathid < enigma::path_idmax && enigma::pathstructarray[pathid]);
@@ -138,20 +54,22 @@ void path_delete(unsigned pathid)
     }
     #endif
     delete enigma::pathstructarray[pathid];
+    enigma::pathstructarray.release(pathid);
 }
 
 int path_add()
 {
-    enigma::pathstructarray_reallocate();
-    new enigma::path(enigma::path_idmax, false, false, 8, 0);
-    return enigma::path_idmax-1;
+    const int id = enigma::pathstructarray.claim();
+    new enigma::path(id, false, false, 8, 0);
+    return id;
 }
 
 int path_duplicate(unsigned pathid)
 {
-    enigma::pathstructarray_reallocate();
-    enigma::pathstructarray[enigma::path_idmax] = new enigma::path(*enigma::pathstructarray[pathid]);
-    return enigma::path_idmax++;
+    const int id = enigma::pathstructarray.claim();
+    enigma::path *pth = enigma::pathstructarray[id] = new enigma::path(*enigma::pathstructarray[pathid]);
+    pth->id = id;
+    return id;
 }
 
 void path_copy(unsigned pathid,unsigned srcid)
@@ -168,8 +86,10 @@ void path_copy(unsigned pathid,unsigned srcid)
 
 void path_assign(unsigned pathid,unsigned path)
 {
+    if (pathid == path) return;
     delete enigma::pathstructarray[pathid];
-    enigma::pathstructarray[pathid] = new enigma::path(*enigma::pathstructarray[path]);
+    enigma::path *pth = enigma::pathstructarray[pathid] = new enigma::path(*enigma::pathstructarray[path]);
+    pth->id = pathid;
 }
 
 void path_append(unsigned pathid,unsigned path)
@@ -188,6 +108,7 @@ void path_shift(unsigned pathid,double xshift,double yshift)
     enigma::path *pa = enigma::pathstructarray[pathid];
     for (vector<enigma::path_point>::iterator it = pa->pointarray.begin(); it!=pa->pointarray.end(); ++it)
         (*it).x = (*it).x + xshift, (*it).y = (*it).y + yshift;
+    enigma::path_recalculate(pathid);
 }
 
 void path_flip(unsigned pathid)
@@ -196,6 +117,7 @@ void path_flip(unsigned pathid)
     for (size_t i=0; i<pa->pointarray.size(); i++){
         pa->pointarray[i].y = pa->centery*2-pa->pointarray[i].y;
     }
+    enigma::path_recalculate(pathid);
 }
 
 void path_mirror(unsigned pathid)
@@ -204,6 +126,7 @@ void path_mirror(unsigned pathid)
     for (size_t i=0; i<pa->pointarray.size(); i++){
         pa->pointarray[i].x = pa->centerx*2-pa->pointarray[i].x;
     }
+    enigma::path_recalculate(pathid);
 }
 
 void path_scale(unsigned pathid,double xscale,double yscale)
@@ -226,6 +149,7 @@ void path_rotate(unsigned pathid,double angle)
         pa->pointarray[i].x = tmpx*cos(a) - tmpy*sin(a) + pa->centerx;
         pa->pointarray[i].y = tmpx*sin(a) + tmpy*cos(a) + pa->centery;
     }
+    enigma::path_recalculate(pathid);
 }
 
 double path_get_x(unsigned pathid, double t)
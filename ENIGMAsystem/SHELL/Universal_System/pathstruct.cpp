@@ -40,8 +40,8 @@
 
 
 namespace enigma {
-	path** pathstructarray;
 	extern size_t path_idmax;
+	resource_registry<path> pathstructarray(path_idmax);
 }
 
 
@@ -93,13 +93,74 @@ namespace enigma
       return length;
     };
 
+    // The quadratic spline through the midpoints on either side of p2; blen measures the same curve.
+    static inline double qspline(double v1, double v2, double v3, double t) {
+      return 0.5 * (((v1 - 2 * v2 + v3) * t + 2 * v2 - 2 * v1) * t + v1 + v2);
+    }
+
+    // Straight paths keep their exact segments; the buckets only spare searching for one.
+    static void bake_straight(path *pth)
+    {
+        const size_t pc = pth->pointarray.size(), buckets = pc * 2;
+        pth->segment_bucket.resize(buckets);
+        size_t seg = 0;
+        for (size_t b = 0; b < buckets; b++)
+        {
+            const double pos = double(b) / buckets;
+            while (seg + 1 < pc and pth->segment_start[seg + 1] <= pos)
+                seg++;
+            pth->segment_bucket[b] = seg;
+        }
+    }
+
+    // Smooth paths are traced finely, then resampled at equal arc-length steps of at most a pixel.
+    static void bake_smooth(path *pth)
+    {
+        const size_t pc = pth->pointarray.size();
+        const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
+        const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
+
+        vector<path_sample> trace;
+        vector<double> dist;
+        for (size_t i = 0; i < pc; i++)
+        {
+            const path_point &p1 = i==0 ? start : pth->pointarray[i-1], &p2 = pth->pointarray[i], &p3 = i+1==pc ? end : pth->pointarray[i+1];
+            const double len = pth->pointarray[i].length;
+            const int steps = len < 16 ? 8 : len > 1024 ? 512 : int(len / 2);
+            for (int k = i ? 1 : 0; k <= steps; k++)
+            {
+                const double t = double(k) / steps;
+                const path_sample smp = { qspline(p1.x, p2.x, p3.x, t), qspline(p1.y, p2.y, p3.y, t), qspline(p1.speed, p2.speed, p3.speed, t) };
+                dist.push_back(trace.empty() ? 0 : dist.back() + hypot(smp.x - trace.back().x, smp.y - trace.back().y));
+                trace.push_back(smp);
+            }
+        }
+
+        const double traced = dist.back();
+        size_t n = size_t(ceil(traced));
+        n = n < 16 ? 16 : n > 65536 ? 65536 : n;
+        pth->samples.resize(n + 1);
+        for (size_t k = 0, j = 0; k <= n; k++)
+        {
+            const double d = traced * k / n;
+            while (j + 2 < trace.size() and dist[j + 1] < d)
+                j++;
+            const double span = dist[j + 1] - dist[j];
+            double u = span > 0 ? (d - dist[j]) / span : 0;
+            u = u < 0 ? 0 : u > 1 ? 1 : u;
+            path_sample &smp = pth->samples[k];
+            smp.x = trace[j].x + (trace[j+1].x - trace[j].x) * u;
+            smp.y = trace[j].y + (trace[j+1].y - trace[j].y) * u;
+            smp.speed = trace[j].speed + (trace[j+1].speed - trace[j].speed) * u;
+        }
+    }
+
     path::path(unsigned pathid, bool smth, bool close, int prec, unsigned pointcount):
         id(pathid), precision(prec), smooth(smth), closed(close), pointarray(), total_length(0)
     {
+        pathstructarray.place(pathid);
         pathstructarray[pathid] = this;
-        pathstructarray[pathid]->pointarray.reserve(pointcount);
-        if (enigma::path_idmax < pathid+1)
-          enigma::path_idmax = pathid+1;
+        pointarray.reserve(pointcount);
     }
     path::~path() { pathstructarray[id] = NULL; }
 
@@ -113,7 +174,8 @@ namespace enigma
     {
         path* const pth = pathstructarray[pathid];
         if (!pth) return;
-        pth->total_length = 0; pth->pointoffset.clear();
+        pth->total_length = 0;
+        pth->segment_start.clear(); pth->segment_bucket.clear(); pth->samples.clear();
         if (!pth->pointarray.size()) return;
 
         const size_t pc = pth->pointarray.size();
@@ -145,108 +207,116 @@ namespace enigma
         pth->centery = miny + (maxy-miny)/2;
 
         double position = 0;
+        pth->segment_start.resize(pc);
         for (size_t i = 0; i < pc; i++)
         {
-          //if (pth->pointarray[i].length) {
-            pth->pointoffset[position/pth->total_length] = i;
+            pth->segment_start[i] = pth->total_length ? position/pth->total_length : 0;
             position += pth->pointarray[i].length;
-            //std::cout << "Position: " << position << " i: " << i << " length: " << pth->pointarray[i].length << std::endl;
-          //}
         }
-        //std::cout << "size of pointoffset: " << pth->pointoffset.size() << std::endl;
-        //for (ppi_t i = pth->pointoffset.begin(); i != pth->pointoffset.end(); i++) std::cout << i->first << "=>" << i->second << std::endl;
+
+        if (pth->smooth and (pc > 2 or pth->closed))
+            bake_smooth(pth);
+        else
+            bake_straight(pth);
     }
 
-    void pathstructarray_reallocate()
-    {
-        enigma::path** pathold = pathstructarray;
-        pathstructarray = new path*[enigma::path_idmax+2];
-        for (size_t i = 0; i < enigma::path_idmax; i++) pathstructarray[i] = pathold[i]; delete[] pathold;
+    /// Maps @param position onto [0,1]; positions past either end wrap around.
+    static inline double path_wrap(double position) {
+      if (position >= 0 and position <= 1)
+        return position;
+      return position < 0 ? 1 - fmod(-position, 1) : fmod(position, 1);
     }
 
-    /// Returns an iterator to the point in @param path whose segment covers @param position.
-    inline ppi_t path_point_iterator_at(path* pth, double position) {
-      return --pth->pointoffset.upper_bound(position);
+    /// Returns the straight segment covering @param position, setting @param t to how far along it that is.
+    static inline size_t path_segment_at(const path *pth, double position, double &t)
+    {
+      const size_t pc = pth->pointarray.size(), buckets = pth->segment_bucket.size();
+      size_t seg = pth->segment_bucket[position >= 1 ? buckets - 1 : size_t(position * buckets)];
+      while (seg + 1 < pc and pth->segment_start[seg + 1] <= position)
+        seg++;
+      const double seglen = pth->pointarray[seg].length / pth->total_length;
+      t = seglen > 0 ? (position - pth->segment_start[seg]) / seglen : 0;
+      return seg;
     }
-    inline int path_point_index_at(path* pth, double position) {
-      return path_point_iterator_at(pth, position)->second;
+
+    /// Returns the baked sample before @param position, setting @param u to how far toward the next one it is.
+    static inline const path_sample *path_sample_at(const path *pth, double position, double &u)
+    {
+      const size_t n = pth->samples.size() - 1;
+      const double f = position * n;
+      const size_t k = f >= n ? n - 1 : size_t(f);
+      u = f - k;
+      return &pth->samples[k];
     }
 
     void path_getXY(path *pth, double &x, double &y, double position)
     {
       if (!pth) return;
-      if (!pth->pointarray.size()) return;
-      if (position < 0)
-        position = 1 - fmod(-position, 1);
-      else
-        position = fmod(position, 1);
-      ppi_t ppi = path_point_iterator_at(pth, position);
-      double t = position - ppi->first;
-      t /= double(pth->pointarray[ppi->second].length) / pth->total_length;
-      int sid = ppi->second;
-      double x1, x2, x3, y1, y2, y3;
-      //std::cout << "t on path: " << position << " first: " << ppi->first << " second: " << ppi->second << " Sid: " << sid << " delta:" << t << std::endl;
       const size_t pc = pth->pointarray.size();
+      if (!pc) return;
+      position = path_wrap(position);
+
+      if (!pth->samples.empty()) {
+        double u;
+        const path_sample *s = path_sample_at(pth, position, u);
+        x = s[0].x + (s[1].x - s[0].x) * u;
+        y = s[0].y + (s[1].y - s[0].y) * u;
+        return;
+      }
+
       const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
-      const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
-      if (sid==0)
-          x1=start.x, y1=start.y;
-      else
-          x1=pth->pointarray[sid-1].x, y1=pth->pointarray[sid-1].y;
-
-      x2=pth->pointarray[sid].x, y2=pth->pointarray[sid].y;
-
-        //std::cout<<pth->pointarray.size()<<std::endl;
-      if (pth->pointarray.size()==1){x=x1; y=y1; return;}
-      else if (pth->pointarray.size()==2 && x1==x2 && y1==y2){x=x1; y=y1; return;}
-
-      if (pth->smooth && (pth->pointarray.size()>2 || pth->closed)){
-          if (size_t(sid)+1 == pc)
-              x3=end.x, y3=end.y;
-          else
-              x3=pth->pointarray[sid+1].x, y3=pth->pointarray[sid+1].y;
-          x = 0.5 * (((x1 - 2 * x2 + x3) * t + 2 * x2 - 2 * x1) * t + x1 + x2);
-          y = 0.5 * (((y1 - 2 * y2 + y3) * t + 2 * y2 - 2 * y1) * t + y1 + y2);
-      }else{
-          x = x1+(x2-x1)*t;
-          y = y1+(y2-y1)*t;
+      if (pc == 1 or !pth->total_length) {
+        x = start.x, y = start.y;
+        return;
       }
+      double t;
+      const size_t sid = path_segment_at(pth, position, t);
+      const path_point &p1 = sid == 0 ? start : pth->pointarray[sid-1], &p2 = pth->pointarray[sid];
+      x = p1.x + (p2.x - p1.x) * t;
+      y = p1.y + (p2.y - p1.y) * t;
     }
 
     void path_getspeed(path *pth, double &speed, double position)
     {
       if (!pth) return;
-      if (!pth->pointarray.size()) return;
-      ppi_t ppi = path_point_iterator_at(pth, position);
-      double t = position - ppi->first;
-      t /= double(pth->pointarray[ppi->second].length) / pth->total_length;
-      int sid = ppi->second;
-      double x1, x2, x3;
-      //std::cout << "t on path: " << position << " first: " << ppi->first << " Sid: " << sid << " delta:" << t << std::endl;
       const size_t pc = pth->pointarray.size();
+      if (!pc) return;
+      position = path_wrap(position);
+
+      if (!pth->samples.empty()) {
+        double u;
+        const path_sample *s = path_sample_at(pth, position, u);
+        speed = s[0].speed + (s[1].speed - s[0].speed) * u;
+        return;
+      }
+
       const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
-      const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
-      if (sid==0)
-          x1=start.speed;
-      else
-          x1=pth->pointarray[sid-1].speed;
-      x2=pth->pointarray[sid].speed;
-      if (pth->smooth){
-          if (size_t(sid)+1==pc)
-              x3=end.speed;
-          else
-              x3=pth->pointarray[sid+1].speed;
-          speed = 0.5 * (((x1 - 2 * x2 + x3) * t + 2 * x2 - 2 * x1) * t + x1 + x2);
-      }else{
-          speed = x1+(x2-x1)*t;
+      if (pc == 1 or !pth->total_length) {
+        speed = start.speed;
+        return;
+      }
+      double t;
+      const size_t sid = path_segment_at(pth, position, t);
+      const path_point &p1 = sid == 0 ? start : pth->pointarray[sid-1], &p2 = pth->pointarray[sid];
+      speed = p1.speed + (p2.speed - p1.speed) * t;
+    }
+
+    void path_advance(path *pth, size_t count, double *position, const double *distance, double *x, double *y)
+    {
+      if (!pth or pth->pointarray.empty()) return;
+      const double scale = pth->total_length ? 1 / (100 * pth->total_length) : 0;
+      for (size_t i = 0; i < count; i++)
+      {
+        double speed;
+        path_getspeed(pth, speed, position[i]);
+        position[i] += distance[i] * speed * scale;
+        path_getXY(pth, x[i], y[i], position[i]);
       }
     }
 
     /// Allocates and zero-fills the path array at game start
     void paths_init()
     {
-        pathstructarray = new path*[enigma::path_idmax+1];
-        for (unsigned i = 0; i < enigma::path_idmax; i++)
-            pathstructarray[i] = NULL;
+        pathstructarray.init();
     }
 }
@@ -25,10 +25,10 @@
 **                                                                              **
 \********************************************************************************/
 
-#include <map>
 #include <vector>
+#include <stddef.h>
+#include "resource_registry.h"
 using std::vector;
-using std::map;
 
 #ifdef INCLUDED_FROM_SHELLMAIN
 #  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
@@ -40,24 +40,33 @@ namespace enigma
   {
     double x, y, speed, length;
   };
+  struct path_sample
+  {
+    double x, y, speed;
+  };
   struct path
   {
     int id, precision;
     bool smooth, closed;
     vector<path_point> pointarray;
-    map<double,int> pointoffset;
+    // Baked by path_recalculate, so that sampling neither searches nor evaluates curves.
+    vector<double> segment_start;     // Position at which each point's segment begins; a segment ends at its point
+    vector<unsigned> segment_bucket;  // Straight paths: the segment containing the start of each equal slice of the path
+    vector<path_sample> samples;      // Smooth paths: the curve at equal arc-length intervals, both ends included
     double total_length, centerx, centery;
     path(unsigned pathid, bool smooth, bool closed, int precision, unsigned pointcount);
     ~path();
   };
 
-  extern path** pathstructarray;
+  extern size_t path_idmax;
+  extern resource_registry<path> pathstructarray;
 	void path_add_point(unsigned pathid, double x, double y, double speed);
   void path_recalculate(unsigned pathid);
   void path_getXY(path *pth, double &x, double &y, double position);
-  void path_getspeed(path *pth, double &speed, double position);
-  void pathstructarray_reallocate();
-  typedef map<double,int>::iterator ppi_t;
+  void path_getspeed(path *pth, double &speed, double position);
+  // Moves each follower distance[i] pixels along the path, scaled by the path's speed
+  // where it stands, and fills in where it ends up. Positions are not wrapped.
+  void path_advance(path *pth, size_t count, double *position, const double *distance, double *x, double *y);
 }
 
 namespace enigma
@@ -29,7 +29,9 @@ namespace enigma {
   struct callable_script {
     variant (*base)();
     int argnum;
+    variant (*dispatch)(const variant *const *argv); // Calls base with the first argnum of script_execute's arguments
   };
+  extern const variant script_noarg; // What every argument a script call leaves out refers to
   struct nameid_pair {
     string name; int id;
   };
@@ -39,5 +41,6 @@ namespace enigma {
 };
 
 int resource_get_id(string name);
-variant script_execute(int scr, variant arg0 = 0, variant arg1 = 0, variant arg2 = 0, variant arg3 = 0, variant arg4 = 0, variant arg5 = 0, variant arg6 = 0, variant arg7 = 0, variant arg8 = 0, variant arg9 = 0, variant arg10 = 0, variant arg11 = 0, variant arg12 = 0, variant arg13 = 0, variant arg14 = 14, variant arg15 = 0);
+variant script_execute(int scr, const variant& arg0 = enigma::script_noarg, const variant& arg1 = enigma::script_noarg, const variant& arg2 = enigma::script_noarg, const variant& arg3 = enigma::script_noarg, const variant& arg4 = enigma::script_noarg, const variant& arg5 = enigma::script_noarg, const variant& arg6 = enigma::script_noarg, const variant& arg7 = enigma::script_noarg,
+                       const variant& arg8 = enigma::script_noarg, const variant& arg9 = enigma::script_noarg, const variant& arg10 = enigma::script_noarg, const variant& arg11 = enigma::script_noarg, const variant& arg12 = enigma::script_noarg, const variant& arg13 = enigma::script_noarg, const variant& arg14 = enigma::script_noarg, const variant& arg15 = enigma::script_noarg);
 bool script_exists(int script);
@@ -0,0 +1,123 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef _H_RESOURCE_REGISTRY
+#define _H_RESOURCE_REGISTRY
+
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+  The table of pointers behind one kind of resource. It indexes like the bare array
+  it replaces, so spritestructarray[id] still reads and writes a slot, and it keeps
+  the matching *_idmax (which the compiler writes out) at one past the highest id
+  ever handed out.
+
+  Capacity doubles as resources are added, so creating n resources at run time
+  copies O(n) pointers in total rather than O(n^2). Ids released by deleting a
+  resource are handed out again, most recent first. Each slot has a generation
+  that is even while its id is in use and odd while it is free; anything holding
+  an id across frames can keep the generation beside it to notice reuse.
+**/
+
+namespace enigma
+{
+  template<typename T> class resource_registry
+  {
+    T **slots;             // slots[id - first]
+    unsigned *generations;
+    size_t capacity;
+    size_t &idmax;
+    const int first;       // Lowest valid id; fonts begin at -1
+    std::vector<int> released;
+
+    void grow(size_t need)
+    {
+      if (need <= capacity) return;
+      size_t ncap = capacity ? capacity * 2 : 16;
+      while (ncap < need) ncap *= 2;
+      slots = (T**) realloc(slots, ncap * sizeof(T*));
+      generations = (unsigned*) realloc(generations, ncap * sizeof(unsigned));
+      memset(slots + capacity, 0, (ncap - capacity) * sizeof(T*));
+      memset(generations + capacity, 0, (ncap - capacity) * sizeof(unsigned));
+      capacity = ncap;
+    }
+
+    public:
+      resource_registry(size_t &idmax_var, int first_id = 0): slots(NULL), generations(NULL), capacity(0), idmax(idmax_var), first(first_id) {}
+
+      /// Makes an empty slot for every id the game was compiled with. Called at game start.
+      void init()
+      {
+        grow(idmax - first);
+        memset(slots, 0, capacity * sizeof(T*));
+        released.clear();
+      }
+
+      T *&operator[](int id) { return slots[id - first]; }
+      T *operator[](int id) const { return slots[id - first]; }
+
+      bool exists(int id) const {
+        return id >= first and (id < 0 or size_t(id) < idmax) and slots[id - first];
+      }
+      unsigned generation(int id) const { return generations[id - first]; }
+
+      /// Returns an id with an empty slot, reusing a released one if there is any.
+      int claim()
+      {
+        if (!released.empty()) {
+          const int id = released.back();
+          released.pop_back();
+          generations[id - first]++;
+          return id;
+        }
+        grow(idmax + 1 - first);
+        return idmax++;
+      }
+
+      /// Makes room for an id chosen by the loader, counting it as in use.
+      void place(int id)
+      {
+        grow(id + 1 - first);
+        if (size_t(id + 1) > idmax)
+          idmax = id + 1;
+      }
+
+      /// Empties the slot of a deleted resource and frees its id for claim(). Releasing twice does nothing.
+      void release(int id)
+      {
+        if (id < first or (id >= 0 and size_t(id) >= idmax) or generations[id - first] & 1)
+          return;
+        slots[id - first] = NULL;
+        generations[id - first]++;
+        released.push_back(id);
+      }
+  };
+}
+
+#endif
@@ -107,6 +107,7 @@ namespace enigma
           tile t = tiles[tilei];
           drawing_depths[t.depth].tiles.push_back(tiles[tilei]);
       }
+      graphics_rebuild_tiles();
       //Tiles end
 
     view_enabled = views_enabled;
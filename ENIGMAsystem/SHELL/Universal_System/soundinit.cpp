@@ -25,7 +25,7 @@ using namespace std;
 #include "resinit.h"
 #include "zlib.h"
 
-void sound_play(int sound);
+int sound_play(int sound);
 
 namespace enigma
 {
@@ -0,0 +1,277 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "spatial_index.h"
+#include "instance_system.h"
+#include "planar_object.h"
+
+namespace enigma
+{
+  extern objectid_base *objects;
+  extern int object_idmax;
+
+  // Distances a cell bound may be off by through rounding in the cell arithmetic.
+  static inline double slack(double d) { return d * 1e-9 + 1e-9; }
+
+  int spatial_index::cell_at(double x, double y) const
+  {
+    const double cx = floor((x - left) / size), cy = floor((y - top) / size);
+    if (!(cx >= 0 and cx < cols and cy >= 0 and cy < rows)) // Also catches NaN
+      return -1;
+    return int(cy) * cols + int(cx);
+  }
+
+  void spatial_index::file(int i, int cell)
+  {
+    std::vector<int> &to = cell == -1 ? strays : cells[cell];
+    cell_of[i] = cell, slot_of[i] = to.size();
+    to.push_back(i);
+  }
+
+  void spatial_index::unfile(int i)
+  {
+    std::vector<int> &from = cell_of[i] == -1 ? strays : cells[cell_of[i]];
+    const int moved = from.back();
+    from[slot_of[i]] = moved, slot_of[moved] = slot_of[i];
+    from.pop_back();
+  }
+
+  // Sizes the grid to the current positions, at about two instances to a cell, and files everything.
+  void spatial_index::rebuild()
+  {
+    const size_t n = insts.size();
+    double l = 0, t = 0, r = 0, b = 0;
+    bool any = false;
+    for (size_t i = 0; i < n; i++)
+      if (xs[i] - xs[i] == 0 and ys[i] - ys[i] == 0) { // Finite
+        if (!any) l = r = xs[i], t = b = ys[i], any = true;
+        else l = std::min(l, xs[i]), r = std::max(r, xs[i]), t = std::min(t, ys[i]), b = std::max(b, ys[i]);
+      }
+    const double area = std::max(r - l, 1.0) * std::max(b - t, 1.0);
+    left = l, top = t, size = std::max(sqrt(2 * area / std::max(n, size_t(1))), 1.0);
+    cols = any ? int((r - l) / size) + 1 : 0;
+    rows = any ? int((b - t) / size) + 1 : 0;
+
+    for (size_t c = 0; c < cells.size(); c++)
+      cells[c].clear();
+    cells.resize(size_t(cols) * rows);
+    strays.clear();
+    cell_of.resize(n), slot_of.resize(n);
+    for (size_t i = 0; i < n; i++)
+      file(i, cell_at(xs[i], ys[i]));
+  }
+
+  void spatial_index::sync(int obj, unsigned long list_changes)
+  {
+    if (list_changes != changes) {
+      insts.clear();
+      for (iterator it = fetch_inst_iter_by_int(obj); it; ++it)
+        insts.push_back(*it);
+      xs.resize(insts.size()), ys.resize(insts.size());
+      for (size_t i = 0; i < insts.size(); i++)
+        xs[i] = ((object_planar*)insts[i])->x, ys[i] = ((object_planar*)insts[i])->y;
+      changes = list_changes;
+      rebuild();
+      return;
+    }
+    for (size_t i = 0; i < insts.size(); i++)
+    {
+      const object_planar *const inst = (object_planar*)insts[i];
+      if (inst->x == xs[i] and inst->y == ys[i])
+        continue;
+      xs[i] = inst->x, ys[i] = inst->y;
+      const int cell = cell_at(xs[i], ys[i]);
+      if (cell != cell_of[i])
+        unfile(i), file(i, cell);
+    }
+    if (strays.size() > 8 and strays.size() > insts.size() / 8)
+      rebuild();
+  }
+
+  void spatial_index::ring(int cx, int cy, int r, std::vector<int> &out) const
+  {
+    out.clear();
+    for (int y = std::max(cy - r, 0); y <= std::min(cy + r, rows - 1); y++)
+    {
+      if (y == cy - r or y == cy + r) {
+        for (int x = std::max(cx - r, 0); x <= std::min(cx + r, cols - 1); x++)
+          out.push_back(y * cols + x);
+      }
+      else {
+        if (cx - r >= 0) out.push_back(y * cols + cx - r);
+        if (cx + r < cols and r) out.push_back(y * cols + cx + r);
+      }
+    }
+  }
+
+  namespace {
+    // The best candidate so far; ties go to the earlier instance in the list.
+    struct pick
+    {
+      double dist;
+      int index;
+      pick(): dist(-1), index(-1) {}
+      void nearer(double d, int i) { if (index == -1 or d < dist or (d == dist and i < index)) dist = d, index = i; }
+      void further(double d, int i) { if (index == -1 or d > dist or (d == dist and i < index)) dist = d, index = i; }
+    };
+  }
+
+  int spatial_index::nearest(double x, double y, int skip_id) const
+  {
+    pick best;
+    for (size_t k = 0; k < strays.size(); k++) {
+      const int i = strays[k];
+      if (int(insts[i]->id) != skip_id) best.nearer(hypot(xs[i] - x, ys[i] - y), i);
+    }
+    if (cols)
+    {
+      // Start from the cell under x,y (or the nearest edge cell) and widen ring by ring.
+      // Everything in ring r is at least (r - 1) * size away.
+      const int cx = std::min(std::max(int(std::max(floor((x - left) / size), -1.0)), 0), cols - 1);
+      const int cy = std::min(std::max(int(std::max(floor((y - top) / size), -1.0)), 0), rows - 1);
+      const int last = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+      std::vector<int> around;
+      for (int r = 0; r <= last; r++)
+      {
+        if (best.index != -1 and (r - 1) * size > best.dist + slack(best.dist))
+          break;
+        ring(cx, cy, r, around);
+        for (size_t c = 0; c < around.size(); c++)
+          for (size_t k = 0; k < cells[around[c]].size(); k++) {
+            const int i = cells[around[c]][k];
+            if (int(insts[i]->id) != skip_id) best.nearer(hypot(xs[i] - x, ys[i] - y), i);
+          }
+      }
+    }
+    return best.index == -1 ? noone : insts[best.index]->id;
+  }
+
+  int spatial_index::furthest(double x, double y, int skip_id) const
+  {
+    pick best;
+    for (size_t k = 0; k < strays.size(); k++) {
+      const int i = strays[k];
+      if (int(insts[i]->id) != skip_id) best.further(hypot(xs[i] - x, ys[i] - y), i);
+    }
+    if (cols)
+    {
+      // Work inward from the outermost ring. Everything in ring r is at most
+      // (r + 1) * size * sqrt(2) past the near edge of the starting cell.
+      const int cx = std::min(std::max(int(std::max(floor((x - left) / size), -1.0)), 0), cols - 1);
+      const int cy = std::min(std::max(int(std::max(floor((y - top) / size), -1.0)), 0), rows - 1);
+      const double ex = std::max(std::max(left + cx * size - x, x - (left + (cx + 1) * size)), 0.0);
+      const double ey = std::max(std::max(top + cy * size - y, y - (top + (cy + 1) * size)), 0.0);
+      const double edge = hypot(ex, ey);
+      const int last = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+      std::vector<int> around;
+      for (int r = last; r >= 0; r--)
+      {
+        const double reach = edge + (r + 1) * size * M_SQRT2;
+        if (best.index != -1 and reach + slack(reach) < best.dist)
+          break;
+        ring(cx, cy, r, around);
+        for (size_t c = 0; c < around.size(); c++)
+          for (size_t k = 0; k < cells[around[c]].size(); k++) {
+            const int i = cells[around[c]][k];
+            if (int(insts[i]->id) != skip_id) best.further(hypot(xs[i] - x, ys[i] - y), i);
+          }
+      }
+    }
+    return best.index == -1 ? noone : insts[best.index]->id;
+  }
+
+  int spatial_index::count_in_rectangle(double x1, double y1, double x2, double y2, int skip_id) const
+  {
+    if (x1 > x2) std::swap(x1, x2);
+    if (y1 > y2) std::swap(y1, y2);
+    int count = 0;
+    for (size_t k = 0; k < strays.size(); k++) {
+      const int i = strays[k];
+      count += xs[i] >= x1 and xs[i] <= x2 and ys[i] >= y1 and ys[i] <= y2 and int(insts[i]->id) != skip_id;
+    }
+    if (!cols) return count;
+    const double pad = slack(size);
+    const int l = std::max(int(std::max(floor((x1 - pad - left) / size), -1.0)), 0), r = std::min(int(std::min(floor((x2 + pad - left) / size), double(cols))), cols - 1);
+    const int t = std::max(int(std::max(floor((y1 - pad - top) / size), -1.0)), 0), b = std::min(int(std::min(floor((y2 + pad - top) / size), double(rows))), rows - 1);
+    for (int cy = t; cy <= b; cy++)
+      for (int cx = l; cx <= r; cx++)
+      {
+        const std::vector<int> &cell = cells[cy * cols + cx];
+        for (size_t k = 0; k < cell.size(); k++) {
+          const int i = cell[k];
+          count += xs[i] >= x1 and xs[i] <= x2 and ys[i] >= y1 and ys[i] <= y2 and int(insts[i]->id) != skip_id;
+        }
+      }
+    return count;
+  }
+
+  void spatial_index::list_in_circle(double x, double y, double r, int skip_id, std::vector<int> &ids) const
+  {
+    std::vector<int> found;
+    for (size_t k = 0; k < strays.size(); k++) {
+      const int i = strays[k];
+      if (hypot(xs[i] - x, ys[i] - y) <= r and int(insts[i]->id) != skip_id) found.push_back(i);
+    }
+    if (cols and r >= 0)
+    {
+      const double pad = slack(size);
+      const int l = std::max(int(std::max(floor((x - r - pad - left) / size), -1.0)), 0), rt = std::min(int(std::min(floor((x + r + pad - left) / size), double(cols))), cols - 1);
+      const int t = std::max(int(std::max(floor((y - r - pad - top) / size), -1.0)), 0), b = std::min(int(std::min(floor((y + r + pad - top) / size), double(rows))), rows - 1);
+      for (int cy = t; cy <= b; cy++)
+        for (int cx = l; cx <= rt; cx++)
+        {
+          const std::vector<int> &cell = cells[cy * cols + cx];
+          for (size_t k = 0; k < cell.size(); k++) {
+            const int i = cell[k];
+            if (hypot(xs[i] - x, ys[i] - y) <= r and int(insts[i]->id) != skip_id) found.push_back(i);
+          }
+        }
+    }
+    std::sort(found.begin(), found.end());
+    for (size_t k = 0; k < found.size(); k++)
+      ids.push_back(insts[found[k]]->id);
+  }
+
+  spatial_index *spatial_index_for(int obj)
+  {
+    static std::map<int, spatial_index> indexes;
+    unsigned long list_changes;
+    if (obj == all)
+      list_changes = instance_list_changes;
+    else if (obj >= 0 and obj < object_idmax)
+      list_changes = objects[obj].changes;
+    else
+      return NULL;
+    spatial_index &index = indexes[obj];
+    index.sync(obj, list_changes);
+    return &index;
+  }
+}
@@ -0,0 +1,88 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef _H_SPATIAL_INDEX
+#define _H_SPATIAL_INDEX
+
+#include <vector>
+
+/**
+  A uniform grid over the positions of the instances of one object (or of all
+  instances), behind instance_nearest, instance_furthest and the region queries.
+
+  Instances write x and y directly, so nothing tells the index when one moves.
+  Each query first syncs the index instead: one pass over a dense array compares
+  every instance's position with the one it was filed under and refiles those that
+  changed cell. That pass replaces walking the instance list and calling hypot on
+  every instance. The grid is rebuilt only when instances join or leave the list,
+  or when too many have wandered off it.
+
+  Every query answers exactly as a scan of the instance list would: candidates are
+  measured with the same arithmetic, and ties go to the earlier instance in the list.
+**/
+
+namespace enigma
+{
+  struct object_basic;
+
+  class spatial_index
+  {
+    std::vector<object_basic*> insts;   // In the order the instance list gives them
+    std::vector<double> xs, ys;         // Positions as last filed
+    std::vector<int> cell_of, slot_of;  // Cell of each instance (-1 off the grid), and its place in that cell
+    std::vector< std::vector<int> > cells;
+    std::vector<int> strays;            // Instances off the grid, in no particular order
+    unsigned long changes;              // Membership count the index was built against
+    double left, top, size;             // The grid: cells of size by size from left,top
+    int cols, rows;
+
+    void rebuild();
+    int cell_at(double x, double y) const;
+    void file(int i, int cell);
+    void unfile(int i);
+    void ring(int cx, int cy, int r, std::vector<int> &out) const; // Cells r steps from cx,cy on the grid
+
+    public:
+      spatial_index(): changes(~0UL), left(0), top(0), size(1), cols(0), rows(0) {}
+
+      /// Brings the index up to date with the instance list and positions of @param obj.
+      void sync(int obj, unsigned long list_changes);
+
+      /// Id of the instance nearest to (furthest from) x,y, or noone. @param skip_id is left out.
+      int nearest(double x, double y, int skip_id) const;
+      int furthest(double x, double y, int skip_id) const;
+      /// Number of instances whose position lies in the rectangle, edges included.
+      int count_in_rectangle(double x1, double y1, double x2, double y2, int skip_id) const;
+      /// Appends the ids of instances within r of x,y to @param ids, in list order.
+      void list_in_circle(double x, double y, double r, int skip_id, std::vector<int> &ids) const;
+  };
+
+  /// The index of the instances of @param obj, synced, or NULL if obj names no object (nor all).
+  spatial_index *spatial_index_for(int obj);
+}
+
+#endif
@@ -73,24 +73,28 @@ using namespace std;
 #endif
 
 namespace enigma {
-  sprite** spritestructarray;
 	extern size_t sprite_idmax;
+  resource_registry<sprite> spritestructarray(sprite_idmax);
 	sprite::sprite(): texturearray(NULL), texbordxarray(NULL), texbordyarray(NULL) {}
   sprite::sprite(unsigned int x): texturearray(new unsigned int[x]), texbordxarray(new double[x]), texbordyarray(new double[x]) {}
 }
 
 int sprite_add(string filename, int imgnumb, bool precise, bool transparent, bool smooth, bool preload, int x_offset, int y_offset)
 {
-	enigma::sprite *spr = enigma::spritestructarray[enigma::sprite_idmax] = new enigma::sprite;
+	const int id = enigma::spritestructarray.claim();
+	enigma::sprite *spr = enigma::spritestructarray[id] = new enigma::sprite;
     enigma::sprite_add_to_index(spr, filename, imgnumb, transparent, smooth, x_offset, y_offset);
-	return enigma::sprite_idmax++;
+    spr->id = id;
+	return id;
 }
 
 int sprite_add(string filename, int imgnumb, bool transparent, bool smooth, int x_offset, int y_offset)
 {
-	enigma::sprite *spr = enigma::spritestructarray[enigma::sprite_idmax] = new enigma::sprite;
+	const int id = enigma::spritestructarray.claim();
+	enigma::sprite *spr = enigma::spritestructarray[id] = new enigma::sprite;
     enigma::sprite_add_to_index(spr, filename, imgnumb, transparent, smooth, x_offset, y_offset);
-	return enigma::sprite_idmax++;
+    spr->id = id;
+	return id;
 }
 
 bool sprite_replace(int ind, string filename, int imgnumb, bool precise, bool transparent, bool smooth, bool preload, int x_offset, int y_offset, bool free_texture)
@@ -136,16 +140,17 @@ void sprite_delete(int ind, bool free_texture)
             enigma::graphics_delete_texture(spr->texturearray[ii]);
 
     delete enigma::spritestructarray[ind];
-    enigma::spritestructarray[ind] = NULL;
+    enigma::spritestructarray.release(ind);
 }
 
 int sprite_duplicate(int copy_sprite)
 {
     get_sprite_mutable(spr_copy,copy_sprite,-1);
-    enigma::sprite *spr = enigma::spritestructarray[enigma::sprite_idmax] = new enigma::sprite;
-    spr->id = enigma::sprite_idmax;
+    const int id = enigma::spritestructarray.claim();
+    enigma::sprite *spr = enigma::spritestructarray[id] = new enigma::sprite;
+    spr->id = id;
     enigma::sprite_add_copy(spr, spr_copy);
-	return enigma::sprite_idmax++;
+	return id;
 }
 
 void sprite_assign(int ind, int copy_sprite, bool free_texture)
@@ -227,22 +232,14 @@ namespace enigma
   //Allocates and zero-fills the array at game start
   void sprites_init()
   {
-    spritestructarray = new sprite*[sprite_idmax+1];
-    for (unsigned i = 0; i < sprite_idmax; i++)
-      spritestructarray[i] = NULL;
+    spritestructarray.init();
   }
 
-    void spritestructarray_reallocate()
-    {
-        sprite** spriteold = spritestructarray;
-        spritestructarray = new sprite*[sprite_idmax+2];
-        for (size_t i = 0; i < sprite_idmax; i++) spritestructarray[i] = spriteold[i]; delete[] spriteold;
-    }
-
     //Adds an empty sprite to the list
     int sprite_new_empty(unsigned sprid, unsigned subc, int w, int h, int x, int y, int bbt, int bbb, int bbl, int bbr, bool pl, bool sm)
     {
         sprite *as = new sprite(subc);
+        spritestructarray.place(sprid);
         spritestructarray[sprid] = as;
 
         as->id = sprid;
@@ -265,9 +262,6 @@ namespace enigma
         as->texbordyarray = new double[subc];
         as->colldata = new void*[subc];
 
-        if (sprite_idmax < sprid+1)
-          sprite_idmax = sprid+1;
-
         return sprid;
     }
 
@@ -281,7 +275,6 @@ namespace enigma
 
         //ns.pixeldata=(void**) malloc(sizeof(void*));
         //ns.pixeldata[0]=bitmapbuffer;
-        ns->id = sprite_idmax;
         ns->subcount  = 1;
         ns->width     = width;
         ns->height    = height;
@@ -327,7 +320,7 @@ namespace enigma
   //Adds a subimage to an existing sprite from the exe
   void sprite_set_subimage(int sprid, int imgindex, int x,int y, unsigned int w,unsigned int h,unsigned char*chunk, unsigned char*collision_data, collision_type ct)
   {
-    unsigned int fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
+    unsigned int fullwidth = image_pad_pow2 ? nlpo2dc(w)+1 : w, fullheight = image_pad_pow2 ? nlpo2dc(h)+1 : h;
     char *imgpxdata = new char[4*fullwidth*fullheight+1], *imgpxptr = imgpxdata;
     unsigned int rowindex,colindex;
     for (rowindex = 0; rowindex < h; rowindex++)
@@ -342,7 +335,7 @@ namespace enigma
       memset(imgpxptr, 0, (fullwidth-colindex) << 2);
       imgpxptr += (fullwidth-colindex) << 2;
     }
-    memset(imgpxptr,0,(fullheight-h) * fullwidth);
+    memset(imgpxptr,0,((fullheight-h) * fullwidth) << 2);
 
     unsigned texture = graphics_create_texture(fullwidth,fullheight,imgpxdata);
 
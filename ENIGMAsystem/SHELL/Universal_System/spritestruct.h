@@ -29,6 +29,7 @@
 #include <string>
 
 #include "Collision_Systems/collision_types.h"
+#include "resource_registry.h"
 
 #ifndef ENIGMA_SPRITESTRUCT
 #define ENIGMA_SPRITESTRUCT
@@ -52,8 +53,8 @@ namespace enigma
     sprite();
     sprite(unsigned int);
   };
-  extern sprite** spritestructarray;
   extern size_t sprite_idmax;
+  extern resource_registry<sprite> spritestructarray;
 }
 
 //int sprite_add(string filename,double imgnumb,double precise,double transparent,double smooth,double preload,double x_offset,double y_offset);
@@ -67,7 +68,6 @@ namespace enigma
   //Adds a subimage to an existing sprite from the exe
   void sprite_set_subimage(int sprid, int imgindex, int x, int y, unsigned int w,unsigned int h,unsigned char*chunk, unsigned char*collision_data, collision_type ct);
 
-  void spritestructarray_reallocate();
 }
 
 extern int sprite_get_width  (int sprite);
@@ -454,7 +454,7 @@ types_binary_extrapolate_string_p(bool operator<,  const var&, { return y > x;
    Unary nonsense for either party
 */
 
-char&     variant::operator[] (int x)    { return sval[x]; }
+char&     variant::operator[] (int x)    { return sval.modify(x); }
 variant&  variant::operator++ ()         { return ++rval.d, *this; }
 double    variant::operator++ (int)      { return rval.d++; }
 variant&  variant::operator-- ()         { return --rval.d, *this; }
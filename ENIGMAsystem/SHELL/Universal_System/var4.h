@@ -34,6 +34,7 @@ using std::string;
 // We want var and variant to support a lot of assignment types.
 
 #include "var_te.h"
+#include "var_string.h"
 
 namespace enigma {
   union rvt {
@@ -48,7 +49,7 @@ struct var;
 struct variant
 {
   enigma::rvt rval;
-  string sval;
+  enigma::var_string sval;
   int type;
   
   operator int();
@@ -158,11 +159,13 @@ struct variant
 
 struct var
 {
-  void *values;
+  variant scalar; // The value of this var until it is first indexed as an array
+  void *values;   // The array table that replaces it from then on, or NULL
   
   private:
     void initialize();
     void cleanup();
+    void promote();
   public:
   
   operator variant&();
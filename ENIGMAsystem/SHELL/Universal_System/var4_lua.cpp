@@ -34,59 +34,99 @@ using std::string;
 #define as_lua(x) (*(vararray*)(&(x)))
 #define vararray lua_table<lua_table<variant> >
 
+// A var holds its value inline until it is indexed past element 0. Only then is the
+// table built, so plain locals, fields, and temporaries never touch the heap.
+static const variant var_unset_element;
+
 void var::initialize() {
-  new(&values) vararray;
+  values = NULL;
 }
 void var::cleanup() {
-  as_lua(values) . ~vararray();
+  if (values)
+    as_lua(values) . ~vararray();
+  values = NULL;
+}
+void var::promote() {
+  new(&values) vararray;
+  variant &first = **as_lua(values);
+  first.rval = scalar.rval, first.type = scalar.type;
+  first.sval.swap(scalar.sval);
 }
 
 variant& var::operator*  ()
 {
-  return **as_lua(values);
+  return values ? **as_lua(values) : scalar;
 }
 variant& var::operator() ()
 {
-  return **as_lua(values);
+  return values ? **as_lua(values) : scalar;
 }
 variant& var::operator[] (int ind)
 {
+  if (!values) {
+    if (!ind) return scalar;
+    promote();
+  }
   return (*as_lua(values))[size_t(ind)];
 }
 variant& var::operator() (int ind)
 {
+  if (!values) {
+    if (!ind) return scalar;
+    promote();
+  }
   return (*as_lua(values))[size_t(ind)];
 }
 variant& var::operator() (int ind1,int ind2)
 {
+  if (!values) {
+    if (!ind1 and !ind2) return scalar;
+    promote();
+  }
   return as_lua(values)[size_t(ind2)][size_t(ind1)];
 }
 
 const variant& var::operator*  () const
 {
-  return **as_lua(values);
+  return values ? **as_lua(values) : scalar;
 }
 const variant& var::operator() () const
 {
-  return **as_lua(values);
+  return values ? **as_lua(values) : scalar;
 }
 const variant& var::operator[] (int ind) const
 {
+  if (!values)
+    return ind ? var_unset_element : scalar;
   return (*as_lua(values))[size_t(ind)];
 }
 const variant& var::operator() (int ind) const
 {
+  if (!values)
+    return ind ? var_unset_element : scalar;
   return (*as_lua(values))[size_t(ind)];
 }
 const variant& var::operator() (int ind1,int ind2) const
 {
+  if (!values)
+    return ind1 or ind2 ? var_unset_element : scalar;
   return as_lua(values)[size_t(ind2)][size_t(ind1)];
 }
 
-var::var(const var& x) {
-  new(&values) vararray(*(vararray*)&(x.values));
+var::var(const var& x): scalar(x.values ? variant() : x.scalar), values(NULL) {
+  if (x.values)
+    new(&values) vararray(as_lua(x.values));
 }
 var& var::operator= (const var& x) {
-  *(vararray*)&(values) = *(vararray*)&(x.values);
+  if (x.values) {
+    if (values)
+      as_lua(values) = as_lua(x.values);
+    else
+      new(&values) vararray(as_lua(x.values));
+  }
+  else {
+    cleanup();
+    scalar = x.scalar;
+  }
   return *this;
 }
@@ -0,0 +1,95 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include "var_string.h"
+
+namespace enigma
+{
+  const std::string &var_string::blank() {
+    static const std::string nothing;
+    return nothing;
+  }
+
+  // Single characters come from string_char_at and chr in tight loops, so each gets
+  // one permanent buffer. The table is built on first use, since global variants may
+  // be constructed before this file's statics.
+  static var_string_rep *single_char(unsigned char c)
+  {
+    static var_string_rep *table[256];
+    if (!table[c])
+      table[c] = new var_string_rep(std::string(1, char(c)));
+    table[c]->refs++;
+    return table[c];
+  }
+
+  var_string_rep *var_string::share(const std::string &s)
+  {
+    if (s.empty())
+      return NULL;
+    if (s.length() == 1)
+      return single_char(s[0]);
+    return new var_string_rep(s);
+  }
+
+  var_string::var_string(const char *s): rep(NULL)
+  {
+    if (!s or !*s)
+      return;
+    if (!s[1])
+      rep = single_char(*s);
+    else
+      rep = new var_string_rep(s);
+  }
+
+  void var_string::detach()
+  {
+    if (!rep or rep->refs == 1)
+      return;
+    var_string_rep *n = new var_string_rep(rep->str);
+    release(), rep = n;
+  }
+
+  var_string& var_string::operator+= (const std::string &s)
+  {
+    if (s.empty())
+      return *this;
+    if (!rep)
+      return *this = s;
+    detach();
+    rep->str += s;
+    return *this;
+  }
+
+  char &var_string::modify(size_t i) {
+    if (!rep) { // Like std::string, the empty string has a terminating null, but writing it changes nothing
+      static char terminator;
+      return terminator = 0;
+    }
+    detach();
+    return rep->str[i];
+  }
+}
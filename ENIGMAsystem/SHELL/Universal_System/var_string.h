@@ -0,0 +1,122 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2008 Josh Ventura                                             **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef _H_VAR_STRING
+#define _H_VAR_STRING
+
+#include <string>
+#include <stddef.h>
+
+/**
+  The string half of a variant. It is a single pointer to an immutable, reference
+  counted buffer, so copying a variant (into a ds_list, a grid cell, a function
+  argument) costs an increment instead of a heap allocation. The empty string is
+  a null pointer and owns nothing; one-character strings share permanent buffers
+  that are never freed.
+
+  Writing through a shared buffer detaches a private copy first. Counts are not
+  atomic, in keeping with the rest of var.
+**/
+
+namespace enigma
+{
+  struct var_string_rep
+  {
+    long refs;
+    std::string str;
+    var_string_rep(const std::string &s): refs(1), str(s) {}
+  };
+
+  class var_string
+  {
+    var_string_rep *rep; // NULL for the empty string
+
+    static const std::string &blank();
+    static var_string_rep *share(const std::string &s);
+    void release() { if (rep and !--rep->refs) delete rep; }
+    void detach();
+
+    public:
+      var_string(): rep(NULL) {}
+      var_string(const var_string &x): rep(x.rep) { if (rep) rep->refs++; }
+      explicit var_string(const std::string &s): rep(share(s)) {}
+      explicit var_string(const char *s);
+      ~var_string() { release(); }
+
+      var_string& operator= (const var_string &x) {
+        if (x.rep) x.rep->refs++;
+        release(), rep = x.rep;
+        return *this;
+      }
+      var_string& operator= (const std::string &s) {
+        var_string_rep *n = share(s);
+        release(), rep = n;
+        return *this;
+      }
+      var_string& operator= (const char *s) { return *this = var_string(s); }
+
+      var_string& operator+= (const std::string &s);
+      var_string& operator+= (const var_string &s) { return *this += s.str(); }
+      var_string& operator+= (const char *s) { return *this += std::string(s); }
+      var_string& operator+= (char c) { return *this += std::string(1, c); }
+
+      const std::string &str() const { return rep ? rep->str : blank(); }
+      operator const std::string&() const { return str(); }
+      const char *c_str() const { return str().c_str(); }
+      size_t length() const { return rep ? rep->str.length() : 0; }
+      size_t size()   const { return length(); }
+      bool   empty()  const { return !rep; }
+
+      // Reads never copy; use modify() for a writable reference to one character.
+      char operator[] (size_t i) const { return str()[i]; }
+      char &modify(size_t i);
+      std::string substr(size_t pos, size_t len = std::string::npos) const { return str().substr(pos, len); }
+
+      void swap(var_string &x) { var_string_rep *t = rep; rep = x.rep, x.rep = t; }
+      void clear() { release(), rep = NULL; }
+  };
+
+  inline bool operator== (const var_string &a, const var_string &b) { return a.str() == b.str(); }
+  inline bool operator!= (const var_string &a, const var_string &b) { return a.str() != b.str(); }
+  inline bool operator<  (const var_string &a, const var_string &b) { return a.str() <  b.str(); }
+  inline bool operator>  (const var_string &a, const var_string &b) { return a.str() >  b.str(); }
+  inline bool operator<= (const var_string &a, const var_string &b) { return a.str() <= b.str(); }
+  inline bool operator>= (const var_string &a, const var_string &b) { return a.str() >= b.str(); }
+
+  inline bool operator== (const var_string &a, const std::string &b) { return a.str() == b; }
+  inline bool operator!= (const var_string &a, const std::string &b) { return a.str() != b; }
+  inline bool operator<  (const var_string &a, const std::string &b) { return a.str() <  b; }
+  inline bool operator>  (const var_string &a, const std::string &b) { return a.str() >  b; }
+  inline bool operator<= (const var_string &a, const std::string &b) { return a.str() <= b; }
+  inline bool operator>= (const var_string &a, const std::string &b) { return a.str() >= b; }
+
+  inline std::string operator+ (const var_string &a, const var_string &b) { return a.str() + b.str(); }
+  inline std::string operator+ (const var_string &a, const std::string &b) { return a.str() + b; }
+  inline std::string operator+ (const std::string &a, const var_string &b) { return a + b.str(); }
+}
+
+#endif
@@ -0,0 +1,44 @@
+// Checks file_text_read_real against strtod on the forms it parses itself and the ones it hands off.
+// Build from ENIGMAsystem/SHELL:
+//   g++ -I. testfileio/fileio_test.cc Universal_System/fileio.cpp -o fileio_test && ./fileio_test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+using namespace std;
+
+#include "Universal_System/fileio.h"
+
+int main()
+{
+  const char *const numbers[] = {
+    "0", "12.5", "-3", "+7.25e3", "1e-5", "123456789012345678901", "0.1",
+    "0x1A", "0X10", "-0x8", "0x1.8p1", "inf", "-INF", "infinity"
+  };
+  const int count = sizeof(numbers) / sizeof(*numbers);
+
+  const char *fname = "fileio_test.txt";
+  FILE *f = fopen(fname, "w");
+  if (!f) return perror(fname), 1;
+  for (int i = 0; i < count; i++)
+    fprintf(f, "%s ", numbers[i]);
+  fputs("\n42\n", f);
+  fclose(f);
+
+  int failures = 0;
+  const int id = file_text_open_read(fname);
+  for (int i = 0; i < count; i++)
+  {
+    const double got = file_text_read_real(id), want = strtod(numbers[i], NULL);
+    if (got != want)
+      printf("%s: read %.17g, expected %.17g\n", numbers[i], got, want), failures++;
+  }
+  file_text_readln(id);
+  if (file_text_read_real(id) != 42) // Each number consumed all of its own text
+    puts("The line after the numbers was not read back as 42"), failures++;
+  file_text_close(id);
+  remove(fname);
+
+  printf("%d of %d failed\n", failures, count + 1);
+  return failures != 0;
+}
@@ -42,7 +42,12 @@ alarm: 2
 	Group: Alarm
 	Name: Alarm %1
 	Mode: Stacked
-	Sub Check: {alarm[%1] = (int)alarm[%1]; if ((alarm[%1] == -1) or (alarm[%1]--)) return 0; }
+	Sub Check: alarm.fire(%1)
+	Iterator-declare: /* Alarms are scheduled on the timer wheel */
+	Iterator-initialize: alarm.link(id);
+	Iterator-remove: alarm.unlink();
+	Iterator-delete: /* The wheel drops entries for instances that no longer exist */
+	Instead: enigma::alarm_wheel_advance(); while (enigma::object_basic *inst = enigma::alarm_wheel_next()) { enigma::temp_event_scope alarm_scope(inst); ((enigma::event_parent*)inst)->myevent_alarm(); } # Only alarms expiring this step are visited
 
 
 # Keyboard events. These are simple enough.
@@ -234,6 +239,16 @@ globalmiddlerelease: 6
 
 # Finally, some general-purpose events
 
+pathupdate: 100000
+	Name: Path Update
+	Mode: None
+	Default: ;
+	Iterator-declare: /* Path followers are kept in a dense array by the Paths extension */
+	Iterator-initialize: enigma::path_follower_link(this, this);
+	Iterator-remove: enigma::path_follower_unlink(this);
+	Iterator-delete: /* Unlinked along with the instance */
+	Instead: enigma::path_update_followers(); # Every instance on a path is advanced in one pass
+
 step: 3
 	Name: Step
 	Mode: Special
@@ -242,7 +257,7 @@ step: 3
 localsweep: 100000 
 	Name: Locals sweep 
 	Mode: Inline
-	Constant: if (path_update()) {speed = 0; return 0;} enigma::propagate_locals(this);
+	Constant: enigma::propagate_locals(this);
 
 
 # Lump of "Other" events.
@@ -251,7 +266,8 @@ pathend: 7
 	Name: Path End
 	Mode: Special
 	Case: 8
-	Super Check: false #Paths are not yet implemented.
+	Super Check: enigma::path_ends_this_step
+	Sub Check: path_ended_at == enigma::path_step
 outsideroom: 7
 	Name: Outside Room
 	Mode: Special
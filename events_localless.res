@@ -51,7 +51,12 @@ alarm: 2
 	Group: Alarm
 	Name: Alarm %1
 	Mode: Stacked
-	Sub Check: {alarm[%1] = (int)alarm[%1]; if ((alarm[%1] == -1) or (alarm[%1]--)) return 0; }
+	Sub Check: alarm.fire(%1)
+	Iterator-declare: /* Alarms are scheduled on the timer wheel */
+	Iterator-initialize: alarm.link(id);
+	Iterator-remove: alarm.unlink();
+	Iterator-delete: /* The wheel drops entries for instances that no longer exist */
+	Instead: enigma::alarm_wheel_advance(); while (enigma::object_basic *inst = enigma::alarm_wheel_next()) { enigma::temp_event_scope alarm_scope(inst); ((enigma::event_parent*)inst)->myevent_alarm(); } # Only alarms expiring this step are visited
 
 
 # Keyboard events. These are simple enough.
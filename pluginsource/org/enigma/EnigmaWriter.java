@@ -173,11 +173,13 @@ public final class EnigmaWriter
 		// o.packages = new StringArray(packages);
 
 		//extensions implemented separately. This is hard-coded legacy.
-		o.extensionCount = 1;
+		o.extensionCount = 2;
 		o.extensions = new Extension.ByReference();
 		Extension[] oix = (Extension[]) o.extensions.toArray(o.extensionCount);
 		oix[0].name = "Alarms";
 		oix[0].path = "Universal_System/Extensions";
+		oix[1].name = "Paths";
+		oix[1].path = "Universal_System/Extensions";
 
 		o.lastInstanceId = i.lastInstanceId;
 		o.lastTileId = i.lastTileId;